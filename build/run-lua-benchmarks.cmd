@@ -0,0 +1,5 @@
+pushd "bin/Release"
+
+Solr.exe "../../../src/lua-benchmarks/entry.lua"
+
+popd
@@ -0,0 +1,151 @@
+/*
+ * File system benchmarks: cold and warm start reading a whole asset directory as loose files vs from a pack
+ * (uncompressed and LZ4), synchronously and with all reads in flight at once (readBytesAsync). Cold runs evict the files from the OS page cache first, which is only done on Linux,
+ * elsewhere cold and warm runs are the same.
+ * Usage: FileSystemBenchmark [asset dir] [temp dir]
+ *
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+*/
+
+#include <SoloAsyncHandle.h>
+#include <SoloFileSystem.h>
+#include <SoloMappedFile.h>
+#include <SoloPackFile.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#ifdef __linux__
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace solo;
+using Clock = std::chrono::high_resolution_clock;
+
+static auto millisecondsSince(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void collectFiles(FileSystem *fs, const str &directory, vec<str> &files) {
+    for (const auto &file : fs->listFiles(directory))
+        files.push_back(file);
+    for (const auto &dir : fs->listDirectories(directory))
+        collectFiles(fs, dir, files);
+}
+
+static void evictFromPageCache(const vec<str> &paths) {
+#ifdef __linux__
+    for (const auto &path : paths) {
+        const auto fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            continue;
+        // Dirty pages can't be dropped, a freshly written pack has to reach the disk first
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+static volatile u64 consumedSum = 0;
+
+// Touches every page, like a loader consuming the whole file would
+static void consume(const MappedFile &file) {
+    u64 sum = 0;
+    for (size_t i = 0; i < file.size(); i += 4096)
+        sum += file.data()[i];
+    consumedSum += sum;
+}
+
+static void report(const s8 *label, u32 fileCount, u64 bytes, double coldMs, double warmMs) {
+    std::printf("%-30s %6u files %12llu bytes %10.2f ms cold %10.2f ms warm\n", label, fileCount,
+        static_cast<unsigned long long>(bytes), coldMs, warmMs);
+}
+
+// Opens a new file system each run, so that mounting the pack is part of the measured startup
+template <class Read>
+static void run(const s8 *label, const vec<str> &evicted, u32 fileCount, Read read) {
+    const u32 iterations = 5;
+    double coldMs = 0, warmMs = 0;
+    u64 bytes = 0;
+
+    for (u32 i = 0; i < iterations; i++) {
+        evictFromPageCache(evicted);
+        auto start = Clock::now();
+        bytes = read();
+        coldMs += millisecondsSince(start);
+
+        start = Clock::now();
+        read();
+        warmMs += millisecondsSince(start);
+    }
+
+    report(label, fileCount, bytes, coldMs / iterations, warmMs / iterations);
+}
+
+int main(int argc, s8 *argv[]) {
+    const str assetDir = argc > 1 ? argv[1] : "../../../assets";
+    const str tempDir = argc > 2 ? argv[2] : "../../../temp";
+    const auto fs = FileSystem::fromDevice(nullptr);
+    fs->createDirectory(tempDir);
+
+    vec<str> files;
+    collectFiles(fs.get(), assetDir, files);
+    const auto fileCount = static_cast<u32>(files.size());
+
+    const auto packPath = tempDir + "/assets.slpack";
+    const auto compressedPackPath = tempDir + "/assets.lz4.slpack";
+    PackFile::build(fs.get(), assetDir, packPath, false);
+    PackFile::build(fs.get(), assetDir, compressedPackPath, true);
+    std::printf("Pack sizes: %llu bytes uncompressed, %llu bytes LZ4\n",
+        static_cast<unsigned long long>(fs->map(packPath)->size()),
+        static_cast<unsigned long long>(fs->map(compressedPackPath)->size()));
+
+    run("loose, readBytes", files, fileCount, [&] {
+        u64 bytes = 0;
+        for (const auto &file : files)
+            bytes += fs->readBytes(file).size();
+        return bytes;
+    });
+
+    run("loose, map", files, fileCount, [&] {
+        u64 bytes = 0;
+        for (const auto &file : files) {
+            const auto mapped = fs->map(file);
+            consume(*mapped);
+            bytes += mapped->size();
+        }
+        return bytes;
+    });
+
+    // Handles resolve on the reader's thread, no main thread pumping is needed to wait for them
+    run("loose, readBytesAsync", files, fileCount, [&] {
+        vec<sptr<AsyncHandle<vec<u8>>>> handles;
+        for (const auto &file : files)
+            handles.push_back(fs->readBytesAsync(file));
+        u64 bytes = 0;
+        for (const auto &handle : handles) {
+            while (handle->isPending())
+                std::this_thread::yield();
+            bytes += handle->result()->size();
+        }
+        return bytes;
+    });
+
+    for (const auto &pack : {packPath, compressedPackPath}) {
+        run(pack == packPath ? "pack, map" : "pack LZ4, map", {pack}, fileCount, [&] {
+            const auto packed = FileSystem::fromDevice(nullptr);
+            packed->mountPack(pack, assetDir);
+            u64 bytes = 0;
+            for (const auto &file : files) {
+                const auto mapped = packed->map(file);
+                consume(*mapped);
+                bytes += mapped->size();
+            }
+            return bytes;
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Hot reload benchmarks: how long it takes FileWatcher to report a changed file, with files saved in place and
+ * the way many editors do it (write a temp file, rename it over the original), one at a time and several at once.
+ * Windows and Linux are notified of changes, elsewhere the watcher polls, which adds up to a poll interval.
+ * Then the whole edit-to-reload latency of an effect, from saving its description to the regenerated and compiled
+ * effect being swapped in by HotReload, against the 100 ms target. Needs a renderer, so not on Linux. No result
+ * for it has been recorded yet, so whether the target is met is unknown until this runs on Windows or macOS.
+ * Usage: HotReloadBenchmark [asset dir] [temp dir]
+ *
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+*/
+
+#include <Solo.h>
+#include <SoloFileWatcher.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace solo;
+using Clock = std::chrono::steady_clock;
+
+static auto millisecondsSince(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Until the watcher reports all the files, -1 if it doesn't within a second
+template <class Save>
+static auto measure(FileWatcher *watcher, u32 fileCount, Save save) -> double {
+    const auto start = Clock::now();
+    save();
+
+    u32 reported = 0;
+    while (millisecondsSince(start) < 1000) {
+        for (const auto &batch : watcher->takeBatches())
+            reported += static_cast<u32>(batch.paths.size());
+        if (reported >= fileCount)
+            return millisecondsSince(start);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return -1;
+}
+
+template <class Save>
+static void run(const s8 *label, FileWatcher *watcher, u32 fileCount, Save save) {
+    const u32 iterations = 20;
+    double total = 0, worst = 0;
+    for (u32 i = 0; i < iterations; i++) {
+        const auto ms = measure(watcher, fileCount, save);
+        if (ms < 0) {
+            std::printf("%-30s changes not reported\n", label);
+            return;
+        }
+        total += ms;
+        worst = (std::max)(worst, ms);
+    }
+    std::printf("%-30s %3u files %10.2f ms average %10.2f ms worst\n", label, fileCount, total / iterations, worst);
+}
+
+// Edits an effect description over and over, pumping frames until each edit gets swapped in
+static void runEffectReload(const str &assetDir, const str &tempDir) {
+#if defined(SL_OPENGL_RENDERER) || defined(SL_VULKAN_RENDERER)
+    DeviceSetup setup;
+#ifdef SL_OPENGL_RENDERER
+    setup.mode = DeviceMode::OpenGL;
+#else
+    setup.mode = DeviceMode::Vulkan;
+#endif
+    setup.canvasWidth = 100;
+    setup.canvasHeight = 100;
+    setup.windowTitle = "HotReloadBenchmark";
+    const auto device = Device::create(setup);
+    const auto fs = device->fileSystem();
+
+    // Driven by hand rather than through DeviceSetup::hotReload, which needs a build with SL_HOT_RELOAD
+    const auto hotReload = HotReload::fromDevice(device.get());
+
+    const auto description = fs->readText(assetDir + "/effects/test.lua");
+    const auto path = tempDir + "/hot-reload-effect.lua";
+    fs->writeBytes(path, vec<u8>(description.begin(), description.end()));
+    const auto effect = Effect::fromDescriptionFile(device.get(), path);
+    hotReload->trackEffect(effect, path);
+
+    const u32 iterations = 10;
+    double total = 0, worst = 0;
+    for (u32 i = 0; i < iterations; i++) {
+        const auto revision = effect->revision();
+        const auto edited = "-- edit " + std::to_string(i) + "\n" + description;
+
+        const auto start = Clock::now();
+        fs->writeBytes(path, vec<u8>(edited.begin(), edited.end()));
+        while (effect->revision() == revision && millisecondsSince(start) < 2000) {
+            device->update([] {});
+            hotReload->update();
+        }
+
+        if (effect->revision() == revision) {
+            std::printf("%-30s edit not reloaded\n", "effect reload");
+            return;
+        }
+        const auto ms = millisecondsSince(start);
+        total += ms;
+        worst = (std::max)(worst, ms);
+    }
+
+    std::printf("%-30s %10.2f ms average %10.2f ms worst, %.2f ms from the first change, target 100 ms %s\n", "effect reload",
+        total / iterations, worst, hotReload->lastReloadMs(), worst < 100 ? "met" : "missed");
+#else
+    (void)assetDir;
+    (void)tempDir;
+    std::printf("%-30s no renderer on this platform, the 100 ms target is not measured\n", "effect reload");
+#endif
+}
+
+int main(int argc, s8 *argv[]) {
+    const str assetDir = argc > 1 ? argv[1] : "../../../assets";
+    const str tempDir = argc > 2 ? argv[2] : "../../../temp";
+    const auto fs = FileSystem::fromDevice(nullptr);
+    fs->createDirectory(tempDir);
+
+    const auto watcher = FileWatcher::create();
+    watcher->watchDirectory(tempDir);
+
+    const vec<u8> contents(16 * 1024, 1);
+    const auto path = [&](u32 i) { return tempDir + "/hot-reload-" + std::to_string(i) + ".lua"; };
+
+    run("in place", watcher.get(), 1, [&] {
+        fs->writeBytes(path(0), contents);
+    });
+
+    run("temp file + rename", watcher.get(), 1, [&] {
+        fs->writeBytes(path(0) + ".tmp", contents);
+        std::rename((path(0) + ".tmp").c_str(), path(0).c_str());
+    });
+
+    run("in place, together", watcher.get(), 8, [&] {
+        for (u32 i = 0; i < 8; i++)
+            fs->writeBytes(path(i), contents);
+    });
+
+    runEffectReload(assetDir, tempDir);
+
+    return 0;
+}
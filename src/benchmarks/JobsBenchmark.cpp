@@ -0,0 +1,309 @@
+/*
+ * Job system benchmarks: throughput for tiny tasks, latency for asset-sized jobs, data-parallel scaling, lock contention.
+ *
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+*/
+
+#include <SoloJobPool.h>
+#include <SoloAsyncHandle.h>
+#include <SoloThreadPool.h>
+#include <SoloAdaptiveLock.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <mutex>
+
+using namespace solo;
+using Clock = std::chrono::high_resolution_clock;
+
+static auto millisecondsSince(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void waitUntil(const std::atomic<u32> &counter, u32 value) {
+    while (counter.load(std::memory_order_acquire) < value)
+        std::this_thread::yield();
+}
+
+static void report(const s8 *name, u32 taskCount, double ms) {
+    std::printf("%-40s %10u tasks %10.2f ms %12.0f tasks/s\n", name, taskCount, ms, taskCount / (ms / 1000.0));
+}
+
+static void tinyTasksFromMainThread(ThreadPool &pool, u32 taskCount) {
+    std::atomic<u32> counter{0};
+    const auto start = Clock::now();
+    for (u32 i = 0; i < taskCount; i++)
+        pool.submit([&counter] { counter.fetch_add(1, std::memory_order_release); });
+    waitUntil(counter, taskCount);
+    report("tiny tasks, submitted from main thread", taskCount, millisecondsSince(start));
+}
+
+static void tinyTasksFanOut(ThreadPool &pool, u32 rootCount, u32 childCount) {
+    // Children are pushed to the worker's own deque, so idle workers have to steal them
+    std::atomic<u32> counter{0};
+    const auto start = Clock::now();
+    for (u32 i = 0; i < rootCount; i++) {
+        pool.submit([&pool, &counter, childCount] {
+            for (u32 j = 0; j < childCount; j++)
+                pool.submit([&counter] { counter.fetch_add(1, std::memory_order_release); });
+        });
+    }
+    waitUntil(counter, rootCount * childCount);
+    report("tiny tasks, fanned out from workers", rootCount * childCount, millisecondsSince(start));
+}
+
+static void tinyTasksStdAsync(u32 taskCount) {
+    std::atomic<u32> counter{0};
+    vec<std::future<void>> futures;
+    futures.reserve(taskCount);
+    const auto start = Clock::now();
+    for (u32 i = 0; i < taskCount; i++)
+        futures.push_back(std::async(std::launch::async, [&counter] { counter.fetch_add(1); }));
+    for (auto &f : futures)
+        f.wait();
+    report("tiny tasks, std::async (reference)", taskCount, millisecondsSince(start));
+}
+
+// Roughly what decoding a small texture or parsing a mesh costs
+static auto simulateAssetWork(u32 bytes) -> u64 {
+    vec<u8> data(bytes);
+    u64 hash = 1469598103934665603ull;
+    for (u32 pass = 0; pass < 4; pass++) {
+        for (u32 i = 0; i < bytes; i++) {
+            data[i] = static_cast<u8>(hash);
+            hash = (hash ^ data[i] ^ i) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static void assetJobsLatency(u32 jobCount, u32 bytesPerJob) {
+    JobPool jobPool;
+    vec<double> latencies;
+    latencies.reserve(jobCount);
+
+    const auto start = Clock::now();
+    for (u32 i = 0; i < jobCount; i++) {
+        const auto submitted = Clock::now();
+        auto producers = JobBase<u64>::Producers{
+            [bytesPerJob] { return std::make_shared<u64>(simulateAssetWork(bytesPerJob)); }
+        };
+        auto consumer = [submitted, &latencies](const vec<sptr<u64>> &, const vec<std::exception_ptr> &) {
+            latencies.push_back(millisecondsSince(submitted));
+        };
+        jobPool.addJob(std::make_shared<JobBase<u64>>(producers, consumer));
+    }
+
+    // Completions are only observed on "frames", like Device::update does
+    while (latencies.size() < jobCount) {
+        jobPool.update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto totalMs = millisecondsSince(start);
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    std::printf("%-40s %10u jobs  %10.2f ms   p50 %.2f ms, p95 %.2f ms, max %.2f ms\n",
+        "asset-sized jobs via JobPool", jobCount, totalMs, percentile(0.5), percentile(0.95), latencies.back());
+}
+
+// Thousands of loads in flight at once: update() must stay cheap while nothing finishes
+// and scale with the number of completions once they do
+static void completionContention(u32 jobCount) {
+    JobPool jobPool(2);
+
+    // Park both workers so that every job stays queued until we let them go
+    std::atomic<bool> gate{false};
+    for (u32 i = 0; i < jobPool.threadPool()->workerCount(); i++) {
+        jobPool.threadPool()->submit([&gate] {
+            while (!gate)
+                std::this_thread::yield();
+        });
+    }
+
+    u32 completed = 0;
+    for (u32 i = 0; i < jobCount; i++) {
+        auto producers = JobBase<u64>::Producers{
+            [] { return std::make_shared<u64>(simulateAssetWork(1 << 10)); }
+        };
+        auto consumer = [&completed](const vec<sptr<u64>> &, const vec<std::exception_ptr> &) { completed++; };
+        jobPool.addJob(std::make_shared<JobBase<u64>>(producers, consumer));
+    }
+
+    const u32 idleUpdates = 1000;
+    auto start = Clock::now();
+    for (u32 i = 0; i < idleUpdates; i++)
+        jobPool.update();
+    const auto idleUs = millisecondsSince(start) * 1000 / idleUpdates;
+
+    gate = true;
+    u32 updates = 0;
+    double updateMs = 0;
+    while (completed < jobCount) {
+        start = Clock::now();
+        jobPool.update();
+        updateMs += millisecondsSince(start);
+        updates++;
+    }
+
+    std::printf("%-40s %10u jobs  idle update %.3f us, %u draining updates, %.3f us per completion\n",
+        "completions with jobs in flight", jobCount, idleUs, updates, updateMs * 1000 / jobCount);
+}
+
+// A batch of finished loads whose main-thread part (GPU upload) costs ~1 ms each
+static void completionBudget(float budget, u32 jobCount) {
+    JobPool jobPool;
+    jobPool.setMainThreadBudget(budget);
+
+    u32 completed = 0;
+    for (u32 i = 0; i < jobCount; i++) {
+        jobPool.schedule(JobThread::Main, [&completed] {
+            const auto start = Clock::now();
+            while (millisecondsSince(start) < 1) {}
+            completed++;
+        });
+    }
+
+    u32 frames = 0;
+    double worstFrameMs = 0;
+    while (completed < jobCount) {
+        const auto start = Clock::now();
+        jobPool.update();
+        worstFrameMs = std::max(worstFrameMs, millisecondsSince(start));
+        frames++;
+    }
+
+    std::printf("%-40s %10u jobs  budget %.1f ms: %u frames, worst frame %.2f ms, %u overruns\n",
+        "main thread completions", jobCount, budget, frames, worstFrameMs, jobPool.stats().budgetOverruns);
+}
+
+// A "level load": every asset decoded on workers, uploaded on the main thread, all joined into one handle
+static void assetGraph(u32 assetCount, u32 bytesPerAsset) {
+    JobPool jobPool;
+    vec<sptr<AsyncHandleBase>> assets;
+
+    const auto start = Clock::now();
+    for (u32 i = 0; i < assetCount; i++) {
+        const auto decode = [bytesPerAsset] { return std::make_shared<u64>(simulateAssetWork(bytesPerAsset)); };
+        assets.push_back(AsyncHandle<u64>::run(&jobPool, JobThread::Worker, decode)->then(JobThread::Main,
+        [](sptr<u64> hash) {
+            return std::make_shared<u64>(*hash + 1);
+        }));
+    }
+
+    auto loaded = false;
+    whenAll(&jobPool, assets)->done([&loaded](sptr<vec<sptr<AsyncHandleBase>>>) { loaded = true; });
+    while (!loaded) {
+        jobPool.update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::printf("%-40s %10u jobs  %10.2f ms\n", "asset graph joined with whenAll", assetCount, millisecondsSince(start));
+}
+
+static void dataParallelScaling(u32 itemCount) {
+    vec<float> items(itemCount);
+    double baseForMs = 0, baseReduceMs = 0;
+
+    for (u32 workers = 1; workers <= 32; workers *= 2) {
+        JobPool jobPool(workers);
+
+        auto start = Clock::now();
+        jobPool.parallelFor(0, itemCount, 0, [&items](u32 begin, u32 end) {
+            for (auto i = begin; i < end; i++)
+                items[i] = std::sqrt(static_cast<float>(i)) * std::sin(static_cast<float>(i));
+        });
+        const auto forMs = millisecondsSince(start);
+
+        start = Clock::now();
+        const auto sum = jobPool.parallelReduce<double>(0, itemCount, 0, 0,
+            [&items](u32 begin, u32 end, double acc) {
+                for (auto i = begin; i < end; i++)
+                    acc += items[i];
+                return acc;
+            },
+            [](double a, double b) { return a + b; });
+        const auto reduceMs = millisecondsSince(start);
+
+        if (workers == 1) {
+            baseForMs = forMs;
+            baseReduceMs = reduceMs;
+        }
+
+        std::printf("parallelFor/Reduce, %2u workers %10.2f ms (x%.2f) %10.2f ms (x%.2f)   sum %.1f\n",
+            workers, forMs, baseForMs / forMs, reduceMs, baseReduceMs / reduceMs, sum);
+    }
+}
+
+// What SpinLock used to do, kept as a reference point
+class NaiveSpinLock {
+public:
+    void lock() {
+        while (flag_.test_and_set(std::memory_order_acquire)) {}
+    }
+
+    void unlock() {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+template <class Lock>
+static auto lockContention(Lock &lock, u32 threadCount, u32 iterations) -> double {
+    u64 counter = 0;
+    vec<std::thread> threads;
+    const auto start = Clock::now();
+    for (u32 t = 0; t < threadCount; t++) {
+        threads.emplace_back([&lock, &counter, iterations] {
+            for (u32 i = 0; i < iterations; i++) {
+                std::lock_guard<Lock> guard(lock);
+                counter++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    return millisecondsSince(start);
+}
+
+static void locks(u32 iterations) {
+    for (u32 threads = 1; threads <= 16; threads *= 2) {
+        NaiveSpinLock spinLock;
+        std::mutex mutex;
+        AdaptiveLock adaptiveLock(true);
+        const auto spinMs = lockContention(spinLock, threads, iterations);
+        const auto mutexMs = lockContention(mutex, threads, iterations);
+        const auto adaptiveMs = lockContention(adaptiveLock, threads, iterations);
+        const auto stats = adaptiveLock.stats();
+        std::printf("locks, %2u threads: spin %8.2f ms, std::mutex %8.2f ms, adaptive %8.2f ms (%llu of %llu contended, %.2f ms waiting)\n",
+            threads, spinMs, mutexMs, adaptiveMs,
+            static_cast<unsigned long long>(stats.contendedAcquisitions), static_cast<unsigned long long>(stats.acquisitions), stats.waitTime);
+    }
+}
+
+int main() {
+    {
+        ThreadPool pool;
+        std::printf("Workers: %u\n", pool.workerCount());
+        tinyTasksFromMainThread(pool, 1000000);
+        tinyTasksFanOut(pool, 64, 16384);
+    }
+
+    tinyTasksStdAsync(10000);
+    assetJobsLatency(256, 1 << 20);
+    completionContention(8192);
+    completionBudget(0, 100);
+    completionBudget(4, 100);
+    assetGraph(256, 1 << 20);
+    dataParallelScaling(1 << 24);
+    locks(100000);
+
+    return 0;
+}
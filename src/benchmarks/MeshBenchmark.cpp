@@ -0,0 +1,132 @@
+/*
+ * Mesh import benchmarks: time and heap allocations per MeshData load, source formats vs the binary format,
+ * float vs compact vertex formats, and how much GPU memory the vertices and indices would take.
+ * Also reports what import-time optimization does to vertex counts and post-transform cache efficiency (ACMR),
+ * and how much CPU memory meshes of the demo scenes keep after loading.
+ * Usage: MeshBenchmark [asset dir] [temp dir]
+ *
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+*/
+
+#include <SoloMeshData.h>
+#include <SoloFileSystem.h>
+#include <SoloJobPool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace solo;
+using Clock = std::chrono::high_resolution_clock;
+
+static std::atomic<u64> allocationCount{0};
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (const auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+static auto millisecondsSince(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Same rule as Mesh::setIndexBuffer: 16-bit indices unless some index doesn't fit
+static auto indexBytes(const MeshData &data) -> u64 {
+    const auto indices = data.indexData();
+    const auto wide = std::any_of(indices, indices + data.indexCount(), [](u32 i) { return i >= 0xffff; });
+    return static_cast<u64>(data.indexCount()) * (wide ? 4 : 2);
+}
+
+static void reportOptimization(const str &path, const MeshData &data) {
+    u32 importedVertexCount = 0, vertexCount = 0;
+    double importedMisses = 0, misses = 0, triangleCount = 0;
+    for (u32 i = 0; i < data.partCount(); i++) {
+        const auto &stats = data.partStats()[i];
+        const auto triangles = data.part(i).indexCount / 3.0;
+        importedVertexCount += stats.importedVertexCount;
+        vertexCount += stats.vertexCount;
+        importedMisses += stats.importedAcmr * triangles;
+        misses += stats.acmr * triangles;
+        triangleCount += triangles;
+    }
+
+    std::printf("%-50s %u parts, %8u -> %8u vertices, ACMR %.3f -> %.3f\n", path.c_str(), data.partCount(),
+        importedVertexCount, vertexCount, importedMisses / triangleCount, misses / triangleCount);
+}
+
+// A Mesh used to copy its MeshData, holding both copies during the load and its own one afterwards.
+// Now it shares the MeshData as its CPU copy (MeshCpuData::Keep) or lets it go once uploaded (MeshCpuData::Release).
+static void reportCpuCopies(FileSystem *fs, const str &assetDir, const VertexBufferLayout &layout) {
+    u64 total = 0;
+    for (const auto name : {"backdrop.obj", "teapot.obj", "house.obj", "box.dae", "quad.dae", "axes.obj"}) {
+        const auto path = assetDir + "/meshes/" + name;
+        const auto data = MeshData::fromFile(fs, path, layout);
+        const auto bytes = data->vertexDataSize() + static_cast<u64>(data->indexCount()) * sizeof(u32);
+        total += bytes;
+        std::printf("%-50s CPU copy %10llu bytes\n", path.c_str(), static_cast<unsigned long long>(bytes));
+    }
+
+    const auto t = static_cast<unsigned long long>(total);
+    std::printf("Demo meshes: peak while loading %llu -> %llu bytes, kept after loading %llu -> %llu (Keep) or 0 (Release) bytes\n",
+        2 * t, t, t, t);
+}
+
+static void load(FileSystem *fs, JobPool *jobPool, const str &path, const VertexBufferLayout &layout, const s8 *label) {
+    const u32 iterations = 10;
+    sptr<MeshData> data;
+
+    const auto allocationsBefore = allocationCount.load();
+    const auto start = Clock::now();
+    for (u32 i = 0; i < iterations; i++)
+        data = MeshData::fromFile(fs, path, layout, jobPool);
+    const auto ms = millisecondsSince(start) / iterations;
+    const auto allocations = (allocationCount.load() - allocationsBefore) / iterations;
+
+    std::printf("%-50s %-20s %8u vertices %10.2f ms %10llu allocations %10llu vertex bytes %10llu index bytes\n",
+        path.c_str(), label, data->vertexCount(), ms, static_cast<unsigned long long>(allocations),
+        static_cast<unsigned long long>(data->vertexDataSize()), static_cast<unsigned long long>(indexBytes(*data)));
+}
+
+int main(int argc, s8 *argv[]) {
+    const str assetDir = argc > 1 ? argv[1] : "../../../assets";
+    const str tempDir = argc > 2 ? argv[2] : "../../../temp";
+    const auto fs = FileSystem::fromDevice(nullptr);
+    fs->createDirectory(tempDir);
+    JobPool jobPool;
+
+    VertexBufferLayout layout;
+    layout.addAttribute(VertexAttributeUsage::Position);
+    layout.addAttribute(VertexAttributeUsage::Normal);
+    layout.addAttribute(VertexAttributeUsage::TexCoord);
+    layout.addAttribute(VertexAttributeUsage::Tangent);
+    const auto compactLayout = layout.toCompact();
+    std::printf("Vertex size: %u bytes float, %u bytes compact\n", layout.size(), compactLayout.size());
+    reportCpuCopies(fs.get(), assetDir, compactLayout);
+
+    for (const auto name : {"teapot.obj", "house.obj", "axes.obj", "box.dae"}) {
+        const auto path = assetDir + "/meshes/" + name;
+        reportOptimization(path, *MeshData::fromFile(fs.get(), path, layout));
+        load(fs.get(), nullptr, path, layout, "source");
+        load(fs.get(), &jobPool, path, layout, "source, jobs");
+        load(fs.get(), nullptr, path, compactLayout, "source, compact");
+
+        const auto binaryPath = tempDir + "/" + name + ".slmesh";
+        MeshData::fromFile(fs.get(), path, layout)->saveBinary(fs.get(), binaryPath);
+        load(fs.get(), nullptr, binaryPath, layout, "binary");
+
+        const auto compactBinaryPath = tempDir + "/" + name + ".compact.slmesh";
+        MeshData::fromFile(fs.get(), path, compactLayout)->saveBinary(fs.get(), compactBinaryPath);
+        load(fs.get(), nullptr, compactBinaryPath, compactLayout, "binary, compact");
+    }
+
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * SoloCook - offline asset cooker. Converts meshes, textures and effect descriptions from an asset
+ * directory into runtime formats and writes a manifest that Device picks up via DeviceSetup::cookedAssetsPath.
+ * With --pack also packs the asset directory, cooked outputs included when they are in it, into one file
+ * for FileSystem::mountPack (entries compressed unless --pack-raw is given).
+ * Assets are recooked when their source changes, and OBJ meshes also when their material libraries do. Lua modules
+ * that effect descriptions require are not tracked, run with --force after editing them.
+ * Usage: SoloCook <asset dir> <output dir> [--force] [--pack <pack file>] [--pack-raw]
+ *
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+*/
+
+#include <Solo.h>
+#include <SoloEffectCache.h>
+#include <SoloHash.h>
+#include <SoloPackFile.h>
+#include <stb/SoloSTBTextureData.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+
+using namespace solo;
+using Clock = std::chrono::high_resolution_clock;
+
+// Bump when a cooked format or the way it is produced changes, so that everything gets recooked
+static const str cookVersion = "3";
+
+enum class TaskKind {
+    Mesh,
+    Texture,
+    Effect
+};
+
+struct Task {
+    TaskKind kind;
+    str source; // relative to the asset directory
+    str variant;
+    DeviceMode mode;
+    str output; // relative to the output directory
+};
+
+static bool hasExtension(const str &path, const s8 *ext) {
+    const auto len = std::strlen(ext);
+    if (path.size() < len)
+        return false;
+    auto tail = path.substr(path.size() - len);
+    std::transform(tail.begin(), tail.end(), tail.begin(), ::tolower);
+    return tail == ext;
+}
+
+static bool isMesh(const str &path) {
+    return hasExtension(path, ".obj") || hasExtension(path, ".dae") || hasExtension(path, ".fbx") || hasExtension(path, ".3ds");
+}
+
+static void collectFiles(FileSystem *fs, const str &directory, const str &skipDirectory, vec<str> &files) {
+    for (const auto &file : fs->listFiles(directory))
+        files.push_back(file);
+    for (const auto &dir : fs->listDirectories(directory)) {
+        if (dir != skipDirectory)
+            collectFiles(fs, dir, skipDirectory, files);
+    }
+}
+
+static void createDirectories(FileSystem *fs, const str &path) {
+    size_t pos = 0;
+    while ((pos = path.find('/', pos + 1)) != str::npos)
+        fs->createDirectory(path.substr(0, pos));
+}
+
+static auto collectTasks(const vec<str> &files, const str &assetDir) -> vec<Task> {
+    const DeviceMode modes[] = {DeviceMode::OpenGL, DeviceMode::Vulkan};
+    vec<Task> tasks;
+
+    for (const auto &file : files) {
+        const auto rel = file.substr(assetDir.size() + 1);
+        if (isMesh(rel))
+            tasks.push_back({TaskKind::Mesh, rel, "", DeviceMode::OpenGL, rel + ".slmesh"});
+        else if (STBTexture2DData::canLoadFromFile(rel)) {
+            for (const auto mode : modes) {
+                const auto variant = CookedAssets::variantFor(mode);
+                tasks.push_back({TaskKind::Texture, rel, variant, mode, rel + "." + variant + ".sltex"});
+            }
+        } else if (hasExtension(rel, ".lua")) {
+            for (const auto mode : modes) {
+                const auto variant = CookedAssets::variantFor(mode);
+                tasks.push_back({TaskKind::Effect, rel, variant, mode, rel + "." + variant + ".effect"});
+            }
+        }
+    }
+
+    return tasks;
+}
+
+// Paths of the `mtllib` files an OBJ mesh refers to, relative to its directory
+static auto objMaterialLibraries(const str &sourcePath, const vec<u8> &sourceBytes) -> vec<str> {
+    const auto directory = sourcePath.substr(0, sourcePath.find_last_of('/') + 1);
+    vec<str> result;
+    std::istringstream lines(str(sourceBytes.begin(), sourceBytes.end()));
+    str line;
+    while (std::getline(lines, line)) {
+        std::istringstream words(line);
+        str keyword, name;
+        words >> keyword;
+        if (keyword != "mtllib")
+            continue;
+        while (words >> name)
+            result.push_back(directory + name);
+    }
+    return result;
+}
+
+// Covers the source and the side files that go into the output with it, a missing side file counts too
+static auto taskHash(FileSystem *fs, const Task &task, const str &sourcePath) -> u64 {
+    const auto seed = hashString(cookVersion + "/" + std::to_string(static_cast<u32>(task.kind)) + "/" + task.variant);
+    const auto sourceBytes = fs->readBytes(sourcePath);
+    auto hash = hashBytes(sourceBytes.data(), sourceBytes.size(), seed);
+
+    if (task.kind == TaskKind::Mesh && hasExtension(task.source, ".obj")) {
+        for (const auto &dependency : objMaterialLibraries(sourcePath, sourceBytes)) {
+            hash = hashString(dependency, hash);
+            if (fs->exists(dependency)) {
+                const auto bytes = fs->readBytes(dependency);
+                hash = hashBytes(bytes.data(), bytes.size(), hash);
+            }
+        }
+    }
+
+    return hash;
+}
+
+static void cook(FileSystem *fs, EffectCache *effectCache, const Task &task, const str &sourcePath, const str &outputPath) {
+    switch (task.kind) {
+        case TaskKind::Mesh: {
+            // Full layout, runtime picks the attributes it needs from it. Compact, so that meshes loaded with
+            // a compact layout (layout.toCompact()) asking for all of these attributes load without conversion
+            VertexBufferLayout layout;
+            layout.addAttribute(VertexAttributeUsage::Position);
+            layout.addAttribute(VertexAttributeUsage::Normal);
+            layout.addAttribute(VertexAttributeUsage::TexCoord);
+            layout.addAttribute(VertexAttributeUsage::Tangent);
+            layout.addAttribute(VertexAttributeUsage::Binormal);
+            const auto data = MeshData::fromFile(fs, sourcePath, layout.toCompact());
+            data->saveBinary(fs, outputPath);
+
+            u32 importedVertexCount = 0, vertexCount = 0;
+            for (const auto &stats : data->partStats()) {
+                importedVertexCount += stats.importedVertexCount;
+                vertexCount += stats.vertexCount;
+            }
+            Logger::global().logInfo(fmt(task.source, ": ", importedVertexCount, " -> ", vertexCount, " vertices"));
+            for (u32 i = 0; i < data->partCount(); i++) {
+                const auto &stats = data->partStats()[i];
+                Logger::global().logInfo(fmt("    part ", i, ": ", stats.importedVertexCount, " -> ", stats.vertexCount,
+                    " vertices, ACMR ", stats.importedAcmr, " -> ", stats.acmr));
+            }
+            break;
+        }
+
+        case TaskKind::Texture: {
+            const auto data = STBTexture2DData::fromFile(fs, sourcePath, task.mode == DeviceMode::OpenGL);
+            Texture2DData::withMipChain(data)->saveBinary(fs, outputPath);
+            break;
+        }
+
+        case TaskKind::Effect: {
+            const auto desc = fs->readText(sourcePath);
+            const auto mode = task.mode == DeviceMode::Vulkan ? "sl.DeviceMode.Vulkan" : "sl.DeviceMode.OpenGL";
+            const auto source = ScriptRuntime::empty()->eval("sl.generateEffectSource(" + desc + ", " + mode + ")");
+            Effect::precompile(effectCache, task.mode, source);
+            fs->writeBytes(outputPath, vec<u8>(source.begin(), source.end()));
+            break;
+        }
+    }
+}
+
+int main(int argc, s8 *argv[]) {
+    if (argc < 3) {
+        std::printf("Usage: SoloCook <asset dir> <output dir> [--force] [--pack <pack file>] [--pack-raw]\n");
+        return 1;
+    }
+
+    const str assetDir = argv[1];
+    const str outputDir = argv[2];
+    auto force = false, compressPack = true;
+    str packPath;
+    for (auto i = 3; i < argc; i++) {
+        const str arg = argv[i];
+        if (arg == "--force")
+            force = true;
+        else if (arg == "--pack" && i + 1 < argc)
+            packPath = argv[++i];
+        else if (arg == "--pack-raw")
+            compressPack = false;
+    }
+
+    try {
+        const auto start = Clock::now();
+        const auto fs = FileSystem::fromDevice(nullptr);
+
+        createDirectories(fs.get(), outputDir + "/");
+        createDirectories(fs.get(), outputDir + "/" + CookedAssets::effectCacheDirectory + "/");
+
+        CookedAssets manifest(fs.get(), outputDir);
+        EffectCache effectCache(fs.get(), outputDir + "/" + CookedAssets::effectCacheDirectory);
+
+        vec<str> files;
+        collectFiles(fs.get(), assetDir, outputDir, files);
+        const auto tasks = collectTasks(files, assetDir);
+
+        // Worker jobs only write files, the directory tree is created up front
+        for (const auto &task : tasks)
+            createDirectories(fs.get(), outputDir + "/" + task.output);
+
+        vec<CookedAssets::Entry> entries(tasks.size());
+        vec<u8> succeeded(tasks.size(), 0);
+        std::atomic<u32> cooked{0}, upToDate{0};
+        std::mutex logMutex;
+
+        JobPool jobPool;
+        jobPool.parallelFor(0, static_cast<u32>(tasks.size()), 1, [&](u32 begin, u32 end) {
+            for (auto i = begin; i < end; i++) {
+                const auto &task = tasks[i];
+                const auto sourcePath = assetDir + "/" + task.source;
+                const auto outputPath = outputDir + "/" + task.output;
+
+                // Loaders throw AssetError for sources that can't be read, imported, decoded or compiled
+                try {
+                    const auto hash = taskHash(fs.get(), task, sourcePath);
+                    entries[i] = {task.source, task.variant, hash, task.output};
+
+                    const auto existing = manifest.entry(task.source, task.variant);
+                    if (!force && existing && existing->hash == hash && existing->output == task.output && fs->exists(outputPath))
+                        upToDate++;
+                    else {
+                        cook(fs.get(), &effectCache, task, sourcePath, outputPath);
+                        cooked++;
+                    }
+                    succeeded[i] = 1;
+                } catch (const std::exception &e) {
+                    std::lock_guard<std::mutex> lock(logMutex);
+                    Logger::global().logError(fmt("Failed to cook ", task.source, " (", task.variant.empty() ? "any" : task.variant, "): ", e.what()));
+                }
+            }
+        });
+
+        vec<CookedAssets::Entry> manifestEntries;
+        for (size_t i = 0; i < tasks.size(); i++) {
+            if (succeeded[i])
+                manifestEntries.push_back(entries[i]);
+        }
+        manifest.setEntries(manifestEntries);
+        manifest.save();
+
+        const auto failed = static_cast<u32>(tasks.size() - manifestEntries.size());
+        const auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::printf("Cooked %u, up to date %u, failed %u in %.2f ms\n", cooked.load(), upToDate.load(), failed, ms);
+
+        if (!packPath.empty()) {
+            PackFile::build(fs.get(), assetDir, packPath, compressPack);
+            std::printf("Packed %s into %s\n", assetDir.c_str(), packPath.c_str());
+        }
+
+        return failed > 0 ? 3 : 0;
+    } catch (const std::exception &e) {
+        Logger::global().logCritical(e.what());
+        return 2;
+    }
+}
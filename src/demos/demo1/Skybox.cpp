@@ -7,7 +7,7 @@ auto createSkybox(Device *device, Scene *scene) -> MeshRenderer *{
     layout.addAttribute(VertexAttributeUsage::Position);
     layout.addAttribute(VertexAttributeUsage::Normal);
     layout.addAttribute(VertexAttributeUsage::TexCoord);
-    const auto mesh = Mesh::fromFile(device, "../../../assets/meshes/quad.dae", layout);
+    const auto mesh = Mesh::fromFile(device, "../../../assets/meshes/quad.dae", layout, MeshCpuData::Release);
 
     // TODO move lua effect files elsewhere?
     const auto effect = Effect::fromDescriptionFile(device, "../../../assets/effects/skybox.lua");
@@ -12,6 +12,13 @@ local function loadTexture(path)
     return tex
 end
 
+-- Nothing reads these meshes back on the CPU, and their texture coordinates don't need full float precision
+local function loadMesh(path, layout)
+    local mesh = sl.Mesh.fromFile(sl.device, assetPath(path), layout:toCompact())
+    mesh:setCpuData(sl.MeshCpuData.Release)
+    return mesh
+end
+
 local function getOrAdd(key, factory)
     if not cache[key] then
         cache[key] = factory()
@@ -37,7 +44,7 @@ return {
                 layout:addAttribute(sl.VertexAttributeUsage.Normal)
                 layout:addAttribute(sl.VertexAttributeUsage.TexCoord)
                 layout:addAttribute(sl.VertexAttributeUsage.Tangent)
-                return sl.Mesh.fromFile(sl.device, assetPath('meshes/box.dae'), layout)
+                return loadMesh('meshes/box.dae', layout)
             end)
         end,
 
@@ -47,7 +54,7 @@ return {
                 layout:addAttribute(sl.VertexAttributeUsage.Position)
                 layout:addAttribute(sl.VertexAttributeUsage.Normal)
                 layout:addAttribute(sl.VertexAttributeUsage.TexCoord)
-                return sl.Mesh.fromFile(sl.device, assetPath('meshes/quad.dae'), layout)
+                return loadMesh('meshes/quad.dae', layout)
             end)
         end,
 
@@ -55,7 +62,7 @@ return {
             return getOrAdd('axes', function()
                 local layout = sl.VertexBufferLayout()
                 layout:addAttribute(sl.VertexAttributeUsage.Position)
-                return sl.Mesh.fromFile(sl.device, assetPath('meshes/axes.obj'), layout)
+                return loadMesh('meshes/axes.obj', layout)
             end)
         end
     },
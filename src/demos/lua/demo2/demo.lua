@@ -175,6 +175,7 @@ function demo()
         layout:addAttribute(sl.VertexAttributeUsage.Tangent)
         sl.Mesh.fromFileAsync(dev, assetPath('meshes/Teapot.obj'), layout):done(
             function(mesh)
+                mesh:setCpuData(sl.MeshCpuData.Release)
                 renderer:setMesh(mesh)
             end)
 
@@ -9,5 +9,6 @@ setup.canvasWidth = 1600
 setup.canvasHeight = 900
 setup.fullScreen = false
 setup.vsync = true
+setup.effectCachePath = '../../../temp/effect-cache'
 
 entry = "../../../src/demos/lua/demo2/demo.lua"
\ No newline at end of file
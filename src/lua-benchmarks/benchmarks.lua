@@ -0,0 +1,30 @@
+sl.includeDir("../../../src/lua-benchmarks")
+sl.includeDir("../../../src/lua-tests")
+
+require "common"
+
+function measure(name, f)
+    local start = sl.device:lifetime()
+    f()
+    print(string.format('%s: %.1f ms', name, (sl.device:lifetime() - start) * 1000))
+end
+
+-- Runs device updates until the predicate holds so that background jobs get to complete
+function waitFor(predicate)
+    while not predicate() do
+        sl.device:update(function() end)
+    end
+end
+
+function runBenchmark(moduleName)
+    print('Running benchmark ' .. moduleName)
+    require(moduleName)
+end
+
+function run()
+    runBenchmark('effects')
+    runBenchmark('materials')
+    runBenchmark('meshes')
+end
+
+callSafe(run)
@@ -0,0 +1,23 @@
+-- Startup-like load of all effect descriptions. The effect cache is not enabled in entry.lua,
+-- so every run compiles from scratch.
+
+local paths = {}
+for _, path in ipairs(sl.device:fileSystem():listFiles(assetPath('effects'))) do
+    if path:sub(-4) == '.lua' then
+        table.insert(paths, path)
+    end
+end
+
+measure('Sequential, ' .. #paths .. ' effects', function()
+    for _, path in ipairs(paths) do
+        sl.Effect.fromDescriptionFile(sl.device, path)
+    end
+end)
+
+measure('Parallel, ' .. #paths .. ' effects', function()
+    local loaded = 0
+    for _, handle in ipairs(sl.Effect.fromDescriptionFilesAsync(sl.device, paths)) do
+        handle:done(function() loaded = loaded + 1 end)
+    end
+    waitFor(function() return loaded == #paths end)
+end)
@@ -0,0 +1,8 @@
+setup = sl.DeviceSetup()
+setup.mode = sl.DeviceMode.OpenGL
+setup.canvasWidth = 100
+setup.canvasHeight = 100
+setup.fullScreen = false
+setup.vsync = false
+
+entry = "../../../src/lua-benchmarks/benchmarks.lua"
@@ -0,0 +1,43 @@
+-- Per-draw cost of applying materials: many objects sharing one effect, each with its own
+-- material mixing static values, a getter and an auto-binding.
+
+local objectCount = 2000
+local frameCount = 100
+
+local scene = sl.Scene.empty(sl.device)
+
+local cameraNode = scene:createNode()
+local camera = cameraNode:addComponent('Camera')
+cameraNode:findComponent('Transform'):setLocalPosition(vec3(0, 0, 50))
+
+local layout = sl.VertexBufferLayout()
+layout:addAttribute(sl.VertexAttributeUsage.Position)
+local mesh = sl.Mesh.fromFile(sl.device, assetPath('meshes/quad.dae'), layout)
+
+local effect = sl.Effect.fromDescriptionFile(sl.device, assetPath('effects/test.lua'))
+local tex = sl.Texture2D.fromFile(sl.device, assetPath('textures/waffle-slab.png'), false)
+
+for i = 1, objectCount do
+    local mat = sl.Material.fromEffect(sl.device, effect)
+    mat:bindParameter('matrices:wvp', sl.ParameterBinding.WorldViewProjectionMatrix)
+    mat:setFloatParameter('variables:f', i)
+    mat:setVector2Parameter('variables:v2', sl.Vector2(1, 2))
+    mat:setVector3Parameter('variables:v3', sl.Vector3(1, 2, 3))
+    mat:bindVector4Parameter('variables:v4', function() return sl.Vector4(1, 2, 3, 4) end)
+    mat:setVector4Parameter('variables:color', sl.Vector4(1, 1, 1, 1))
+    mat:setTextureParameter('variables:tex', tex)
+
+    local node = scene:createNode()
+    node:findComponent('Transform'):setLocalPosition(vec3(i % 50 - 25, math.floor(i / 50) - 20, 0))
+    local renderer = node:addComponent('MeshRenderer')
+    renderer:setMesh(mesh)
+    renderer:setDefaultMaterial(mat)
+end
+
+measure(objectCount .. ' objects, ' .. frameCount .. ' frames', function()
+    for _ = 1, frameCount do
+        sl.device:update(function()
+            camera:renderFrame(function() scene:render(~0) end)
+        end)
+    end
+end)
@@ -0,0 +1,28 @@
+-- Mesh loading through assimp versus the same meshes cooked into the binary format
+
+local layout = sl.VertexBufferLayout()
+layout:addAttribute(sl.VertexAttributeUsage.Position)
+layout:addAttribute(sl.VertexAttributeUsage.Normal)
+layout:addAttribute(sl.VertexAttributeUsage.TexCoord)
+layout:addAttribute(sl.VertexAttributeUsage.Tangent)
+
+local iterations = 10
+sl.device:fileSystem():createDirectory('../../../temp')
+
+for _, name in ipairs({'teapot', 'house'}) do
+    local source = assetPath('meshes/' .. name .. '.obj')
+    local cooked = '../../../temp/' .. name .. '.slmesh'
+    sl.Mesh.cook(sl.device, source, cooked, layout)
+
+    measure(name .. '.obj via assimp, ' .. iterations .. ' loads', function()
+        for i = 1, iterations do
+            sl.Mesh.fromFile(sl.device, source, layout)
+        end
+    end)
+
+    measure(name .. '.slmesh, ' .. iterations .. ' loads', function()
+        for i = 1, iterations do
+            sl.Mesh.fromFile(sl.device, cooked, layout)
+        end
+    end)
+end
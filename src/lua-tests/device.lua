@@ -25,6 +25,16 @@ assert(d:isMouseButtonReleased(sl.MouseButton.Left) ~= nil)
 d:update(function() end)
 
 assert(d:hasActiveBackgroundJobs() ~= nil)
+
+local stats = d:backgroundJobStats()
+assert(stats.queuedMainThreadTasks ~= nil)
+assert(stats.processedMainThreadTasks ~= nil)
+assert(stats.mainThreadTime ~= nil)
+assert(stats.budgetOverruns ~= nil)
+assert(stats.queueLockAcquisitions ~= nil)
+assert(stats.queueLockContentions ~= nil)
+assert(stats.queueLockWaitTime ~= nil)
+
 assert(d:fileSystem())
 assert(d:physics())
 assert(d:renderer())
@@ -1,4 +1,9 @@
-assert(sl.Effect.fromDescriptionFile(sl.device, assetPath('effects/test.lua')))
+local effect = sl.Effect.fromDescriptionFile(sl.device, assetPath('effects/test.lua'))
+assert(effect)
+assert(effect:hasParameter('variables:f'))
+assert(not effect:hasParameter('variables:missing'))
+assert(effect:parameterCount() > 0)
+assert(effect:parameterName(effect:parameterHandle('matrices:wvp')))
 assert(sl.Effect.fromSourceFile(sl.device, assetPath('effects/test.effect')))
 assert(sl.Effect.fromSource(sl.device, [[
     // VERTEX
@@ -13,4 +18,27 @@ assert(sl.Effect.fromSource(sl.device, [[
     void main()
     {
     }
-]]))
\ No newline at end of file
+]]))
+
+sl.Effect.warmCache(sl.device, assetPath('effects'))
+
+local handle = sl.Effect.fromDescriptionFileAsync(sl.device, assetPath('effects/test.lua'))
+assert(handle.done)
+
+local handles = sl.Effect.fromDescriptionFilesAsync(sl.device, { assetPath('effects/test.lua'), assetPath('effects/color.lua') })
+assert(#handles == 2)
+assert(handles[1].done)
+
+-- An error in one description fails its own handle only
+local fs = sl.device:fileSystem()
+assert(fs:createDirectory('../../../temp'))
+fs:writeLines('../../../temp/broken-effect.lua', {'{ this is not a description'})
+local mixed = sl.Effect.fromDescriptionFilesAsync(sl.device, { assetPath('effects/color.lua'), '../../../temp/broken-effect.lua' })
+for i = 1, 1000 do
+    if not mixed[1]:isPending() and not mixed[2]:isPending() then
+        break
+    end
+    sl.device:update(function() end)
+end
+assert(mixed[1]:isResolved())
+assert(mixed[2]:isFailed())
@@ -4,5 +4,9 @@ setup.canvasWidth = 100
 setup.canvasHeight = 100
 setup.fullScreen = false
 setup.vsync = false
+setup.effectCachePath = '../../../temp/effect-cache'
+setup.jobCompletionBudget = 4
+setup.hotReload = true
+setup.geometryArena = true
 
 entry = "../../../src/lua-tests/tests.lua"
\ No newline at end of file
@@ -2,6 +2,10 @@ assert(sl.TransformSpace.Parent)
 assert(sl.TransformSpace.Self)
 assert(sl.TransformSpace.World)
 
+assert(sl.JobPriority.Low)
+assert(sl.JobPriority.Normal)
+assert(sl.JobPriority.High)
+
 assert(sl.TextureWrap.ClampToEdge)
 assert(sl.TextureWrap.ClampToBorder)
 assert(sl.TextureWrap.Repeat)
@@ -131,5 +135,13 @@ assert(sl.VertexAttributeUsage.TexCoord)
 assert(sl.VertexAttributeUsage.Tangent)
 assert(sl.VertexAttributeUsage.Binormal)
 
+assert(sl.VertexAttributeFormat.Float)
+assert(sl.VertexAttributeFormat.Half)
+assert(sl.VertexAttributeFormat.SNorm16)
+assert(sl.VertexAttributeFormat.UNorm16)
+assert(sl.VertexAttributeFormat.SNorm8)
+assert(sl.VertexAttributeFormat.UNorm8)
+assert(sl.VertexAttributeFormat.Octahedral)
+
 assert(sl.IndexElementSize.Bits16)
 assert(sl.IndexElementSize.Bits32)
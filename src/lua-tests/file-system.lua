@@ -8,3 +8,21 @@ fs:iterateLines(assetPath('test.file'), function(line) return true end)
 
 fs:writeBytes('../../../temp/output.file', {string.byte('a'), string.byte('b'), string.byte('c')})
 fs:writeLines('../../../temp/output.file', {'abc', 'def'})
+
+assert(fs:exists(assetPath('test.file')))
+assert(not fs:exists(assetPath('missing.file')))
+assert(#fs:listFiles(assetPath('effects')) > 0)
+assert(fs:createDirectory('../../../temp'))
+
+sl.PackFile.build(fs, assetPath('effects'), '../../../temp/effects.slpack', true)
+local pack = sl.PackFile.fromPath('../../../temp/effects.slpack')
+assert(#pack:entryNames() == #fs:listFiles(assetPath('effects')))
+
+fs:mountPack('../../../temp/effects.slpack', 'packed-effects')
+local name = pack:entryNames()[1]
+assert(fs:exists('packed-effects/' .. name))
+assert(fs:readText('packed-effects/' .. name) == fs:readText(assetPath('effects/' .. name)))
+assert(#fs:listFiles('packed-effects') == #pack:entryNames())
+
+fs:mountDirectory('../../../temp', 'packed-effects')
+assert(fs:readText('packed-effects/output.file') == 'abc\ndef')
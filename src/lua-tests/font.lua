@@ -18,3 +18,9 @@ assert(glyphInfo.offsetY)
 local mesh = sl.FontMesh.fromFont(sl.device, font)
 mesh:setText('Abc')
 assert(mesh:mesh())
+
+local handle = sl.Font.loadFromFileAsync(
+    sl.device,
+    assetPath('fonts/aller.ttf'),
+    60, 1024, 1024, string.byte(' '), string.byte('~') - string.byte(' '), 2, 2)
+assert(handle.done)
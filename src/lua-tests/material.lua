@@ -21,6 +21,13 @@ mat:setTextureParameter('variables:tex', tex)
 
 mat:bindParameter('matrices:wvp', sl.ParameterBinding.WorldViewProjectionMatrix)
 
+local f = mat:parameterHandle('variables:f')
+assert(f == effect:parameterHandle('variables:f'))
+mat:setFloatParameter(f, 123)
+mat:bindFloatParameter(f, function() return 12 end)
+mat:setTextureParameter(mat:parameterHandle('variables:tex'), tex)
+mat:bindParameter(mat:parameterHandle('matrices:wvp'), sl.ParameterBinding.WorldViewProjectionMatrix)
+
 assert(mat:effect() == effect)
 
 assert(mat:polygonMode())
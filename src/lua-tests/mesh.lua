@@ -14,16 +14,59 @@ assert(layout:attributeCount() == 2)
 assert(layout:attributeIndex(sl.VertexAttributeUsage.Normal) == 1)
 assert(layout:size() == 24)
 assert(layout:elementCount() == 6)
+assert(layout:isFloat())
+
+local compact = layout:toCompact()
+assert(not compact:isFloat())
+assert(compact:attribute(0).format == sl.VertexAttributeFormat.Float)
+assert(compact:attribute(1).format == sl.VertexAttributeFormat.SNorm8)
+assert(compact:attribute(1).componentCount == 4)
+assert(compact:size() == 16)
+assert(compact:toFloat():size() == 24)
+
+local packed = sl.VertexBufferLayout()
+packed:addAttributeWithFormat(sl.VertexAttributeUsage.Normal, sl.VertexAttributeFormat.Octahedral)
+packed:addAttributeWithFormat(sl.VertexAttributeUsage.TexCoord, sl.VertexAttributeFormat.Half)
+assert(packed:attribute(0).componentCount == 2)
+assert(packed:size() == 8)
 
 local m = sl.Mesh.empty(sl.device)
 assert(m)
 
 m = sl.Mesh.fromFile(sl.device, assetPath('meshes/box.dae'), layout)
 assert(m)
+-- Loaded in the formats asked for
+assert(m:vertexBufferLayout(0):isFloat())
+assert(not sl.Mesh.fromFile(sl.device, assetPath('meshes/box.dae'), compact):vertexBufferLayout(0):isFloat())
+
+assert(sl.device:fileSystem():createDirectory('../../../temp'))
+sl.Mesh.cook(sl.device, assetPath('meshes/box.dae'), '../../../temp/box.slmesh', layout)
+local cooked = sl.Mesh.fromFile(sl.device, '../../../temp/box.slmesh', layout)
+assert(cooked:vertexBufferVertexCount(0) == m:vertexBufferVertexCount(0))
+assert(cooked:indexBufferCount() == m:indexBufferCount())
+-- Tests run with DeviceSetup.geometryArena
+assert(cooked:isInGeometryArena())
+
+-- A cooked file with an index past the vertices is rejected
+local bytes = sl.device:fileSystem():readBytes('../../../temp/box.slmesh')
+local indexDataOffset = 0
+for i = 8, 1, -1 do
+    indexDataOffset = indexDataOffset * 256 + bytes[56 + i] -- the u64 at byte 56 of the header, little-endian
+end
+for i = 1, 4 do
+    bytes[indexDataOffset + i] = 0x7f
+end
+sl.device:fileSystem():writeBytes('../../../temp/box-corrupted.slmesh', bytes)
+assert(not pcall(sl.Mesh.fromFile, sl.device, '../../../temp/box-corrupted.slmesh', layout))
 
 -- TODO Properly check the result
 assert(sl.Mesh.fromFileAsync(sl.device, assetPath('meshes/box.dae'), layout))
 
+local cancelled = sl.Mesh.fromFileAsync(sl.device, assetPath('meshes/box.dae'), layout)
+cancelled:setPriority(sl.JobPriority.Low)
+cancelled:cancel()
+assert(cancelled:isCancelled())
+
 m = sl.Mesh.empty(sl.device)
 
 m:addVertexBuffer(layout, {
@@ -45,12 +88,76 @@ assert(m:vertexBufferVertexCount(0) == 1)
 assert(m:vertexBufferLayout(0))
 assert(m:vertexBufferData(0))
 
+assert(m:addVertexBuffer(compact, {
+    1, 2, 3,
+    0, 1, 0
+}, 1) == 1)
+m:updateVertexBuffer(1, 0, {0, 0, 0, 1, 0, 0}, 1)
+m:removeVertexBuffer(1)
+
 m:addIndexBuffer({0, 0, 0}, 3)
 assert(m:indexBufferCount() == 1)
 assert(m:indexBufferElementCount(0) == 3)
-assert(m:indexBufferElementSize(0) == 4)
-assert(m:indexData(0))
+assert(m:indexElementSize() == 2)
+assert(m:indexData())
 m:removeIndexBuffer(0)
 
+local first = sl.MeshPart()
+first.indexOffset = 0
+first.indexCount = 3
+first.baseVertex = 0
+local second = sl.MeshPart()
+second.indexOffset = 3
+second.indexCount = 3
+second.baseVertex = 0
+m:setIndexBuffer({0, 0, 0, 0, 0, 0}, {first, second})
+assert(m:indexBufferCount() == 2)
+assert(m:part(1).indexOffset == 3)
+assert(m:indexCount() == 6)
+m:removeIndexBuffer(0)
+assert(m:indexBufferCount() == 1)
+assert(m:part(0).indexOffset == 0)
+m:removeIndexBuffer(0)
+
+local released = sl.Mesh.fromFile(sl.device, assetPath('meshes/box.dae'), layout)
+assert(released:cpuData() == sl.MeshCpuData.Keep)
+assert(#released:indexData() == released:indexCount())
+released:setCpuData(sl.MeshCpuData.Release)
+assert(#released:indexData() == 0)
+assert(#released:vertexBufferData(0) == 0)
+assert(released:indexCount() > 0)
+
+-- Enough meshes to grow the arena pool past its initial size. Half of them are collected in the middle of a frame,
+-- which leaves holes for the next frame to compact, and more are loaded mid-frame, growing the pool again.
+local arenaMeshes = {}
+local arenaVertexCount = 0
+while arenaVertexCount < 200000 do
+    local mesh = sl.Mesh.fromFile(sl.device, assetPath('meshes/teapot.obj'), layout)
+    assert(mesh:isInGeometryArena())
+    arenaVertexCount = arenaVertexCount + mesh:vertexBufferVertexCount(0)
+    arenaMeshes[#arenaMeshes + 1] = mesh
+end
+
+sl.device:update(function()
+    for i = 1, #arenaMeshes, 2 do
+        arenaMeshes[i] = false
+    end
+    collectgarbage()
+    for i = 1, 10 do
+        arenaMeshes[#arenaMeshes + 1] = sl.Mesh.fromFile(sl.device, assetPath('meshes/teapot.obj'), layout)
+    end
+end)
+sl.device:update(function() end)
+
+for _, mesh in ipairs(arenaMeshes) do
+    if mesh then
+        assert(mesh:isInGeometryArena())
+        assert(mesh:vertexBufferVertexCount(0) == arenaMeshes[2]:vertexBufferVertexCount(0))
+        assert(#mesh:indexData() == mesh:indexCount())
+    end
+end
+arenaMeshes = nil
+collectgarbage()
+
 assert(m:primitiveType())
 m:setPrimitiveType(sl.PrimitiveType.TriangleStrip)
@@ -9,8 +9,11 @@ local layout = sl.VertexBufferLayout()
 layout:addAttribute(sl.VertexAttributeUsage.Position)
 layout:addAttribute(sl.VertexAttributeUsage.Normal)
 local mesh = sl.Mesh.fromFile(sl.device, assetPath('meshes/box.dae'), layout)
+assert(not mesh:isCpuDataPinned())
 local meshCollider = sl.StaticMeshCollider.fromMesh(mesh)
 assert(meshCollider)
+-- The collider reads the mesh's CPU copy in place
+assert(mesh:isCpuDataPinned())
 
 local params = sl.RigidBodyParams()
 params.mass = 1
@@ -1,6 +1,25 @@
 assert(sl.Texture2D.fromFile(sl.device, assetPath('textures/waffle-slab.png'), true))
 local handle = sl.Texture2D.fromFileAsync(sl.device, assetPath('textures/waffle-slab.png'), true)
 assert(handle.done)
+handle:setPriority(sl.JobPriority.High)
+assert(handle:priority() == sl.JobPriority.High)
+
+local cancelled = sl.Texture2D.fromFileAsync(sl.device, assetPath('textures/waffle-slab.png'), true)
+cancelled:cancel()
+assert(cancelled:isCancelled())
+assert(not cancelled:isPending())
+assert(cancelled:isResolved() == false)
+assert(cancelled:isFailed() == false)
+
+-- A file that can't be read fails the handle instead of taking the process down
+local missing = sl.Texture2D.fromFileAsync(sl.device, assetPath('textures/missing.png'), true)
+for i = 1, 1000 do
+    if not missing:isPending() then
+        break
+    end
+    sl.device:update(function() end)
+end
+assert(missing:isFailed())
 
 local tex = sl.Texture2D.empty(sl.device, 100, 100, sl.TextureFormat.Depth24)
 assert(tex:dimensions())
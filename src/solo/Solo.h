@@ -6,12 +6,14 @@
 #pragma once
 
 #include "SoloEnums.h"
+#include "SoloAdaptiveLock.h"
 #include "SoloAsyncHandle.h"
 #include "SoloBoxCollider.h"
 #include "SoloCamera.h"
 #include "SoloCollider.h"
 #include "SoloCommon.h"
 #include "SoloComponent.h"
+#include "SoloCookedAssets.h"
 #include "math/SoloDegrees.h"
 #include "SoloDevice.h"
 #include "SoloDeviceSetup.h"
@@ -21,13 +23,17 @@
 #include "SoloFontMesh.h"
 #include "SoloFrameBuffer.h"
 #include "SoloHash.h"
+#include "SoloHotReload.h"
 #include "SoloJobPool.h"
+#include "SoloMappedFile.h"
 #include "SoloMaterial.h"
 #include "math/SoloMath.h"
 #include "math/SoloMatrix.h"
 #include "SoloMesh.h"
+#include "SoloMeshData.h"
 #include "SoloMeshRenderer.h"
 #include "SoloNode.h"
+#include "SoloPackFile.h"
 #include "SoloPhysics.h"
 #include "math/SoloQuaternion.h"
 #include "math/SoloRadians.h"
@@ -37,7 +43,6 @@
 #include "SoloScene.h"
 #include "SoloScriptRuntime.h"
 #include "SoloSpectator.h"
-#include "SoloSpinLock.h"
 #include "SoloStaticMeshCollider.h"
 #include "SoloStringUtils.h"
 #include "SoloTexture.h"
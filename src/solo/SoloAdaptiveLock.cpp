@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloAdaptiveLock.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(SL_WINDOWS)
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <Windows.h>
+#   pragma comment(lib, "Synchronization.lib")
+#elif defined(SL_LINUX)
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   include <immintrin.h>
+#   define SL_CPU_PAUSE() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#   define SL_CPU_PAUSE() __asm__ __volatile__("yield")
+#else
+#   define SL_CPU_PAUSE()
+#endif
+
+using namespace solo;
+
+static_assert(sizeof(std::atomic<u32>) == sizeof(u32), "Futex word must be a plain 32-bit integer");
+
+static constexpr u32 maxSpinRounds = 8;
+static constexpr u32 maxPausesPerRound = 128;
+
+auto AdaptiveLock::stats() const -> LockStats {
+    LockStats result;
+    result.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+    result.contendedAcquisitions = contendedAcquisitions_.load(std::memory_order_relaxed);
+    result.waitTime = waitNanoseconds_.load(std::memory_order_relaxed) / 1000000.0;
+    return result;
+}
+
+void AdaptiveLock::lockContended() {
+    const auto start = instrumented_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    // Spin with exponential backoff: 1, 2, 4... pauses between attempts
+    auto acquired = false;
+    u32 pauses = 1;
+    for (u32 round = 0; round < maxSpinRounds && !acquired; round++) {
+        for (u32 i = 0; i < pauses; i++)
+            SL_CPU_PAUSE();
+        pauses = std::min(pauses * 2, maxPausesPerRound);
+
+        u32 expected = Unlocked;
+        if (state_.load(std::memory_order_relaxed) == Unlocked)
+            acquired = state_.compare_exchange_strong(expected, Locked, std::memory_order_acquire);
+    }
+
+    // Park. Once anyone has parked the lock stays marked as "with waiters" so that unlock() wakes someone up.
+    if (!acquired) {
+        while (state_.exchange(LockedWithWaiters, std::memory_order_acquire) != Unlocked)
+            wait();
+    }
+
+    if (instrumented_) {
+        const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        contendedAcquisitions_.fetch_add(1, std::memory_order_relaxed);
+        waitNanoseconds_.fetch_add(waited.count(), std::memory_order_relaxed);
+    }
+}
+
+void AdaptiveLock::wait() {
+#if defined(SL_WINDOWS)
+    auto expected = static_cast<u32>(LockedWithWaiters);
+    WaitOnAddress(&state_, &expected, sizeof(expected), INFINITE);
+#elif defined(SL_LINUX)
+    syscall(SYS_futex, reinterpret_cast<u32*>(&state_), FUTEX_WAIT_PRIVATE, LockedWithWaiters, nullptr, nullptr, 0);
+#else
+    while (state_.load(std::memory_order_relaxed) == LockedWithWaiters)
+        std::this_thread::yield();
+#endif
+}
+
+void AdaptiveLock::wakeOne() {
+#if defined(SL_WINDOWS)
+    WakeByAddressSingle(&state_);
+#elif defined(SL_LINUX)
+    syscall(SYS_futex, reinterpret_cast<u32*>(&state_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+}
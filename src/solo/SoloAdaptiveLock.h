@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <atomic>
+
+namespace solo {
+    // "class" because binding to lua seems to not support structs
+    class LockStats {
+    public:
+        u64 acquisitions = 0;
+        /// Acquisitions that found the lock taken
+        u64 contendedAcquisitions = 0;
+        /// Total time spent waiting for the lock, in milliseconds
+        double waitTime = 0;
+    };
+
+    // Spins for a short while with a CPU pause and exponential backoff, then parks the thread
+    // (futex on Linux, WaitOnAddress on Windows). Satisfies Lockable, so works with std::lock_guard.
+    class AdaptiveLock final {
+    public:
+        explicit AdaptiveLock(bool instrumented = false):
+            instrumented_(instrumented) {
+        }
+
+        AdaptiveLock(const AdaptiveLock &other) = delete;
+        AdaptiveLock(AdaptiveLock &&other) = delete;
+        ~AdaptiveLock() = default;
+
+        auto operator=(const AdaptiveLock &other) -> AdaptiveLock & = delete;
+        auto operator=(AdaptiveLock &&other) -> AdaptiveLock & = delete;
+
+        void lock() {
+            u32 expected = Unlocked;
+            if (state_.compare_exchange_strong(expected, Locked, std::memory_order_acquire)) {
+                if (instrumented_)
+                    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            lockContended();
+        }
+
+        bool try_lock() {
+            u32 expected = Unlocked;
+            const auto locked = state_.compare_exchange_strong(expected, Locked, std::memory_order_acquire);
+            if (locked && instrumented_)
+                acquisitions_.fetch_add(1, std::memory_order_relaxed);
+            return locked;
+        }
+
+        void unlock() {
+            if (state_.exchange(Unlocked, std::memory_order_release) == LockedWithWaiters)
+                wakeOne();
+        }
+
+        auto stats() const -> LockStats;
+
+    private:
+        enum: u32 {
+            Unlocked = 0,
+            Locked = 1,
+            LockedWithWaiters = 2
+        };
+
+        std::atomic<u32> state_{Unlocked};
+
+        const bool instrumented_;
+        std::atomic<u64> acquisitions_{0};
+        std::atomic<u64> contendedAcquisitions_{0};
+        std::atomic<u64> waitNanoseconds_{0};
+
+        void lockContended();
+        void wait();
+        void wakeOne();
+    };
+}
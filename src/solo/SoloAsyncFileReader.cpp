@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloAsyncFileReader.h"
+#include "SoloThreadPool.h"
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+#ifdef __linux__
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/syscall.h>
+#   include <sys/uio.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#   include <cstring>
+#endif
+
+using namespace solo;
+
+constexpr u64 AsyncFileReader::toEnd;
+
+static constexpr u32 ringEntries = 64;
+static constexpr u32 maxIoThreads = 4;
+
+#ifdef __linux__
+
+namespace solo {
+    // Bare io_uring over raw syscalls, just enough for batches of reads. Only the dispatcher thread touches it.
+    class IoUring final {
+    public:
+        // Null when the kernel doesn't support io_uring or doesn't let this process use it
+        static auto create(u32 entries) -> uptr<IoUring> {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            const auto fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0)
+                return nullptr;
+
+            auto ring = uptr<IoUring>(new IoUring());
+            ring->fd_ = fd;
+            ring->entries_ = params.sq_entries;
+
+            ring->sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(u32);
+            ring->cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const auto singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMap)
+                ring->sqRingSize_ = ring->cqRingSize_ = (std::max)(ring->sqRingSize_, ring->cqRingSize_);
+
+            ring->sqRing_ = map(fd, ring->sqRingSize_, IORING_OFF_SQ_RING);
+            if (!ring->sqRing_)
+                return nullptr;
+            ring->cqRing_ = singleMap ? ring->sqRing_ : map(fd, ring->cqRingSize_, IORING_OFF_CQ_RING);
+            if (!ring->cqRing_)
+                return nullptr;
+            ring->sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+            ring->sqes_ = static_cast<io_uring_sqe *>(map(fd, ring->sqesSize_, IORING_OFF_SQES));
+            if (!ring->sqes_)
+                return nullptr;
+
+            const auto sq = static_cast<u8 *>(ring->sqRing_);
+            ring->sqHead_ = reinterpret_cast<u32 *>(sq + params.sq_off.head);
+            ring->sqTail_ = reinterpret_cast<u32 *>(sq + params.sq_off.tail);
+            ring->sqMask_ = *reinterpret_cast<u32 *>(sq + params.sq_off.ring_mask);
+            ring->sqArray_ = reinterpret_cast<u32 *>(sq + params.sq_off.array);
+
+            const auto cq = static_cast<u8 *>(ring->cqRing_);
+            ring->cqHead_ = reinterpret_cast<u32 *>(cq + params.cq_off.head);
+            ring->cqTail_ = reinterpret_cast<u32 *>(cq + params.cq_off.tail);
+            ring->cqMask_ = *reinterpret_cast<u32 *>(cq + params.cq_off.ring_mask);
+            ring->cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+            return ring;
+        }
+
+        IoUring(const IoUring &other) = delete;
+        IoUring(IoUring &&other) = delete;
+
+        ~IoUring() {
+            if (sqes_)
+                munmap(sqes_, sqesSize_);
+            if (cqRing_ && cqRing_ != sqRing_)
+                munmap(cqRing_, cqRingSize_);
+            if (sqRing_)
+                munmap(sqRing_, sqRingSize_);
+            if (fd_ >= 0)
+                close(fd_);
+        }
+
+        auto operator=(const IoUring &other) -> IoUring & = delete;
+        auto operator=(IoUring &&other) -> IoUring & = delete;
+
+        auto capacity() const -> u32 {
+            return entries_;
+        }
+
+        // False when the submission queue is full. `iov` must stay alive until the read completes.
+        bool prepareRead(int fd, iovec *iov, u64 offset, u64 userData) {
+            const auto tail = *sqTail_;
+            if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= entries_)
+                return false;
+
+            const auto index = tail & sqMask_;
+            auto &sqe = sqes_[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READV;
+            sqe.fd = fd;
+            sqe.off = offset;
+            sqe.addr = reinterpret_cast<u64>(iov);
+            sqe.len = 1;
+            sqe.user_data = userData;
+            sqArray_[index] = index;
+
+            __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+            unsubmitted_++;
+            return true;
+        }
+
+        void submitAndWait(u32 minCompletions) {
+            while (true) {
+                const auto submitted = syscall(__NR_io_uring_enter, fd_, unsubmitted_, minCompletions, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (submitted >= 0) {
+                    unsubmitted_ -= static_cast<u32>(submitted);
+                    if (!unsubmitted_)
+                        return;
+                } else
+                    panicIf(errno != EINTR && errno != EAGAIN && errno != EBUSY, "io_uring_enter failed: ", std::strerror(errno));
+            }
+        }
+
+        bool popCompletion(u64 &userData, s32 &result) {
+            const auto head = *cqHead_;
+            if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+                return false;
+
+            const auto &cqe = cqes_[head & cqMask_];
+            userData = cqe.user_data;
+            result = cqe.res;
+            __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+    private:
+        int fd_ = -1;
+        u32 entries_ = 0;
+        u32 unsubmitted_ = 0;
+
+        void *sqRing_ = nullptr;
+        void *cqRing_ = nullptr;
+        size_t sqRingSize_ = 0;
+        size_t cqRingSize_ = 0;
+        io_uring_sqe *sqes_ = nullptr;
+        size_t sqesSize_ = 0;
+
+        u32 *sqHead_ = nullptr;
+        u32 *sqTail_ = nullptr;
+        u32 sqMask_ = 0;
+        u32 *sqArray_ = nullptr;
+        u32 *cqHead_ = nullptr;
+        u32 *cqTail_ = nullptr;
+        u32 cqMask_ = 0;
+        io_uring_cqe *cqes_ = nullptr;
+
+        IoUring() = default;
+
+        static auto map(int fd, size_t size, u64 offset) -> void * {
+            const auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, static_cast<off_t>(offset));
+            return p == MAP_FAILED ? nullptr : p;
+        }
+    };
+}
+
+#else
+
+namespace solo {
+    class IoUring final {
+    };
+}
+
+#endif
+
+auto AsyncFileReader::create() -> sptr<AsyncFileReader> {
+    auto reader = sptr<AsyncFileReader>(new AsyncFileReader());
+#ifdef __linux__
+    reader->ring_ = IoUring::create(ringEntries);
+#endif
+    if (!reader->ring_)
+        reader->ioThreads_ = std::make_unique<ThreadPool>((std::min)(maxIoThreads, (std::max)(1u, std::thread::hardware_concurrency())));
+
+    reader->dispatcher_ = std::thread([reader = reader.get()] { reader->run(); });
+    return reader;
+}
+
+AsyncFileReader::AsyncFileReader() = default;
+
+AsyncFileReader::~AsyncFileReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_one();
+    if (dispatcher_.joinable())
+        dispatcher_.join();
+}
+
+void AsyncFileReader::read(const str &path, u64 offset, u64 size, Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(Request{path, offset, size, std::move(callback)});
+    }
+    wakeCondition_.notify_one();
+}
+
+void AsyncFileReader::run() {
+    while (true) {
+        vec<Request> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeCondition_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty())
+                return;
+            batch.swap(pending_);
+        }
+
+        std::stable_sort(batch.begin(), batch.end(), [](const Request &a, const Request &b) {
+            return a.path != b.path ? a.path < b.path : a.offset < b.offset;
+        });
+
+        if (ring_)
+            readWithRing(batch);
+        else
+            readWithThreads(batch);
+    }
+}
+
+static auto readError(const str &msg) -> std::exception_ptr {
+    return std::make_exception_ptr(std::runtime_error(msg));
+}
+
+// Offset and size of the part of the range that is inside the file
+static void clampRange(u64 fileSize, u64 &offset, u64 &size) {
+    offset = (std::min)(offset, fileSize);
+    size = (std::min)(size, fileSize - offset);
+}
+
+void AsyncFileReader::readWithRing(vec<Request> &batch) {
+#ifdef __linux__
+    struct Read {
+        int fd;
+        u64 offset;
+        u64 done;
+        sptr<vec<u8>> data;
+        iovec iov;
+    };
+
+    vec<Read> reads(batch.size());
+    vec<int> fds;
+    std::deque<size_t> queue;
+
+    // Requests are sorted by path, so each file gets opened once. Every range of a file that fails to open fails.
+    std::exception_ptr openError;
+    u64 fileSize = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+        auto &request = batch[i];
+        auto &read = reads[i];
+        if (i > 0 && request.path == batch[i - 1].path)
+            read.fd = reads[i - 1].fd;
+        else {
+            read.fd = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (read.fd >= 0)
+                fds.push_back(read.fd);
+
+            struct stat info;
+            openError = nullptr;
+            if (read.fd < 0 || fstat(read.fd, &info) != 0)
+                openError = readError(fmt("Unable to open file ", request.path, ": ", std::strerror(errno)));
+            else
+                fileSize = static_cast<u64>(info.st_size);
+        }
+
+        if (openError) {
+            request.callback(nullptr, openError);
+            continue;
+        }
+
+        read.offset = request.offset;
+        auto size = request.size;
+        clampRange(fileSize, read.offset, size);
+        read.done = 0;
+        read.data = std::make_shared<vec<u8>>(static_cast<size_t>(size));
+
+        if (size)
+            queue.push_back(i);
+        else
+            request.callback(read.data, nullptr);
+    }
+
+    u32 inFlight = 0;
+    while (!queue.empty() || inFlight) {
+        // Never more in flight than the completion queue is guaranteed to hold
+        while (!queue.empty() && inFlight < ring_->capacity()) {
+            auto &read = reads[queue.front()];
+            read.iov.iov_base = read.data->data() + read.done;
+            read.iov.iov_len = static_cast<size_t>(read.data->size() - read.done);
+            if (!ring_->prepareRead(read.fd, &read.iov, read.offset + read.done, queue.front()))
+                break;
+            queue.pop_front();
+            inFlight++;
+        }
+
+        ring_->submitAndWait(1);
+
+        u64 index;
+        s32 result;
+        while (ring_->popCompletion(index, result)) {
+            inFlight--;
+            auto &read = reads[index];
+            if (result == -EINTR || result == -EAGAIN) {
+                queue.push_back(index);
+                continue;
+            }
+            if (result < 0) {
+                batch[index].callback(nullptr, readError(fmt("Unable to read file ", batch[index].path, ": ", std::strerror(-result))));
+                continue;
+            }
+
+            read.done += static_cast<u64>(result);
+            // The file got shorter since it was opened
+            if (!result)
+                read.data->resize(static_cast<size_t>(read.done));
+
+            if (read.done < read.data->size())
+                queue.push_back(index);
+            else
+                batch[index].callback(read.data, nullptr);
+        }
+    }
+
+    for (const auto fd : fds)
+        close(fd);
+#endif
+}
+
+void AsyncFileReader::readWithThreads(vec<Request> &batch) {
+    // One task per file, reading its ranges in order
+    vec<size_t> fileStarts;
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (!i || batch[i].path != batch[i - 1].path)
+            fileStarts.push_back(i);
+    }
+    fileStarts.push_back(batch.size());
+
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    auto remaining = fileStarts.size() - 1;
+
+    for (size_t f = 0; f + 1 < fileStarts.size(); f++) {
+        const auto begin = fileStarts[f];
+        const auto end = fileStarts[f + 1];
+        ioThreads_->submit([&, begin, end] {
+            const auto &path = batch[begin].path;
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            const auto fileSize = file.is_open() ? static_cast<u64>(file.tellg()) : 0;
+
+            for (auto i = begin; i < end; i++) {
+                if (!file.is_open()) {
+                    batch[i].callback(nullptr, readError(fmt("Unable to open file ", path)));
+                    continue;
+                }
+
+                auto offset = batch[i].offset;
+                auto size = batch[i].size;
+                clampRange(fileSize, offset, size);
+
+                auto data = std::make_shared<vec<u8>>(static_cast<size_t>(size));
+                if (size) {
+                    file.seekg(static_cast<std::streamoff>(offset));
+                    file.read(reinterpret_cast<s8 *>(data->data()), static_cast<std::streamsize>(size));
+                    data->resize(static_cast<size_t>(file.gcount()));
+                    file.clear();
+                }
+                batch[i].callback(data, nullptr);
+            }
+
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--remaining == 0)
+                doneCondition.notify_one();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&remaining] { return remaining == 0; });
+}
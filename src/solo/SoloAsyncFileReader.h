@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace solo {
+    class ThreadPool;
+    class IoUring;
+
+    // Reads file ranges in the background. Requests that come in while a batch is being read make up the next batch,
+    // which is read grouped by file and in offset order. On Linux reads go through io_uring when the kernel allows it,
+    // elsewhere (and as a fallback) through a few I/O threads doing blocking reads.
+    class AsyncFileReader final {
+    public:
+        // Size that means "up to the end of the file"
+        static constexpr u64 toEnd = ~0ull;
+
+        // Invoked on an I/O thread. Ranges past the end of the file come out shorter. Files that can't be opened
+        // or read give null data and the error instead.
+        using Callback = std::function<void(sptr<vec<u8>> data, std::exception_ptr error)>;
+
+        static auto create() -> sptr<AsyncFileReader>;
+
+        AsyncFileReader(const AsyncFileReader &other) = delete;
+        AsyncFileReader(AsyncFileReader &&other) = delete;
+        // Finishes the reads already requested
+        ~AsyncFileReader();
+
+        auto operator=(const AsyncFileReader &other) -> AsyncFileReader & = delete;
+        auto operator=(AsyncFileReader &&other) -> AsyncFileReader & = delete;
+
+        bool usesIoUring() const {
+            return ring_ != nullptr;
+        }
+
+        void read(const str &path, u64 offset, u64 size, Callback callback);
+
+    private:
+        struct Request {
+            str path;
+            u64 offset;
+            u64 size;
+            Callback callback;
+        };
+
+        std::mutex mutex_;
+        std::condition_variable wakeCondition_;
+        vec<Request> pending_;
+        bool stopping_ = false;
+
+        uptr<IoUring> ring_;
+        uptr<ThreadPool> ioThreads_;
+        std::thread dispatcher_;
+
+        AsyncFileReader();
+
+        void run();
+        void readWithRing(vec<Request> &batch);
+        void readWithThreads(vec<Request> &batch);
+    };
+}
@@ -6,26 +6,380 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloJobPool.h"
 #include <functional>
+#include <mutex>
+#include <exception>
+#include <type_traits>
 
 namespace solo {
+    template <class T> class AsyncHandle;
+
+    // Type-independent part of a handle, so that handles of different types can be joined in one graph
+    class AsyncHandleBase: public std::enable_shared_from_this<AsyncHandleBase> {
+    public:
+        enum class State {
+            Pending,
+            Resolved,
+            Failed,
+            Cancelled
+        };
+
+        AsyncHandleBase(const AsyncHandleBase &other) = delete;
+        AsyncHandleBase(AsyncHandleBase &&other) = delete;
+        virtual ~AsyncHandleBase() = default;
+
+        auto operator=(const AsyncHandleBase &other) -> AsyncHandleBase & = delete;
+        auto operator=(AsyncHandleBase &&other) -> AsyncHandleBase & = delete;
+
+        auto state() const -> State {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return state_;
+        }
+
+        bool isPending() const { return state() == State::Pending; }
+        bool isResolved() const { return state() == State::Resolved; }
+        bool isFailed() const { return state() == State::Failed; }
+        bool isCancelled() const { return state() == State::Cancelled; }
+
+        auto error() const -> std::exception_ptr {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return error_;
+        }
+
+        auto jobPool() const -> JobPool* {
+            return pool_;
+        }
+
+        auto priority() const -> JobPriority {
+            return priority_;
+        }
+
+        // Moves this handle's work to another queue if it hasn't started yet, and does the same for
+        // the handles it waits on, so that boosting a final handle boosts the whole chain
+        void setPriority(JobPriority priority) {
+            priority_ = priority;
+            requeue(priority);
+            if (const auto source = source_.lock())
+                source->setPriority(priority);
+            for (const auto &input : inputs_) {
+                if (const auto handle = input.lock())
+                    handle->setPriority(priority);
+            }
+        }
+
+        // Work that hasn't started yet is skipped, a result that isn't consumed yet is dropped. Continuations
+        // get cancelled too, and so does the handle this one waits on unless something else still depends on it.
+        // Work that is already running is not interrupted.
+        void cancel() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!settle(lock, State::Cancelled, nullptr))
+                return;
+            if (const auto source = source_.lock())
+                source->releaseDependent();
+        }
+
+        // Dependents keep the handle alive when one of the continuations gets cancelled
+        void addDependent() {
+            dependents_++;
+        }
+
+        void releaseDependent() {
+            if (--dependents_ == 0)
+                cancel();
+        }
+
+        void fail(std::exception_ptr error) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            settle(lock, State::Failed, error);
+        }
+
+        // Called once the handle leaves the pending state, on the thread that settled it
+        // (or right away if it has already settled)
+        void onSettled(const std::function<void()> &callback) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (state_ == State::Pending) {
+                    callbacks_.push_back(callback);
+                    return;
+                }
+            }
+            callback();
+        }
+
+    protected:
+        friend auto whenAll(JobPool *pool, const vec<sptr<AsyncHandleBase>> &handles) -> sptr<AsyncHandle<vec<sptr<AsyncHandleBase>>>>;
+        friend auto whenAny(JobPool *pool, const vec<sptr<AsyncHandleBase>> &handles) -> sptr<AsyncHandle<AsyncHandleBase>>;
+
+        explicit AsyncHandleBase(JobPool *pool): pool_(pool) {
+        }
+
+        JobPool *pool_ = nullptr;
+        mutable std::mutex mutex_;
+        std::atomic<JobPriority> priority_{JobPriority::Normal};
+        std::weak_ptr<AsyncHandleBase> source_;
+        // Handles joined by whenAll/whenAny, only followed by setPriority (they are released through onSettled)
+        vec<std::weak_ptr<AsyncHandleBase>> inputs_;
+
+        virtual void requeue(JobPriority /*priority*/) {
+        }
+
+        bool isPendingLocked() const {
+            return state_ == State::Pending;
+        }
+
+        bool settle(std::unique_lock<std::mutex> &lock, State state, std::exception_ptr error) {
+            if (state_ != State::Pending)
+                return false;
+
+            state_ = state;
+            error_ = error;
+            auto callbacks = std::move(callbacks_);
+            callbacks_.clear();
+            lock.unlock();
+
+            for (const auto &callback : callbacks)
+                callback();
+            return true;
+        }
+
+        static void logFailure(std::exception_ptr error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception &e) {
+                Logger::global().logError(fmt("Async job failed: ", e.what()));
+            } catch (...) {
+                Logger::global().logError("Async job failed");
+            }
+        }
+
+    private:
+        State state_ = State::Pending;
+        std::exception_ptr error_;
+        vec<std::function<void()>> callbacks_;
+        std::atomic<u32> dependents_{0};
+    };
+
     template <class T>
-    class AsyncHandle {
+    class AsyncHandle final: public AsyncHandleBase {
     public:
-        void done(std::function<void(sptr<T>)> callback) {
-            if (callback && result_)
-                callback(result_);
-            this->callback_ = callback;
+        using Callback = std::function<void(sptr<T>)>;
+
+        explicit AsyncHandle(JobPool *pool): AsyncHandleBase(pool) {
+        }
+
+        // Runs `func` on the given thread and resolves the returned handle with its result
+        static auto run(JobPool *pool, JobThread thread, std::function<sptr<T>()> func,
+            JobPriority priority = JobPriority::Normal) -> sptr<AsyncHandle<T>> {
+            auto handle = std::make_shared<AsyncHandle<T>>(pool);
+            handle->priority_ = priority;
+            handle->start(thread, std::move(func));
+            return handle;
+        }
+
+        auto result() const -> sptr<T> {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return result_;
+        }
+
+        // Callback is always invoked on the main thread and only if the handle resolves successfully
+        void done(Callback callback) {
+            addDependent();
+            const auto pool = pool_;
+            onSettled([this, pool, callback] {
+                if (!callback || !isResolved())
+                    return;
+                const auto r = result();
+                if (pool->isMainThread())
+                    callback(r);
+                else
+                    pool->schedule(JobThread::Main, [callback, r] { callback(r); });
+            });
+        }
+
+        // Schedules `func` on the given thread once this handle resolves. Failure and cancellation
+        // skip `func` and are passed on to the returned handle.
+        template <class F>
+        auto then(JobThread thread, F func) -> sptr<AsyncHandle<typename std::result_of<F(sptr<T>)>::type::element_type>> {
+            using U = typename std::result_of<F(sptr<T>)>::type::element_type;
+
+            auto next = std::make_shared<AsyncHandle<U>>(pool_);
+            next->priority_ = priority();
+            next->source_ = shared_from_this();
+            addDependent();
+
+            onSettled([this, thread, func, next] {
+                switch (state()) {
+                    case State::Resolved: {
+                        const auto r = result();
+                        next->start(thread, [func, r] { return func(r); });
+                        break;
+                    }
+                    case State::Failed:
+                        next->fail(error());
+                        break;
+                    default:
+                        next->cancel();
+                        break;
+                }
+            });
+
+            return next;
         }
 
         void resolve(sptr<T> result) {
-            if (callback_)
-                callback_(result);
-            this->result_ = result;
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!isPendingLocked())
+                return;
+            result_ = result;
+            settle(lock, State::Resolved, nullptr);
+        }
+
+        void resolveWith(const std::function<sptr<T>()> &func) {
+            // Don't bother if someone cancelled the handle while the job was waiting in a queue
+            if (!isPending())
+                return;
+
+            try {
+                resolve(func());
+            } catch (...) {
+                const auto error = std::current_exception();
+                logFailure(error);
+                fail(error);
+            }
         }
 
     private:
-        std::function<void(sptr<T>)> callback_;
+        template <class> friend class AsyncHandle;
+
         sptr<T> result_;
+        JobThread thread_ = JobThread::Worker;
+        std::function<sptr<T>()> work_;
+        std::atomic<bool> queued_{false};
+        std::atomic<bool> started_{false};
+
+        void start(JobThread thread, std::function<sptr<T>()> work) {
+            thread_ = thread;
+            work_ = std::move(work);
+            queued_ = true;
+            enqueue(priority_);
+        }
+
+        void enqueue(JobPriority priority) {
+            const auto self = std::static_pointer_cast<AsyncHandle<T>>(shared_from_this());
+            pool_->schedule(thread_, [self, priority] {
+                self->runQueued(priority);
+            }, priority);
+        }
+
+        void runQueued(JobPriority queuedPriority) {
+            // An entry left behind by setPriority, the up-to-date one runs the work
+            if (priority_ != queuedPriority)
+                return;
+            if (started_.exchange(true))
+                return;
+
+            const auto work = std::move(work_);
+            work_ = nullptr;
+            resolveWith(work);
+        }
+
+        void requeue(JobPriority priority) override final {
+            if (queued_ && !started_ && isPending())
+                enqueue(priority);
+        }
     };
-}
\ No newline at end of file
+
+    // Resolves when all handles resolve, with the same handles as the result. Fails or gets cancelled
+    // as soon as any of the handles does.
+    inline auto whenAll(JobPool *pool, const vec<sptr<AsyncHandleBase>> &handles) -> sptr<AsyncHandle<vec<sptr<AsyncHandleBase>>>> {
+        auto all = std::make_shared<AsyncHandle<vec<sptr<AsyncHandleBase>>>>(pool);
+        all->inputs_.assign(handles.begin(), handles.end());
+        auto results = std::make_shared<vec<sptr<AsyncHandleBase>>>(handles);
+        if (handles.empty()) {
+            all->resolve(results);
+            return all;
+        }
+
+        all->onSettled([all, handles] {
+            if (all->isCancelled()) {
+                for (const auto &handle : handles)
+                    handle->releaseDependent();
+            }
+        });
+
+        auto remaining = std::make_shared<std::atomic<size_t>>(handles.size());
+        for (const auto &handle : handles) {
+            handle->addDependent();
+            const auto h = handle.get();
+            handle->onSettled([h, all, results, remaining] {
+                switch (h->state()) {
+                    case AsyncHandleBase::State::Resolved:
+                        if (remaining->fetch_sub(1) == 1)
+                            all->resolve(results);
+                        break;
+                    case AsyncHandleBase::State::Failed:
+                        all->fail(h->error());
+                        break;
+                    default:
+                        all->cancel();
+                        break;
+                }
+            });
+        }
+
+        return all;
+    }
+
+    template <class T>
+    auto whenAll(JobPool *pool, const vec<sptr<AsyncHandle<T>>> &handles) -> sptr<AsyncHandle<vec<sptr<T>>>> {
+        const auto all = whenAll(pool, vec<sptr<AsyncHandleBase>>(handles.begin(), handles.end()));
+        return all->then(JobThread::Worker, [handles](sptr<vec<sptr<AsyncHandleBase>>>) {
+            auto results = std::make_shared<vec<sptr<T>>>();
+            for (const auto &handle : handles)
+                results->push_back(handle->result());
+            return results;
+        });
+    }
+
+    // Resolves with the first handle that resolves. Fails (or gets cancelled) only if none of the handles resolve.
+    inline auto whenAny(JobPool *pool, const vec<sptr<AsyncHandleBase>> &handles) -> sptr<AsyncHandle<AsyncHandleBase>> {
+        auto any = std::make_shared<AsyncHandle<AsyncHandleBase>>(pool);
+        any->inputs_.assign(handles.begin(), handles.end());
+        if (handles.empty()) {
+            any->cancel();
+            return any;
+        }
+
+        any->onSettled([any, handles] {
+            if (any->isCancelled()) {
+                for (const auto &handle : handles)
+                    handle->releaseDependent();
+            }
+        });
+
+        auto remaining = std::make_shared<std::atomic<size_t>>(handles.size());
+        for (const auto &handle : handles) {
+            handle->addDependent();
+            const auto h = handle;
+            handle->onSettled([h, any, remaining] {
+                const auto last = remaining->fetch_sub(1) == 1;
+                switch (h->state()) {
+                    case AsyncHandleBase::State::Resolved:
+                        any->resolve(h);
+                        break;
+                    case AsyncHandleBase::State::Failed:
+                        if (last)
+                            any->fail(h->error());
+                        break;
+                    default:
+                        if (last)
+                            any->cancel();
+                        break;
+                }
+            });
+        }
+
+        return any;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <cstring>
+#include <type_traits>
+
+namespace solo {
+    class BinaryWriter final {
+    public:
+        void write(const void *data, size_t size) {
+            const auto bytes = static_cast<const u8 *>(data);
+            data_.insert(data_.end(), bytes, bytes + size);
+        }
+
+        template <class T>
+        void write(const T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written as is");
+            write(&value, sizeof(T));
+        }
+
+        void writeString(const str &s) {
+            write(static_cast<u32>(s.size()));
+            write(s.data(), s.size());
+        }
+
+        auto data() const -> const vec<u8> & {
+            return data_;
+        }
+
+    private:
+        vec<u8> data_;
+    };
+
+    // Never reads past the end of the data. Once an out-of-bounds read is attempted the reader
+    // is marked as failed and all further reads return zeroes, so callers check isOk() once at the end.
+    class BinaryReader final {
+    public:
+        BinaryReader(const void *data, size_t size):
+            data_(static_cast<const u8 *>(data)),
+            size_(size) {
+        }
+
+        bool isOk() const {
+            return ok_;
+        }
+        bool isAtEnd() const {
+            return pos_ == size_;
+        }
+
+        auto position() const -> size_t {
+            return pos_;
+        }
+
+        void read(void *dst, size_t size) {
+            if (!ok_ || size > size_ - pos_) {
+                ok_ = false;
+                std::memset(dst, 0, size);
+                return;
+            }
+            std::memcpy(dst, data_ + pos_, size);
+            pos_ += size;
+        }
+
+        template <class T>
+        auto read() -> T {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read as is");
+            T value;
+            read(&value, sizeof(T));
+            return value;
+        }
+
+        auto readString() -> str {
+            const auto size = read<u32>();
+            if (!ok_ || size > size_ - pos_) {
+                ok_ = false;
+                return str();
+            }
+            str result(reinterpret_cast<const s8 *>(data_ + pos_), size);
+            pos_ += size;
+            return result;
+        }
+
+    private:
+        const u8 *data_ = nullptr;
+        size_t size_ = 0;
+        size_t pos_ = 0;
+        bool ok_ = true;
+    };
+}
@@ -38,39 +38,44 @@ void Camera::init() {
     transform_ = node_.findComponent<Transform>();
     const auto canvasSize = device_->canvasSize();
     aspectRatio_ = canvasSize.x() / canvasSize.y();
-    dirtyFlags_ |= DIRTY_BIT_ALL_PROJECTION;
+    setDirty(DIRTY_BIT_ALL_PROJECTION);
 }
 
 void Camera::update() {
     if (lastTransformVersion_ != transform_->version()) {
         lastTransformVersion_ = transform_->version();
-        dirtyFlags_ |= DIRTY_BIT_VIEW | DIRTY_BIT_VIEW_PROJECTION | DIRTY_BIT_INV_VIEW | DIRTY_BIT_INV_VIEW_PROJECTION;
+        setDirty(DIRTY_BIT_VIEW | DIRTY_BIT_VIEW_PROJECTION | DIRTY_BIT_INV_VIEW | DIRTY_BIT_INV_VIEW_PROJECTION);
     }
 }
 
+void Camera::setDirty(u32 flags) {
+    dirtyFlags_ |= flags;
+    version_++;
+}
+
 void Camera::setPerspective(bool perspective) {
     ortho_ = !perspective;
-    dirtyFlags_ |= DIRTY_BIT_ALL_PROJECTION;
+    setDirty(DIRTY_BIT_ALL_PROJECTION);
 }
 
 void Camera::setFieldOfView(const Radians &fov) {
     this->fov_ = fov;
-    dirtyFlags_ |= DIRTY_BIT_ALL_PROJECTION;
+    setDirty(DIRTY_BIT_ALL_PROJECTION);
 }
 
 void Camera::setOrthoSize(const Vector2 &size) {
     orthoSize_ = size;
-    dirtyFlags_ |= DIRTY_BIT_ALL_PROJECTION;
+    setDirty(DIRTY_BIT_ALL_PROJECTION);
 }
 
 void Camera::setZFar(float far) {
     this->zFar_ = far;
-    dirtyFlags_ |= DIRTY_BIT_ALL_PROJECTION;
+    setDirty(DIRTY_BIT_ALL_PROJECTION);
 }
 
 void Camera::setZNear(float near) {
     this->zNear_ = near;
-    dirtyFlags_ |= DIRTY_BIT_ALL_PROJECTION;
+    setDirty(DIRTY_BIT_ALL_PROJECTION);
 }
 
 auto Camera::viewMatrix() const -> Matrix {
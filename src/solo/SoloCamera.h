@@ -92,6 +92,11 @@ namespace solo {
             return aspectRatio_;
         }
 
+        // Changes whenever any of the camera matrices changes
+        auto version() const -> u32 {
+            return version_;
+        }
+
         auto viewMatrix() const -> Matrix;
         auto invViewMatrix() const -> Matrix;
         auto projectionMatrix() const -> Matrix;
@@ -117,6 +122,7 @@ namespace solo {
 
         mutable u32 lastTransformVersion_ = ~0;
         mutable u32 dirtyFlags_ = ~0;
+        u32 version_ = 0;
 
         mutable Matrix viewMatrix_;
         mutable Matrix projectionMatrix_;
@@ -125,6 +131,8 @@ namespace solo {
         mutable Matrix invViewProjectionMatrix_;
 
         explicit Camera(const Node &node);
+
+        void setDirty(u32 flags);
     };
 
     template <>
@@ -4,9 +4,10 @@
  */
 
 #include "SoloCommon.h"
-#include "SoloSpinLock.h"
+#include "SoloAdaptiveLock.h"
 #include <iostream>
 #include <fstream>
+#include <mutex>
 
 using namespace solo;
 
@@ -49,10 +50,10 @@ namespace solo {
 
     private:
         std::ofstream file;
-        SpinLock lock;
+        AdaptiveLock lock;
 
         void log(const str &msg, const str &level) {
-            volatile auto lt = lock.acquire();
+            std::lock_guard<AdaptiveLock> lt(lock);
             const auto fullMsg = fmt("[", level, "] ", msg);
             std::cout << fullMsg << std::endl;
             if (file.is_open())
@@ -14,6 +14,7 @@
 #include <memory>
 #include <functional>
 #include <sstream>
+#include <stdexcept>
 
 #if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS)
 #   define SL_WINDOWS
@@ -48,6 +49,7 @@ namespace solo {
     using u16 = uint16_t;
     using s32 = int32_t;
     using u32 = uint32_t;
+    using s64 = int64_t;
     using u64 = uint64_t;
 
     class Device;
@@ -129,4 +131,17 @@ namespace solo {
         if (condition)
             panic(std::forward<TArgs>(args)...);
     }
+
+    // An asset that can't be loaded: a file that can't be opened, a shader that doesn't compile, a truncated image or mesh.
+    // Unlike panics these can be recovered from, async loads fail their handle and hot reload keeps the old asset.
+    class AssetError final: public std::runtime_error {
+    public:
+        explicit AssetError(const str &msg): std::runtime_error(msg) {}
+    };
+
+    template <class... TArgs>
+    void assetErrorIf(bool condition, TArgs &&...args) {
+        if (condition)
+            throw AssetError(fmt(std::forward<TArgs>(args)...));
+    }
 }
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloCookedAssets.h"
+#include "SoloFileSystem.h"
+#include "SoloEnums.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+using namespace solo;
+
+constexpr const char *CookedAssets::effectCacheDirectory;
+
+static const str ManifestFileName = "manifest.txt";
+static const str ManifestHeader = "solo-cooked-assets 1";
+
+static auto normalizePath(str path) -> str {
+    std::replace(path.begin(), path.end(), '\\', '/');
+    return path;
+}
+
+auto CookedAssets::variantFor(DeviceMode mode) -> str {
+    return mode == DeviceMode::Vulkan ? "vulkan" : "opengl";
+}
+
+// Manifest is a text file, one "source<TAB>variant<TAB>hash<TAB>output" line per entry
+CookedAssets::CookedAssets(FileSystem *fs, const str &directory):
+    fs_(fs),
+    directory_(directory) {
+    if (directory_.empty() || !fs_->exists(manifestPath()))
+        return;
+
+    auto first = true;
+    fs_->iterateLines(manifestPath(), [this, &first](const str &line) {
+        if (first) {
+            first = false;
+            if (line != ManifestHeader) {
+                Logger::global().logWarning(fmt("Unsupported cooked asset manifest in ", directory_, ", ignoring it"));
+                return false;
+            }
+            return true;
+        }
+
+        std::istringstream in(line);
+        Entry entry;
+        str hash;
+        if (std::getline(in, entry.source, '\t') && std::getline(in, entry.variant, '\t') &&
+            std::getline(in, hash, '\t') && std::getline(in, entry.output)) {
+            entry.hash = std::stoull(hash, nullptr, 16);
+            entries_[key(entry.source, entry.variant)] = entry;
+        }
+        return true;
+    });
+}
+
+auto CookedAssets::find(const str &sourcePath, const str &variant) const -> str {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.empty())
+        return str();
+
+    // Try every suffix that starts at a path component, longest first
+    const auto path = normalizePath(sourcePath);
+    for (size_t start = 0; start < path.size();) {
+        const auto it = entries_.find(key(path.substr(start), variant));
+        if (it != entries_.end()) {
+            const auto output = directory_ + "/" + it->second.output;
+            return fs_->exists(output) ? output : str();
+        }
+
+        const auto slash = path.find('/', start);
+        if (slash == str::npos)
+            break;
+        start = slash + 1;
+    }
+
+    return str();
+}
+
+void CookedAssets::forget(const str &sourcePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Same suffix match as in find()
+    const auto path = normalizePath(sourcePath);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        const auto source = normalizePath(it->second.source);
+        const auto start = static_cast<s64>(path.size()) - static_cast<s64>(source.size());
+        const auto matches = start >= 0 && path.compare(start, source.size(), source) == 0 && (!start || path[start - 1] == '/');
+        it = matches ? entries_.erase(it) : std::next(it);
+    }
+}
+
+auto CookedAssets::entry(const str &source, const str &variant) const -> const Entry * {
+    const auto it = entries_.find(key(source, variant));
+    return it != entries_.end() ? &it->second : nullptr;
+}
+
+auto CookedAssets::entries() const -> vec<Entry> {
+    vec<Entry> result;
+    for (const auto &pair : entries_)
+        result.push_back(pair.second);
+    std::sort(result.begin(), result.end(), [](const Entry &a, const Entry &b) {
+        return a.source != b.source ? a.source < b.source : a.variant < b.variant;
+    });
+    return result;
+}
+
+void CookedAssets::setEntries(const vec<Entry> &entries) {
+    entries_.clear();
+    for (const auto &entry : entries)
+        entries_[key(entry.source, entry.variant)] = entry;
+}
+
+void CookedAssets::save() const {
+    vec<str> lines{ManifestHeader};
+    for (const auto &entry : entries()) {
+        std::ostringstream line;
+        line << entry.source << '\t' << entry.variant << '\t'
+            << std::hex << std::setw(16) << std::setfill('0') << entry.hash << '\t' << entry.output;
+        lines.push_back(line.str());
+    }
+    fs_->writeLines(manifestPath(), lines);
+}
+
+auto CookedAssets::key(const str &source, const str &variant) -> str {
+    return normalizePath(source) + '\t' + variant;
+}
+
+auto CookedAssets::manifestPath() const -> str {
+    return directory_ + "/" + ManifestFileName;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <mutex>
+
+namespace solo {
+    class FileSystem;
+    enum class DeviceMode;
+
+    // Outputs of the asset cooker and the manifest that maps source assets to them. Sources are
+    // identified by their path relative to the cooked asset root, so lookups work from any working
+    // directory as long as the path ends the same way. Some outputs depend on the device mode,
+    // those are told apart by a variant name.
+    class CookedAssets final {
+    public:
+        struct Entry {
+            str source;
+            str variant;
+            u64 hash;
+            str output; // relative to the cooked asset directory
+        };
+
+        // Subdirectory with compiled effects, in the EffectCache format
+        static constexpr auto effectCacheDirectory = "effect-cache";
+
+        static auto variantFor(DeviceMode mode) -> str;
+
+        CookedAssets(FileSystem *fs, const str &directory);
+        CookedAssets(const CookedAssets &other) = delete;
+        CookedAssets(CookedAssets &&other) = delete;
+        ~CookedAssets() = default;
+
+        auto operator=(const CookedAssets &other) -> CookedAssets & = delete;
+        auto operator=(CookedAssets &&other) -> CookedAssets & = delete;
+
+        bool isEnabled() const {
+            return !directory_.empty();
+        }
+
+        auto directory() const -> const str & {
+            return directory_;
+        }
+
+        // Path of the cooked output, or an empty string when the asset hasn't been cooked
+        auto find(const str &sourcePath, const str &variant = str()) const -> str;
+        // Cooked output if there is one, the source path otherwise
+        auto resolve(const str &sourcePath, const str &variant = str()) const -> str {
+            const auto cooked = find(sourcePath, variant);
+            return cooked.empty() ? sourcePath : cooked;
+        }
+
+        // Drops the entries of a source, e.g. because it has been edited and its cooked outputs are stale.
+        // Loads use the source from then on.
+        void forget(const str &sourcePath);
+
+        auto entry(const str &source, const str &variant) const -> const Entry *;
+        auto entries() const -> vec<Entry>;
+        void setEntries(const vec<Entry> &entries);
+        void save() const;
+
+    private:
+        FileSystem *fs_ = nullptr;
+        str directory_;
+        umap<str, Entry> entries_;
+        // Lookups come from background jobs while forget() is called on the main thread
+        mutable std::mutex mutex_;
+
+        static auto key(const str &source, const str &variant) -> str;
+        auto manifestPath() const -> str;
+    };
+}
@@ -9,6 +9,10 @@
 #include "SoloPhysics.h"
 #include "SoloScriptRuntime.h"
 #include "SoloJobPool.h"
+#include "SoloEffectCache.h"
+#include "SoloCookedAssets.h"
+#include "SoloGeometryArena.h"
+#include "SoloHotReload.h"
 #include "SoloEnums.h"
 #include "SoloDebugInterface.h"
 #include "gl/SoloOpenGLDevice.h"
@@ -51,20 +55,42 @@ void Device::initSubsystems(const DeviceSetup &setup) {
         Logger::global().setOutputFile(setup.logFilePath);
 
     jobPool_ = std::make_shared<JobPool>();
+    jobPool_->setMainThreadBudget(setup.jobCompletionBudget);
     physics_ = Physics::fromDevice(this);
     fs_ = FileSystem::fromDevice(this);
+    cookedAssets_ = std::make_shared<CookedAssets>(fs_.get(), setup.cookedAssetsPath);
+    // The cooker puts compiled effects into the cooked asset directory
+    const auto effectCachePath = setup.effectCachePath.empty() && cookedAssets_->isEnabled()
+        ? cookedAssets_->directory() + "/" + CookedAssets::effectCacheDirectory
+        : setup.effectCachePath;
+    effectCache_ = std::make_shared<EffectCache>(fs_.get(), effectCachePath);
     scriptRuntime_ = ScriptRuntime::fromDevice(this);
     renderer_ = Renderer::fromDevice(this);
+    if (setup.geometryArena)
+        geometryArena_ = GeometryArena::fromDevice(this);
+    if (setup.hotReload) {
+#ifdef SL_HOT_RELOAD
+        hotReload_ = HotReload::fromDevice(this);
+#else
+        Logger::global().logWarning("Hot reload is only available in builds with SL_HOT_RELOAD");
+#endif
+    }
     debugInterface_ = DebugInterface::fromDevice(this);
 }
 
 void Device::shutdownSubsystems() {
     // Order matters
     debugInterface_.reset();
+    hotReload_.reset();
+    if (fs_)
+        fs_->stopAsyncReads();
     jobPool_.reset();
     scriptRuntime_.reset();
     physics_.reset();
+    effectCache_.reset();
+    cookedAssets_.reset();
     fs_.reset();
+    geometryArena_.reset();
     renderer_.reset();
 }
 
@@ -72,6 +98,10 @@ bool Device::hasActiveBackgroundJobs() const {
     return jobPool_->hasActiveJobs();
 }
 
+auto Device::backgroundJobStats() const -> JobStats {
+    return jobPool_->stats();
+}
+
 bool Device::isKeyPressed(KeyCode code, bool firstTime) const {
     const auto where = pressedKeys_.find(code);
     return where != pressedKeys_.end() && (!firstTime || where->second);
@@ -92,7 +122,11 @@ bool Device::isMouseButtonReleased(MouseButton button) const {
 
 void Device::update(const std::function<void()> &update) {
     beginUpdate();
+    if (geometryArena_)
+        geometryArena_->update();
     jobPool_->update(); // TODO add smth like waitForFinish() to Device and wait in it for background tasks to finish
+    if (hotReload_)
+        hotReload_->update();
     physics_->update();
     renderer_->renderFrame([&]() {
         debugInterface_->renderFrame(update);
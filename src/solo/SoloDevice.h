@@ -18,6 +18,11 @@ namespace solo {
     class Physics;
     class ScriptRuntime;
     class JobPool;
+    class JobStats;
+    class EffectCache;
+    class CookedAssets;
+    class GeometryArena;
+    class HotReload;
     enum class KeyCode;
     enum class MouseButton;
 
@@ -52,6 +57,7 @@ namespace solo {
             return quitRequested_;
         }
         bool hasActiveBackgroundJobs() const;
+        auto backgroundJobStats() const -> JobStats;
 
         bool isKeyPressed(KeyCode code, bool firstTime = false) const;
         bool isKeyReleased(KeyCode code) const;
@@ -92,6 +98,20 @@ namespace solo {
         auto jobPool() const -> JobPool * {
             return jobPool_.get();
         }
+        auto effectCache() const -> EffectCache * {
+            return effectCache_.get();
+        }
+        auto cookedAssets() const -> CookedAssets * {
+            return cookedAssets_.get();
+        }
+        // Null unless enabled in DeviceSetup
+        auto geometryArena() const -> GeometryArena * {
+            return geometryArena_.get();
+        }
+        // Null unless enabled in DeviceSetup
+        auto hotReload() const -> HotReload * {
+            return hotReload_.get();
+        }
 
     protected:
         sptr<Renderer> renderer_;
@@ -100,6 +120,10 @@ namespace solo {
         sptr<FileSystem> fs_;
         sptr<ScriptRuntime> scriptRuntime_;
         sptr<JobPool> jobPool_;
+        sptr<EffectCache> effectCache_;
+        sptr<CookedAssets> cookedAssets_;
+        sptr<GeometryArena> geometryArena_;
+        sptr<HotReload> hotReload_;
 
         DeviceMode mode_;
         bool vsync_;
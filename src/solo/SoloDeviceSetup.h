@@ -23,5 +23,23 @@ namespace solo {
 
         str windowTitle;
         str logFilePath;
+
+        /// Directory for compiled effects, caching is disabled when empty
+        str effectCachePath;
+
+        /// Output directory of the asset cooker. Cooked assets are loaded instead of their sources when present.
+        /// Also provides the effect cache when effectCachePath is empty.
+        str cookedAssetsPath;
+
+        /// Milliseconds per frame for finishing background jobs on the main thread (creating GPU resources etc.), 0 means no limit
+        float jobCompletionBudget = 0;
+
+        /// Put meshes loaded from files into shared per-layout vertex and index buffers (see GeometryArena),
+        /// so that drawing them one after another doesn't rebind buffers
+        bool geometryArena = false;
+
+        /// Reload effects, textures and meshes when their files change (see HotReload).
+        /// Only available in builds with SL_HOT_RELOAD (Debug), ignored otherwise.
+        bool hotReload = false;
     };
 }
@@ -8,19 +8,123 @@
 #include "SoloFileSystem.h"
 #include "SoloScriptRuntime.h"
 #include "SoloEnums.h"
+#include "SoloEffectCache.h"
+#include "SoloCookedAssets.h"
+#include "SoloHotReload.h"
+#include "SoloStringUtils.h"
+#include "SoloJobPool.h"
 #include "gl/SoloOpenGLEffect.h"
 #include "vk/SoloVulkanEffect.h"
+#include <atomic>
+#include <cstring>
 
 using namespace solo;
 
+namespace {
+    struct ShaderSources {
+        const s8 *vs;
+        u32 vsSize;
+        const s8 *fs;
+        u32 fsSize;
+    };
+
+    // Everything about an effect that can be prepared off the main thread
+    struct PreparedEffect {
+        str source;
+#ifdef SL_VULKAN_RENDERER
+        VulkanEffect::Shader vs;
+        VulkanEffect::Shader fs;
+#endif
+    };
+}
+
+static auto splitSource(const str &source) -> ShaderSources {
+    const auto vertTagStartIdx = source.find("// VERTEX");
+    assetErrorIf(vertTagStartIdx == std::string::npos, "Vertex shader not found in ", source);
+
+    const auto fragTagStartIdx = source.find("// FRAGMENT");
+    assetErrorIf(fragTagStartIdx == std::string::npos, "Fragment shader not found in ", source);
+
+    const auto vertShaderStartIdx = vertTagStartIdx + std::strlen("// VERTEX");
+    const auto vertShaderEndIdx = fragTagStartIdx > vertTagStartIdx ? fragTagStartIdx - 1 : source.size() - 1;
+
+    const auto fragShaderStartIdx = fragTagStartIdx + std::strlen("// FRAGMENT");
+    const auto fragShaderEndIdx = vertTagStartIdx > fragTagStartIdx ? vertTagStartIdx - 1 : source.size() - 1;
+
+    return {
+        source.c_str() + vertShaderStartIdx,
+        static_cast<u32>(vertShaderEndIdx - vertShaderStartIdx + 1),
+        source.c_str() + fragShaderStartIdx,
+        static_cast<u32>(fragShaderEndIdx - fragShaderStartIdx + 1)
+    };
+}
+
+// Source generated by the asset cooker, empty if the description hasn't been cooked
+static auto cookedSourcePath(Device *device, const str &descriptionPath) -> str {
+    return device->cookedAssets()->find(descriptionPath, CookedAssets::variantFor(device->mode()));
+}
+
+static auto prepareFromDescriptionFile(Device *device, const str &path) -> sptr<PreparedEffect> {
+    auto result = std::make_shared<PreparedEffect>();
+
+    const auto cookedPath = cookedSourcePath(device, path);
+    if (!cookedPath.empty())
+        result->source = device->fileSystem()->readText(cookedPath);
+    else {
+        const auto desc = device->fileSystem()->readText(path);
+
+        // The device script runtime can't be shared between threads, so each job generates
+        // the source in a runtime of its own
+        const auto runtime = ScriptRuntime::fromDevice(device);
+        result->source = runtime->eval("sl.generateEffectSource(" + desc + ")");
+    }
+
+#ifdef SL_VULKAN_RENDERER
+    if (device->mode() == DeviceMode::Vulkan) {
+        const auto sources = splitSource(result->source);
+        result->vs = VulkanEffect::compileShader(device, sources.vs, sources.vsSize, true);
+        result->fs = VulkanEffect::compileShader(device, sources.fs, sources.fsSize, false);
+    }
+#endif
+
+    return result;
+}
+
+static auto fromPrepared(Device *device, const PreparedEffect &prepared) -> sptr<Effect> {
+    (void)prepared; // in builds without a renderer
+    switch (device->mode()) {
+#ifdef SL_OPENGL_RENDERER
+        case DeviceMode::OpenGL:
+            // GL objects belong to the context of the main thread, so compilation has to happen here
+            return Effect::fromSource(device, prepared.source);
+#endif
+#ifdef SL_VULKAN_RENDERER
+        case DeviceMode::Vulkan:
+            return std::make_shared<VulkanEffect>(device, prepared.vs, prepared.fs);
+#endif
+        default:
+            panic("Unknown device mode");
+            return nullptr;
+    }
+}
+
 auto Effect::fromSourceFile(Device *device, const str &path) -> sptr<Effect> {
     const auto source = device->fileSystem()->readText(path);
-    return fromSource(device, source);
+    const auto effect = fromSource(device, source);
+    if (const auto hotReload = device->hotReload())
+        hotReload->trackEffect(effect, path);
+    return effect;
 }
 
 auto Effect::fromDescriptionFile(Device *device, const str &path) -> sptr<Effect> {
-    const auto desc = device->fileSystem()->readText(path);
-    return fromDescription(device, desc);
+    // Tracked by the description path, the cooked source isn't what gets edited
+    const auto cookedPath = cookedSourcePath(device, path);
+    const auto effect = cookedPath.empty()
+        ? fromDescription(device, device->fileSystem()->readText(path))
+        : fromSource(device, device->fileSystem()->readText(cookedPath));
+    if (const auto hotReload = device->hotReload())
+        hotReload->trackEffect(effect, path);
+    return effect;
 }
 
 auto Effect::fromDescription(Device *device, const str &description) -> sptr<Effect> {
@@ -31,30 +135,17 @@ auto Effect::fromDescription(Device *device, const str &description) -> sptr<Eff
 }
 
 auto Effect::fromSource(Device *device, const str &source) -> sptr<Effect> {
-    const auto vertTagStartIdx = source.find("// VERTEX");
-    panicIf(vertTagStartIdx == std::string::npos, "Vertex shader not found in ", source);
-
-    const auto fragTagStartIdx = source.find("// FRAGMENT");
-    panicIf(vertTagStartIdx == std::string::npos, "Fragment shader not found in ", source);
-
-    const auto vertShaderStartIdx = vertTagStartIdx + std::strlen("// VERTEX");
-    const auto vertShaderEndIdx = fragTagStartIdx > vertTagStartIdx ? fragTagStartIdx - 1 : source.size() - 1;
-    const auto vsBytes = source.c_str() + vertShaderStartIdx;
-    const auto vsSize = vertShaderEndIdx - vertShaderStartIdx + 1;
-
-    const auto fragShaderStartIdx = fragTagStartIdx + std::strlen("// FRAGMENT");
-    const auto fragShaderEndIdx = vertTagStartIdx > fragTagStartIdx ? vertTagStartIdx - 1 : source.size() - 1;
-    const auto fsBytes = source.c_str() + fragShaderStartIdx;
-    const auto fsSize = fragShaderEndIdx - fragShaderStartIdx + 1;
+    const auto sources = splitSource(source);
+    (void)sources; // in builds without a renderer
 
     switch (device->mode()) {
 #ifdef SL_OPENGL_RENDERER
         case DeviceMode::OpenGL:
-            return std::make_shared<OpenGLEffect>(vsBytes, vsSize, fsBytes, fsSize);
+            return std::make_shared<OpenGLEffect>(device, sources.vs, sources.vsSize, sources.fs, sources.fsSize);
 #endif
 #ifdef SL_VULKAN_RENDERER
         case DeviceMode::Vulkan:
-            return VulkanEffect::fromSources(device, vsBytes, vsSize, fsBytes, fsSize);
+            return VulkanEffect::fromSources(device, sources.vs, sources.vsSize, sources.fs, sources.fsSize);
 #endif
         default:
             panic("Unknown device mode");
@@ -62,3 +153,99 @@ auto Effect::fromSource(Device *device, const str &source) -> sptr<Effect> {
     }
 }
 
+auto Effect::fromDescriptionFileAsync(Device *device, const str &path) -> sptr<AsyncHandle<Effect>> {
+    return fromDescriptionFilesAsync(device, {path}).front();
+}
+
+auto Effect::fromDescriptionFilesAsync(Device *device, const vec<str> &paths) -> vec<sptr<AsyncHandle<Effect>>> {
+    vec<sptr<AsyncHandle<Effect>>> handles;
+    JobBase<PreparedEffect>::Producers producers;
+    for (const auto &path : paths) {
+        handles.push_back(std::make_shared<AsyncHandle<Effect>>(device->jobPool()));
+        producers.push_back([device, path]() {
+            return prepareFromDescriptionFile(device, path);
+        });
+    }
+
+    // Errors (a bad description, a shader that doesn't compile) fail the handle of their effect, the rest still resolve
+    auto consumer = [device, paths, handles](const vec<sptr<PreparedEffect>> &results, const vec<std::exception_ptr> &errors) {
+        for (size_t i = 0; i < results.size(); i++) {
+            handles[i]->resolveWith([&] {
+                if (errors[i])
+                    std::rethrow_exception(errors[i]);
+                const auto effect = fromPrepared(device, *results[i]);
+                if (const auto hotReload = device->hotReload())
+                    hotReload->trackEffect(effect, paths[i]);
+                return effect;
+            });
+        }
+    };
+
+    device->jobPool()->addJob(std::make_shared<JobBase<PreparedEffect>>(producers, consumer));
+
+    return handles;
+}
+
+static auto nextRevision() -> u64 {
+    // Effects are created by background jobs too
+    static std::atomic<u64> revision{0};
+    return ++revision;
+}
+
+Effect::Effect():
+    revision_(nextRevision()) {
+}
+
+void Effect::swapContents(Effect &other) {
+    std::swap(parameterHandles_, other.parameterHandles_);
+    std::swap(parameters_, other.parameters_);
+    std::swap(parameterBlockSize_, other.parameterBlockSize_);
+    revision_ = nextRevision();
+    other.revision_ = nextRevision();
+}
+
+bool Effect::hasParameter(const str &name) const {
+    return parameterHandles_.count(parameterKey(name));
+}
+
+auto Effect::parameterHandle(const str &name) const -> u32 {
+    const auto it = parameterHandles_.find(parameterKey(name));
+    panicIf(it == parameterHandles_.end(), "Unknown material parameter ", name);
+    return it->second;
+}
+
+auto Effect::addParameter(const str &name, u32 offset, u32 size) -> u32 {
+    const auto handle = static_cast<u32>(parameters_.size());
+    parameterHandles_[name] = handle;
+    parameters_.push_back({name, offset, size});
+    parameterBlockSize_ = std::max(parameterBlockSize_, offset + size);
+    return handle;
+}
+
+void Effect::precompile(EffectCache *cache, DeviceMode mode, const str &source) {
+#ifdef SL_VULKAN_RENDERER
+    if (mode == DeviceMode::Vulkan) {
+        const auto sources = splitSource(source);
+        VulkanEffect::compileShader(cache, sources.vs, sources.vsSize, true);
+        VulkanEffect::compileShader(cache, sources.fs, sources.fsSize, false);
+    }
+#else
+    (void)cache;
+    (void)mode;
+    (void)source;
+#endif
+}
+
+void Effect::warmCache(Device *device, const str &directory) {
+    if (!device->effectCache()->isEnabled()) {
+        Logger::global().logWarning(fmt("Effect cache is disabled, not warming it from ", directory));
+        return;
+    }
+
+    for (const auto &path : device->fileSystem()->listFiles(directory)) {
+        if (stringutils::endsWith(path, ".lua"))
+            fromDescriptionFile(device, path);
+        else if (stringutils::endsWith(path, ".effect"))
+            fromSourceFile(device, path);
+    }
+}
@@ -6,9 +6,13 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloAsyncHandle.h"
+#include <algorithm>
 
 namespace solo {
     class Device;
+    class EffectCache;
+    enum class DeviceMode;
 
     class Effect {
     public:
@@ -17,6 +21,19 @@ namespace solo {
         static auto fromSource(Device *device, const str &source) -> sptr<Effect>;
         static auto fromDescription(Device *device, const str &description) -> sptr<Effect>;
 
+        // Source generation and shader compilation run in background jobs, only the final
+        // driver objects are created on the main thread
+        static auto fromDescriptionFileAsync(Device *device, const str &path) -> sptr<AsyncHandle<Effect>>;
+        static auto fromDescriptionFilesAsync(Device *device, const vec<str> &paths) -> vec<sptr<AsyncHandle<Effect>>>;
+
+        // Compiles all effect descriptions (*.lua) and sources (*.effect) found in the directory
+        // so that later loads hit the device effect cache
+        static void warmCache(Device *device, const str &directory);
+
+        // Compiles a generated effect source into the cache without creating any driver objects,
+        // for backends that compile ahead of time. Used by the asset cooker.
+        static void precompile(EffectCache *cache, DeviceMode mode, const str &source);
+
         Effect(const Effect &other) = delete;
         Effect(Effect &&other) = delete;
         virtual ~Effect() = default;
@@ -24,7 +41,62 @@ namespace solo {
         auto operator=(const Effect &other) -> Effect & = delete;
         auto operator=(Effect &&other) -> Effect & = delete;
 
+        // Material parameters are addressed by handles, which are indices in [0, parameterCount())
+        bool hasParameter(const str &name) const;
+        auto parameterHandle(const str &name) const -> u32;
+        auto parameterCount() const -> u32 {
+            return static_cast<u32>(parameters_.size());
+        }
+        auto parameterName(u32 handle) const -> const str & {
+            return parameters_.at(handle).name;
+        }
+
+        // Materials keep parameter values in a block of this size, laid out
+        // so that backends can upload it without repacking
+        auto parameterBlockSize() const -> u32 {
+            return parameterBlockSize_;
+        }
+        auto parameterOffset(u32 handle) const -> u32 {
+            return parameters_[handle].offset;
+        }
+        auto parameterSize(u32 handle) const -> u32 {
+            return parameters_[handle].size;
+        }
+
+        // Changes whenever the contents are swapped, unique across effects. Whatever was set up
+        // for an effect (vertex arrays, pipelines, material parameter layouts) is stale once it changes.
+        auto revision() const -> u64 {
+            return revision_;
+        }
+
+        // Exchanges shaders and parameters with another effect of the same backend.
+        // Used by hot reload (see HotReload) to update live effects in place.
+        virtual void swapContents(Effect &other);
+
     protected:
-        Effect() = default;
+        Effect();
+
+        // Size is zero for parameters that have no place in the block, like samplers
+        auto addParameter(const str &name, u32 offset, u32 size) -> u32;
+        void reserveParameterBlock(u32 size) {
+            parameterBlockSize_ = std::max(parameterBlockSize_, size);
+        }
+
+        // Maps material parameter names (like "buffer:member") to the names under which backends register them
+        virtual auto parameterKey(const str &name) const -> str {
+            return name;
+        }
+
+    private:
+        struct ParameterInfo {
+            str name;
+            u32 offset;
+            u32 size;
+        };
+
+        umap<str, u32> parameterHandles_;
+        vec<ParameterInfo> parameters_;
+        u32 parameterBlockSize_ = 0;
+        u64 revision_ = 0;
     };
 }
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloEffectCache.h"
+#include "SoloFileSystem.h"
+#include "SoloMappedFile.h"
+#include "SoloBinaryIO.h"
+#include "SoloHash.h"
+#include <atomic>
+#include <cstdio>
+#include <iomanip>
+#include <thread>
+
+using namespace solo;
+
+static constexpr u32 EntryMagic = 0x43454c53; // "SLEC"
+static constexpr u32 EntryVersion = 1;
+
+EffectCache::EffectCache(FileSystem *fs, const str &directory):
+    fs_(fs),
+    directory_(directory) {
+    if (directory_.empty())
+        return;
+
+    enabled_ = fs_->createDirectory(directory_);
+    if (!enabled_)
+        Logger::global().logWarning(fmt("Unable to create effect cache directory ", directory_, ", effect caching disabled"));
+}
+
+auto EffectCache::entryPath(u64 key) const -> str {
+    std::ostringstream out;
+    out << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return out.str();
+}
+
+bool EffectCache::read(u64 key, vec<u8> &data) const {
+    if (!enabled_)
+        return false;
+
+    const auto path = entryPath(key);
+    if (!fs_->exists(path))
+        return false;
+
+    const auto file = fs_->map(path);
+    BinaryReader reader{file->data(), file->size()};
+    const auto magic = reader.read<u32>();
+    const auto version = reader.read<u32>();
+    const auto storedKey = reader.read<u64>();
+    const auto payloadSize = reader.read<u64>();
+    const auto payloadHash = reader.read<u64>();
+
+    // Entries can be truncated by a crash or a concurrent write, treat anything suspicious as a miss
+    if (!reader.isOk() || magic != EntryMagic || version != EntryVersion || storedKey != key ||
+        payloadSize != file->size() - reader.position()) {
+        return false;
+    }
+
+    const auto payload = file->data() + reader.position();
+    if (hashBytes(payload, payloadSize) != payloadHash)
+        return false;
+
+    data.assign(payload, payload + payloadSize);
+    return true;
+}
+
+void EffectCache::write(u64 key, const vec<u8> &data) const {
+    if (!enabled_)
+        return;
+
+    BinaryWriter writer;
+    writer.write(EntryMagic);
+    writer.write(EntryVersion);
+    writer.write(key);
+    writer.write(static_cast<u64>(data.size()));
+    writer.write(hashBytes(data.data(), data.size()));
+    writer.write(data.data(), data.size());
+
+    // Readers map entries, and truncating a mapped file under them crashes them. Workers compiling the same
+    // stage write the same entry, so each writes a file of its own and moves it over the entry in one go.
+    static std::atomic<u32> tempCounter{0};
+    const auto path = entryPath(key);
+    const auto tempPath = fmt(path, ".", std::hash<std::thread::id>()(std::this_thread::get_id()), ".", tempCounter++, ".tmp");
+    fs_->writeBytes(tempPath, writer.data());
+    // Fails on Windows when the entry exists, which means another writer has already stored the same contents
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        std::remove(tempPath.c_str());
+}
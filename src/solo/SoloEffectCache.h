@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo {
+    class FileSystem;
+
+    // Content-addressed on-disk storage for compiled effect artifacts. Keys are hashes of everything
+    // that affects the compilation result, so stale entries are never hit, only left orphaned.
+    class EffectCache final {
+    public:
+        EffectCache(FileSystem *fs, const str &directory);
+        EffectCache(const EffectCache &other) = delete;
+        EffectCache(EffectCache &&other) = delete;
+        ~EffectCache() = default;
+
+        auto operator=(const EffectCache &other) -> EffectCache & = delete;
+        auto operator=(EffectCache &&other) -> EffectCache & = delete;
+
+        bool isEnabled() const {
+            return enabled_;
+        }
+
+        bool read(u64 key, vec<u8> &data) const;
+        void write(u64 key, const vec<u8> &data) const;
+
+    private:
+        FileSystem *fs_ = nullptr;
+        str directory_;
+        bool enabled_ = false;
+
+        auto entryPath(u64 key) const -> str;
+    };
+}
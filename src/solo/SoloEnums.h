@@ -114,6 +114,12 @@ namespace solo {
         Bits32 = sizeof(u32)
     };
 
+    // Whether a mesh keeps its vertices and indices on the CPU after uploading them
+    enum class MeshCpuData {
+        Keep,
+        Release
+    };
+
     enum class TextureWrap {
         ClampToEdge = 0,
         ClampToBorder,
@@ -160,4 +166,17 @@ namespace solo {
         Tangent,
         Binormal
     };
+
+    // How attribute components are stored. Anything but Float is converted to floats by the GPU when
+    // vertices are fetched. Octahedral stores a unit vector as two 16-bit components, shaders decode
+    // it with sl_decodeOctahedral.
+    enum class VertexAttributeFormat {
+        Float,
+        Half,
+        SNorm16,
+        UNorm16,
+        SNorm8,
+        UNorm8,
+        Octahedral
+    };
 }
\ No newline at end of file
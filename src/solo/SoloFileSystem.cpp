@@ -5,23 +5,192 @@
 
 #include "SoloFileSystem.h"
 #include "SoloDevice.h"
+#include "SoloMappedFile.h"
+#include "SoloPackFile.h"
+#include "SoloAsyncFileReader.h"
+#include "SoloAsyncHandle.h"
+#include "SoloJobPool.h"
+#include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef SL_WINDOWS
+#   include <windows.h>
+#   include <direct.h>
+#else
+#   include <dirent.h>
+#endif
 
 using namespace solo;
 
+static auto normalizePath(str path) -> str {
+    std::replace(path.begin(), path.end(), '\\', '/');
+    while (path.size() > 1 && path.back() == '/')
+        path.pop_back();
+    return path;
+}
+
+// Part of `path` after `mountPoint`, empty for the mount point itself
+static bool relativeTo(const str &mountPoint, const str &path, str &relative) {
+    if (mountPoint.empty()) {
+        relative = path;
+        return true;
+    }
+    if (path.compare(0, mountPoint.size(), mountPoint) != 0)
+        return false;
+    if (path.size() == mountPoint.size()) {
+        relative.clear();
+        return true;
+    }
+    if (path[mountPoint.size()] != '/')
+        return false;
+    relative = path.substr(mountPoint.size() + 1);
+    return true;
+}
+
+static bool isFile(const str &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && !(info.st_mode & S_IFDIR);
+}
+
+// Part of the range that is inside a file of the given size
+static void clampRange(u64 fileSize, u64 &offset, u64 &size) {
+    offset = (std::min)(offset, fileSize);
+    size = (std::min)(size, fileSize - offset);
+}
+
+static auto toString(const MappedFile &file) -> str {
+    return str(reinterpret_cast<const s8 *>(file.data()), file.size());
+}
+
+static auto listLoose(const str &directory, bool directories) -> vec<str> {
+    vec<str> result;
+
+#ifdef SL_WINDOWS
+    WIN32_FIND_DATAA data;
+    const auto handle = FindFirstFileA((directory + "/*").c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE)
+        return result;
+    do {
+        const str name = data.cFileName;
+        const auto isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (isDirectory == directories && name != "." && name != "..")
+            result.push_back(directory + "/" + name);
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+#else
+    const auto dir = opendir(directory.c_str());
+    if (!dir)
+        return result;
+    while (const auto entry = readdir(dir)) {
+        const str name = entry->d_name;
+        const auto path = directory + "/" + name;
+        struct stat info;
+        if (name == "." || name == ".." || stat(path.c_str(), &info) != 0)
+            continue;
+        if (directories ? S_ISDIR(info.st_mode) : S_ISREG(info.st_mode))
+            result.push_back(path);
+    }
+    closedir(dir);
+#endif
+
+    return result;
+}
+
 auto FileSystem::fromDevice(Device *device) -> sptr<FileSystem> {
-    return std::unique_ptr<FileSystem>(new FileSystem());
+    auto result = std::unique_ptr<FileSystem>(new FileSystem());
+    result->jobPool_ = device ? device->jobPool() : nullptr;
+    return result;
+}
+
+FileSystem::~FileSystem() = default;
+
+void FileSystem::mountPack(const str &packPath, const str &mountPoint) {
+    mounts_.push_back(Mount{normalizePath(mountPoint), str(), PackFile::fromPath(packPath)});
+}
+
+void FileSystem::mountDirectory(const str &directory, const str &mountPoint) {
+    mounts_.push_back(Mount{normalizePath(mountPoint), normalizePath(directory), nullptr});
+}
+
+auto FileSystem::locate(const str &path) const -> Location {
+    if (mounts_.empty())
+        return Location{nullptr, path};
+
+    const auto normalized = normalizePath(path);
+    str relative;
+    for (auto mount = mounts_.rbegin(); mount != mounts_.rend(); ++mount) {
+        if (!relativeTo(mount->point, normalized, relative) || relative.empty())
+            continue;
+        if (mount->pack) {
+            if (mount->pack->contains(relative))
+                return Location{mount->pack.get(), relative};
+        } else {
+            auto loose = mount->directory + "/" + relative;
+            if (isFile(loose))
+                return Location{nullptr, std::move(loose)};
+        }
+    }
+
+    return Location{nullptr, path};
+}
+
+auto FileSystem::localPath(const str &path) const -> str {
+    const auto location = locate(path);
+    return location.pack ? str() : location.path;
+}
+
+// Virtual paths of files or subdirectories that the mounts have in the directory
+auto FileSystem::listMounted(const str &directory, bool directories) const -> vec<str> {
+    vec<str> result;
+    const auto normalized = normalizePath(directory);
+    str relative;
+
+    for (const auto &mount : mounts_) {
+        if (!relativeTo(mount.point, normalized, relative))
+            continue;
+
+        if (!mount.pack) {
+            const auto looseDirectory = relative.empty() ? mount.directory : mount.directory + "/" + relative;
+            for (const auto &path : listLoose(looseDirectory, directories))
+                result.push_back(directory + path.substr(looseDirectory.size()));
+            continue;
+        }
+
+        const auto prefix = relative.empty() ? relative : relative + "/";
+        for (const auto &name : mount.pack->entryNames()) {
+            if (name.compare(0, prefix.size(), prefix) != 0)
+                continue;
+            const auto slash = name.find('/', prefix.size());
+            if (directories && slash != str::npos)
+                result.push_back(directory + "/" + name.substr(prefix.size(), slash - prefix.size()));
+            else if (!directories && slash == str::npos)
+                result.push_back(directory + "/" + name.substr(prefix.size()));
+        }
+    }
+
+    return result;
 }
 
 auto FileSystem::stream(const str &path) -> sptr<std::istream> {
-    std::ifstream file{path};
+    const auto location = locate(path);
+    if (location.pack)
+        return std::make_shared<std::istringstream>(toString(*location.pack->open(location.path)));
+
+    std::ifstream file{location.path};
     panicIf(!file.is_open(), "Unable to open read stream for file ", path);
     return std::make_shared<std::ifstream>(std::move(file));
 }
 
 auto FileSystem::readBytes(const str &path) -> vec<u8> {
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    panicIf(!file.is_open(), "Unable to open file ", path);
+    const auto location = locate(path);
+    if (location.pack) {
+        const auto file = location.pack->open(location.path);
+        return vec<u8>(file->data(), file->data() + file->size());
+    }
+
+    std::ifstream file(location.path, std::ios::binary | std::ios::ate);
+    assetErrorIf(!file.is_open(), "Unable to open file ", path);
 
     const auto size = file.tellg();
     file.seekg(0, std::ios::beg);
@@ -32,6 +201,68 @@ auto FileSystem::readBytes(const str &path) -> vec<u8> {
     return result;
 }
 
+auto FileSystem::asyncReader() -> AsyncFileReader * {
+    // Threads are only started for file systems that actually read asynchronously
+    std::call_once(asyncReaderCreated_, [this] {
+        if (!jobPool_) {
+            ownJobPool_ = std::make_unique<JobPool>();
+            jobPool_ = ownJobPool_.get();
+        }
+        asyncReader_ = AsyncFileReader::create();
+    });
+    return asyncReader_.get();
+}
+
+void FileSystem::stopAsyncReads() {
+    std::call_once(asyncReaderCreated_, [] {});
+    asyncReader_.reset();
+}
+
+auto FileSystem::readBytesAsync(const str &path) -> sptr<AsyncHandle<vec<u8>>> {
+    return readRangeAsync(path, 0, AsyncFileReader::toEnd);
+}
+
+auto FileSystem::readRangeAsync(const str &path, u64 offset, u64 size) -> sptr<AsyncHandle<vec<u8>>> {
+    const auto reader = asyncReader();
+    if (!reader) {
+        const auto cancelled = std::make_shared<AsyncHandle<vec<u8>>>(jobPool_);
+        cancelled->cancel();
+        return cancelled;
+    }
+
+    const auto location = locate(path);
+    auto filePath = location.path;
+
+    if (location.pack) {
+        u64 entryOffset, entrySize;
+        if (!location.pack->entryRange(location.path, entryOffset, entrySize)) {
+            // Compressed entries get decompressed as a whole anyway
+            const auto pack = location.pack;
+            const auto name = location.path;
+            return AsyncHandle<vec<u8>>::run(jobPool_, JobThread::Worker, [pack, name, offset, size] {
+                const auto file = pack->open(name);
+                auto rangeOffset = offset, rangeSize = size;
+                clampRange(file->size(), rangeOffset, rangeSize);
+                const auto begin = file->data() + rangeOffset;
+                return std::make_shared<vec<u8>>(begin, begin + rangeSize);
+            });
+        }
+
+        clampRange(entrySize, offset, size);
+        offset += entryOffset;
+        filePath = location.pack->path();
+    }
+
+    auto handle = std::make_shared<AsyncHandle<vec<u8>>>(jobPool_);
+    reader->read(filePath, offset, size, [handle](sptr<vec<u8>> data, std::exception_ptr error) {
+        if (error)
+            handle->fail(error);
+        else
+            handle->resolve(data);
+    });
+    return handle;
+}
+
 void FileSystem::writeBytes(const str &path, const vec<u8> &data) {
     std::ofstream file(path, std::ios::binary | std::ios::trunc);
     panicIf(!file.is_open(), "Unable to open file ", path);
@@ -39,8 +270,17 @@ void FileSystem::writeBytes(const str &path, const vec<u8> &data) {
     file.close();
 }
 
+auto FileSystem::map(const str &path) -> sptr<MappedFile> {
+    const auto location = locate(path);
+    return location.pack ? location.pack->open(location.path) : MappedFile::fromPath(location.path);
+}
+
 auto FileSystem::readText(const str &path) -> str {
-    std::ifstream f(path);
+    const auto location = locate(path);
+    if (location.pack)
+        return toString(*location.pack->open(location.path));
+
+    std::ifstream f(location.path);
     auto result = str(std::istreambuf_iterator<s8>(f), std::istreambuf_iterator<s8>());
     return result;
 }
@@ -55,7 +295,20 @@ auto FileSystem::readLines(const str &path) -> vec<str> {
 }
 
 void FileSystem::iterateLines(const str &path, std::function<bool(const str &)> process) {
-    std::ifstream file(path);
+    const auto location = locate(path);
+    if (location.pack) {
+        // Same lines as std::getline below produces, including the empty one after a trailing newline
+        const auto text = toString(*location.pack->open(location.path));
+        for (size_t start = 0;;) {
+            const auto end = text.find('\n', start);
+            if (!process(text.substr(start, end == str::npos ? str::npos : end - start)) || end == str::npos)
+                break;
+            start = end + 1;
+        }
+        return;
+    }
+
+    std::ifstream file(location.path);
     panicIf(!file.is_open(), "Unable to open file ", path);
     while (!file.eof()) {
         str line;
@@ -76,3 +329,45 @@ void FileSystem::writeLines(const str &path, const vec<str> &lines) {
     }
     file.close();
 }
+
+bool FileSystem::exists(const str &path) {
+    const auto location = locate(path);
+    if (location.pack)
+        return true;
+    struct stat info;
+    return stat(location.path.c_str(), &info) == 0;
+}
+
+auto FileSystem::listFiles(const str &directory) -> vec<str> {
+    auto result = listLoose(directory, false);
+    if (mounts_.empty())
+        return result;
+
+    for (const auto &path : listMounted(directory, false)) {
+        if (std::find(result.begin(), result.end(), path) == result.end())
+            result.push_back(path);
+    }
+    return result;
+}
+
+auto FileSystem::listDirectories(const str &directory) -> vec<str> {
+    auto result = listLoose(directory, true);
+    if (mounts_.empty())
+        return result;
+
+    for (const auto &path : listMounted(directory, true)) {
+        if (std::find(result.begin(), result.end(), path) == result.end())
+            result.push_back(path);
+    }
+    return result;
+}
+
+bool FileSystem::createDirectory(const str &path) {
+    if (exists(path))
+        return true;
+#ifdef SL_WINDOWS
+    return _mkdir(path.c_str()) == 0;
+#else
+    return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
@@ -7,32 +7,91 @@
 
 #include "SoloCommon.h"
 #include <functional>
+#include <mutex>
 
 namespace solo {
     class Device;
+    class MappedFile;
+    class PackFile;
+    class JobPool;
+    class AsyncFileReader;
+    template <class T> class AsyncHandle;
 
+    // Reads go through mounts: a pack or a directory mounted at some path serves the files under that path,
+    // later mounts shadowing earlier ones. Paths not served by any mount are read from disk as is. Writes always go to disk.
+    // Mounts are not synchronized with reads, so everything should be mounted before loading assets.
     class FileSystem {
     public:
         static auto fromDevice(Device *device) -> sptr<FileSystem>;
 
         FileSystem(const FileSystem &other) = delete;
         FileSystem(FileSystem &&other) = delete;
-        virtual ~FileSystem() = default;
+        virtual ~FileSystem();
 
         auto operator=(const FileSystem &other) -> FileSystem & = delete;
         auto operator=(FileSystem &&other) -> FileSystem & = delete;
 
+        // See PackFile::build
+        void mountPack(const str &packPath, const str &mountPoint);
+        // E.g. the source asset directory over a pack of the same assets, for editing them without repacking
+        void mountDirectory(const str &directory, const str &mountPoint);
+
         virtual auto stream(const str &path) -> sptr<std::istream>;
 
         virtual auto readBytes(const str &path) -> vec<u8>;
         virtual void writeBytes(const str &path, const vec<u8> &data);
 
+        // Resolved on an I/O thread (see AsyncFileReader), without blocking a worker while the file is being read.
+        // Ranges past the end of the file come out shorter. A file system created without a device runs its own job pool.
+        virtual auto readBytesAsync(const str &path) -> sptr<AsyncHandle<vec<u8>>>;
+        virtual auto readRangeAsync(const str &path, u64 offset, u64 size) -> sptr<AsyncHandle<vec<u8>>>;
+        // Finishes the reads in flight and stops the I/O threads, further async reads come back cancelled.
+        // Device calls it before its job pool goes away.
+        void stopAsyncReads();
+
+        // Contents are read lazily, so this is the way to go for large files that are consumed as is.
+        // This is also the readBytes variant that doesn't copy: pack entries are views into the mapped pack.
+        virtual auto map(const str &path) -> sptr<MappedFile>;
+
         virtual auto readText(const str &path) -> str;
         virtual auto readLines(const str &path) -> vec<str>;
         virtual void iterateLines(const str &path, std::function<bool(const str &)> process);
         virtual void writeLines(const str &path, const vec<str> &lines);
 
+        virtual bool exists(const str &path);
+        virtual auto listFiles(const str &directory) -> vec<str>;
+        virtual auto listDirectories(const str &directory) -> vec<str>;
+        virtual bool createDirectory(const str &path);
+
+        // File on disk that reads of the path go to, empty when a pack serves it
+        auto localPath(const str &path) const -> str;
+
     protected:
         FileSystem() = default;
+
+    private:
+        struct Mount {
+            str point;
+            str directory;
+            sptr<PackFile> pack;
+        };
+
+        // Where a file is read from: an entry of a pack or a path on disk
+        struct Location {
+            const PackFile *pack;
+            str path;
+        };
+
+        vec<Mount> mounts_;
+
+        JobPool *jobPool_ = nullptr;
+        uptr<JobPool> ownJobPool_;
+        // After the own job pool, so that reads still in flight are finished before the pool goes away
+        sptr<AsyncFileReader> asyncReader_;
+        std::once_flag asyncReaderCreated_;
+
+        auto asyncReader() -> AsyncFileReader *;
+        auto locate(const str &path) const -> Location;
+        auto listMounted(const str &directory, bool directories) const -> vec<str>;
     };
 }
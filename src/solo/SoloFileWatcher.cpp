@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloFileWatcher.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#if defined(SL_LINUX)
+#   include <sys/eventfd.h>
+#   include <sys/inotify.h>
+#   include <poll.h>
+#   include <unistd.h>
+#elif defined(SL_WINDOWS)
+#   include <windows.h>
+#else
+#   include <condition_variable>
+#   include <dirent.h>
+#   include <sys/stat.h>
+#endif
+
+using namespace solo;
+
+// How long no new changes must come before the pending ones make up a batch
+static constexpr s32 quietPeriodMs = 10;
+// Where changes can't be waited for
+static constexpr s32 pollIntervalMs = 10;
+
+#if defined(SL_LINUX)
+
+namespace {
+    class InotifyBackend final: public FileWatcher::Backend {
+    public:
+        static auto create() -> uptr<InotifyBackend> {
+            auto backend = std::make_unique<InotifyBackend>();
+            backend->inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            backend->stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (backend->inotifyFd_ < 0 || backend->stopFd_ < 0)
+                return nullptr;
+            return backend;
+        }
+
+        ~InotifyBackend() {
+            if (inotifyFd_ >= 0)
+                close(inotifyFd_);
+            if (stopFd_ >= 0)
+                close(stopFd_);
+        }
+
+        void watch(const str &directory) override {
+            // Saving via a temp file and a rename shows up as IN_MOVED_TO, writing in place as IN_CLOSE_WRITE
+            const auto wd = inotify_add_watch(inotifyFd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0) {
+                Logger::global().logWarning(fmt("Failed to watch ", directory));
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            directories_[wd] = directory;
+        }
+
+        bool wait(s32 timeoutMs, vec<str> &changed) override {
+            pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {stopFd_, POLLIN, 0}};
+            const auto ready = poll(fds, 2, timeoutMs);
+            if (ready > 0 && fds[1].revents)
+                return false;
+            if (ready <= 0)
+                return true; // timeout or EINTR
+
+            alignas(inotify_event) s8 buffer[4096];
+            const auto size = read(inotifyFd_, buffer, sizeof(buffer));
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto p = buffer; size > 0 && p < buffer + size;) {
+                const auto event = reinterpret_cast<const inotify_event *>(p);
+                p += sizeof(inotify_event) + event->len;
+                const auto dir = directories_.find(event->wd);
+                if (event->len && dir != directories_.end())
+                    changed.push_back(dir->second + "/" + event->name);
+            }
+            return true;
+        }
+
+        void stop() override {
+            const uint64_t one = 1;
+            (void) write(stopFd_, &one, sizeof(one));
+        }
+
+    private:
+        int inotifyFd_ = -1;
+        int stopFd_ = -1;
+        std::mutex mutex_;
+        umap<int, str> directories_; // by watch descriptor
+    };
+}
+
+static auto createBackend() -> uptr<FileWatcher::Backend> {
+    return InotifyBackend::create();
+}
+
+#elif defined(SL_WINDOWS)
+
+namespace {
+    class WindowsBackend final: public FileWatcher::Backend {
+    public:
+        static auto create() -> uptr<WindowsBackend> {
+            auto backend = std::make_unique<WindowsBackend>();
+            backend->stopEvent_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            backend->wakeEvent_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+            if (!backend->stopEvent_ || !backend->wakeEvent_)
+                return nullptr;
+            return backend;
+        }
+
+        ~WindowsBackend() {
+            for (const auto &dir : directories_) {
+                CancelIoEx(dir->handle, &dir->overlapped);
+                DWORD bytes;
+                GetOverlappedResult(dir->handle, &dir->overlapped, &bytes, TRUE);
+                CloseHandle(dir->overlapped.hEvent);
+                CloseHandle(dir->handle);
+            }
+            if (stopEvent_)
+                CloseHandle(stopEvent_);
+            if (wakeEvent_)
+                CloseHandle(wakeEvent_);
+        }
+
+        // Directory handles are owned by the watcher thread, which picks new ones up when woken
+        void watch(const str &directory) override {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                added_.push_back(directory);
+            }
+            SetEvent(wakeEvent_);
+        }
+
+        bool wait(s32 timeoutMs, vec<str> &changed) override {
+            while (true) {
+                openAdded();
+
+                vec<HANDLE> events{stopEvent_, wakeEvent_};
+                for (const auto &dir : directories_)
+                    events.push_back(dir->overlapped.hEvent);
+
+                const auto result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE,
+                    timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+                if (result == WAIT_TIMEOUT || result == WAIT_FAILED)
+                    return true;
+
+                const auto index = result - WAIT_OBJECT_0;
+                if (index == 0)
+                    return false;
+                if (index == 1)
+                    continue;
+
+                readChanges(*directories_[index - 2], changed);
+                return true;
+            }
+        }
+
+        void stop() override {
+            SetEvent(stopEvent_);
+        }
+
+    private:
+        struct Directory {
+            str path;
+            HANDLE handle;
+            OVERLAPPED overlapped;
+            alignas(DWORD) u8 buffer[16 * 1024];
+        };
+
+        HANDLE stopEvent_ = nullptr;
+        HANDLE wakeEvent_ = nullptr;
+        std::mutex mutex_;
+        vec<str> added_;
+        vec<uptr<Directory>> directories_;
+
+        void openAdded() {
+            vec<str> added;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                added.swap(added_);
+            }
+
+            for (const auto &path : added) {
+                // Two of the wait slots are taken by the stop and wake events
+                if (directories_.size() + 2 >= MAXIMUM_WAIT_OBJECTS) {
+                    Logger::global().logWarning(fmt("Too many watched directories, not watching ", path));
+                    continue;
+                }
+
+                auto dir = std::make_unique<Directory>();
+                dir->path = path;
+                dir->handle = CreateFileA(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+                if (dir->handle == INVALID_HANDLE_VALUE) {
+                    Logger::global().logWarning(fmt("Failed to watch ", path));
+                    continue;
+                }
+
+                ZeroMemory(&dir->overlapped, sizeof(dir->overlapped));
+                dir->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+                if (!issueRead(*dir)) {
+                    Logger::global().logWarning(fmt("Failed to watch ", path));
+                    CloseHandle(dir->overlapped.hEvent);
+                    CloseHandle(dir->handle);
+                    continue;
+                }
+                directories_.push_back(std::move(dir));
+            }
+        }
+
+        static bool issueRead(Directory &dir) {
+            // Saving in place changes the last write time, saving via a temp file and a rename changes the file name
+            return ReadDirectoryChangesW(dir.handle, dir.buffer, sizeof(dir.buffer), FALSE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &dir.overlapped, nullptr) != 0;
+        }
+
+        static void readChanges(Directory &dir, vec<str> &changed) {
+            DWORD size = 0;
+            if (GetOverlappedResult(dir.handle, &dir.overlapped, &size, FALSE) && size > 0) {
+                for (auto p = dir.buffer;;) {
+                    const auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(p);
+                    if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                        const auto length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+                        str name(WideCharToMultiByte(CP_ACP, 0, info->FileName, length, nullptr, 0, nullptr, nullptr), '\0');
+                        WideCharToMultiByte(CP_ACP, 0, info->FileName, length, &name[0], static_cast<int>(name.size()), nullptr, nullptr);
+                        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                        changed.push_back(dir.path + "/" + name);
+                    }
+                    if (!info->NextEntryOffset)
+                        break;
+                    p += info->NextEntryOffset;
+                }
+            }
+            // A zero size means the buffer overflowed and the changes are lost, there is nothing better to do than to go on
+            issueRead(dir);
+        }
+    };
+}
+
+static auto createBackend() -> uptr<FileWatcher::Backend> {
+    return WindowsBackend::create();
+}
+
+#else
+
+namespace {
+    // Compares modification times of the files in the watched directories a few dozen times a second
+    class PollingBackend final: public FileWatcher::Backend {
+    public:
+        void watch(const str &directory) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            scan(directory, snapshots_[directory]);
+        }
+
+        bool wait(s32 timeoutMs, vec<str> &changed) override {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                if (stopCondition_.wait_for(lock, std::chrono::milliseconds(pollIntervalMs), [this] { return stopping_; }))
+                    return false;
+
+                for (auto &snapshot : snapshots_) {
+                    Snapshot current;
+                    scan(snapshot.first, current);
+                    for (const auto &file : current) {
+                        const auto previous = snapshot.second.find(file.first);
+                        if (previous == snapshot.second.end() || previous->second != file.second)
+                            changed.push_back(snapshot.first + "/" + file.first);
+                    }
+                    snapshot.second = std::move(current);
+                }
+
+                if (!changed.empty() || (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline))
+                    return true;
+            }
+        }
+
+        void stop() override {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            stopCondition_.notify_one();
+        }
+
+    private:
+        // Modification time (ns) and size by file name
+        using Snapshot = umap<str, std::pair<s64, s64>>;
+
+        std::mutex mutex_;
+        std::condition_variable stopCondition_;
+        bool stopping_ = false;
+        umap<str, Snapshot> snapshots_; // by directory
+
+        static void scan(const str &directory, Snapshot &snapshot) {
+            const auto dir = opendir(directory.c_str());
+            if (!dir)
+                return;
+
+            while (const auto entry = readdir(dir)) {
+                const auto path = directory + "/" + entry->d_name;
+                struct stat st;
+                if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                    continue;
+#ifdef SL_OSX
+                const auto &mtime = st.st_mtimespec;
+#else
+                const auto &mtime = st.st_mtim;
+#endif
+                snapshot[entry->d_name] = {static_cast<s64>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec, static_cast<s64>(st.st_size)};
+            }
+            closedir(dir);
+        }
+    };
+}
+
+static auto createBackend() -> uptr<FileWatcher::Backend> {
+    return std::make_unique<PollingBackend>();
+}
+
+#endif
+
+auto FileWatcher::create() -> sptr<FileWatcher> {
+    auto watcher = sptr<FileWatcher>(new FileWatcher());
+    watcher->backend_ = createBackend();
+    if (watcher->backend_)
+        watcher->thread_ = std::thread([watcher = watcher.get()] { watcher->run(); });
+    else
+        Logger::global().logWarning("Failed to initialize file watching, file changes won't be detected");
+    return watcher;
+}
+
+auto FileWatcher::canonicalPath(const str &path) -> str {
+#ifdef SL_WINDOWS
+    s8 resolved[MAX_PATH];
+    if (!_fullpath(resolved, path.c_str(), MAX_PATH) || GetFileAttributesA(resolved) == INVALID_FILE_ATTRIBUTES)
+        return str();
+    str result = resolved;
+    std::replace(result.begin(), result.end(), '\\', '/');
+    // Paths are case insensitive, and change notifications don't necessarily use the case the path was given in
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+#else
+    s8 resolved[PATH_MAX];
+    if (realpath(path.c_str(), resolved))
+        return resolved;
+    return str();
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+    if (thread_.joinable()) {
+        backend_->stop();
+        thread_.join();
+    }
+}
+
+void FileWatcher::watchDirectory(const str &directory) {
+    if (!backend_)
+        return;
+
+    const auto canonical = canonicalPath(directory);
+    if (canonical.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!directories_.insert(canonical).second)
+            return;
+    }
+    backend_->watch(canonical);
+}
+
+auto FileWatcher::takeBatches() -> vec<Batch> {
+    std::lock_guard<std::mutex> lock(mutex_);
+    vec<Batch> result;
+    result.swap(batches_);
+    return result;
+}
+
+void FileWatcher::run() {
+    Batch pending;
+    vec<str> changed;
+
+    while (backend_->wait(pending.paths.empty() ? -1 : quietPeriodMs, changed)) {
+        if (changed.empty()) {
+            if (!pending.paths.empty()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                batches_.push_back(std::move(pending));
+                pending = Batch();
+            }
+            continue;
+        }
+
+        if (pending.paths.empty())
+            pending.firstChange = std::chrono::steady_clock::now();
+        for (const auto &path : changed) {
+            if (std::find(pending.paths.begin(), pending.paths.end(), path) == pending.paths.end())
+                pending.paths.push_back(path);
+        }
+        changed.clear();
+    }
+}
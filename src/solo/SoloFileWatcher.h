@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace solo {
+    // Reports files written or moved into watched directories. Editors tend to save in several steps,
+    // so changes are handed out in batches once the directories have been quiet for a few milliseconds.
+    // Uses inotify on Linux and ReadDirectoryChangesW on Windows, elsewhere it polls file modification times.
+    class FileWatcher final {
+    public:
+        struct Batch {
+            vec<str> paths; // canonical, no duplicates
+            std::chrono::steady_clock::time_point firstChange;
+        };
+
+        static auto create() -> sptr<FileWatcher>;
+
+        // Absolute path with symlinks resolved (lower case on Windows), empty when the file doesn't exist
+        static auto canonicalPath(const str &path) -> str;
+
+        FileWatcher(const FileWatcher &other) = delete;
+        FileWatcher(FileWatcher &&other) = delete;
+        ~FileWatcher();
+
+        auto operator=(const FileWatcher &other) -> FileWatcher & = delete;
+        auto operator=(FileWatcher &&other) -> FileWatcher & = delete;
+
+        // Not recursive. Watching the same directory again does nothing.
+        void watchDirectory(const str &directory);
+
+        auto takeBatches() -> vec<Batch>;
+
+        // Platform specific part. Watching is thread safe, waiting only happens on the watcher thread.
+        class Backend {
+        public:
+            virtual ~Backend() = default;
+
+            virtual void watch(const str &directory) = 0;
+            // Blocks until some files change or `timeoutMs` passes (never when negative). False once stopped.
+            virtual bool wait(s32 timeoutMs, vec<str> &changed) = 0;
+            virtual void stop() = 0;
+        };
+
+    private:
+        uptr<Backend> backend_;
+        std::thread thread_;
+
+        std::mutex mutex_;
+        uset<str> directories_;
+        vec<Batch> batches_;
+
+        FileWatcher() = default;
+
+        void run();
+    };
+}
@@ -19,3 +19,15 @@ auto Font::loadFromFile(Device *device, const str &path,
 
     return nullptr;
 }
+
+auto Font::loadFromFileAsync(Device *device, const str &path,
+                             u32 size, u32 atlasWidth,
+                             u32 atlasHeight, u32 firstChar, u32 charCount,
+                             u32 oversampleX, u32 oversampleY) -> sptr<AsyncHandle<Font>> {
+    if (STBTrueTypeFont::canLoadFromFile(path))
+        return STBTrueTypeFont::loadFromFileAsync(device, path, size, atlasWidth, atlasHeight, firstChar, charCount, oversampleX, oversampleY);
+
+    panic("Unsupported font file ", path);
+
+    return nullptr;
+}
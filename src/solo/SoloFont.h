@@ -6,6 +6,7 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloAsyncHandle.h"
 #include "math/SoloVector2.h"
 #include "math/SoloVector3.h"
 
@@ -27,6 +28,11 @@ namespace solo {
                                  u32 size, u32 atlasWidth, u32 atlasHeight,
                                  u32 firstChar, u32 charCount,
                                  u32 oversampleX, u32 oversampleY) -> sptr<Font>;
+        // Reads the file asynchronously and packs the glyphs on a worker, the atlas texture is created on the main thread
+        static auto loadFromFileAsync(Device *device, const str &path,
+                                      u32 size, u32 atlasWidth, u32 atlasHeight,
+                                      u32 firstChar, u32 charCount,
+                                      u32 oversampleX, u32 oversampleY) -> sptr<AsyncHandle<Font>>;
 
         Font(const Font &other) = delete;
         Font(Font &&other) = delete;
@@ -78,6 +78,8 @@ void FontMesh::rebuildMesh() {
     }
 
     mesh_ = Mesh::empty(device_);
+    // Vertices are rebuilt here on every text change, the mesh doesn't need copies of its own
+    mesh_->setCpuData(MeshCpuData::Release);
 
     VertexBufferLayout positionsLayout;
     positionsLayout.addAttribute(VertexAttributeUsage::Position);
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloGeometryArena.h"
+#include "SoloDevice.h"
+#include "gl/SoloOpenGLGeometryArena.h"
+#include "vk/SoloVulkanGeometryArena.h"
+#include <algorithm>
+
+using namespace solo;
+
+// Pools start this big and at least double when they run out of space
+static constexpr u32 minVertexCapacity = 1 << 16;
+static constexpr u32 minIndexCapacity = 3 << 16;
+
+GeometryArena::Allocation::~Allocation() {
+    if (arena_)
+        arena_->release(this);
+}
+
+auto GeometryArena::fromDevice(Device *device) -> sptr<GeometryArena> {
+    switch (device->mode()) {
+#ifdef SL_OPENGL_RENDERER
+        case DeviceMode::OpenGL:
+            return std::make_shared<OpenGLGeometryArena>();
+#endif
+#ifdef SL_VULKAN_RENDERER
+        case DeviceMode::Vulkan:
+            return std::make_shared<VulkanGeometryArena>(device);
+#endif
+        default:
+            panic("Unknown device mode");
+            return nullptr;
+    }
+}
+
+auto GeometryArena::Region::allocate(u32 count) -> s64 {
+    if (!count)
+        return 0;
+
+    for (auto hole = holes.begin(); hole != holes.end(); ++hole) {
+        if (hole->count < count)
+            continue;
+        const auto offset = hole->offset;
+        hole->offset += count;
+        hole->count -= count;
+        if (!hole->count)
+            holes.erase(hole);
+        return offset;
+    }
+
+    if (static_cast<u64>(end) + count > capacity)
+        return -1;
+
+    const auto offset = end;
+    end += count;
+    return offset;
+}
+
+void GeometryArena::Region::free(u32 offset, u32 count) {
+    if (!count)
+        return;
+
+    // Holes are sorted and never adjacent to each other or to `end`
+    auto next = std::lower_bound(holes.begin(), holes.end(), offset, [](const Range &range, u32 value) {
+        return range.offset < value;
+    });
+    next = holes.insert(next, Range{offset, count});
+
+    if (next + 1 != holes.end() && next->offset + next->count == (next + 1)->offset) {
+        next->count += (next + 1)->count;
+        holes.erase(next + 1);
+    }
+    if (next != holes.begin() && (next - 1)->offset + (next - 1)->count == next->offset) {
+        (next - 1)->count += next->count;
+        next = holes.erase(next) - 1;
+    }
+    if (next->offset + next->count == end) {
+        end = next->offset;
+        holes.erase(next);
+    }
+}
+
+auto GeometryArena::Region::holeCount() const -> u32 {
+    u32 result = 0;
+    for (const auto &hole : holes)
+        result += hole.count;
+    return result;
+}
+
+auto GeometryArena::findOrAddPool(const VertexBufferLayout &layout, IndexElementSize indexElementSize) -> u32 {
+    for (u32 i = 0; i < pools_.size(); i++) {
+        if (pools_[i].indexElementSize == indexElementSize && pools_[i].layout.sameAs(layout))
+            return i;
+    }
+
+    Pool pool;
+    pool.layout = layout;
+    pool.indexElementSize = indexElementSize;
+    pools_.push_back(pool);
+    return static_cast<u32>(pools_.size() - 1);
+}
+
+auto GeometryArena::allocate(const VertexBufferLayout &layout, const void *vertices, u32 vertexCount,
+    IndexElementSize indexElementSize, const void *indices, u32 indexCount) -> sptr<Allocation> {
+    const auto poolIndex = findOrAddPool(layout, indexElementSize);
+    auto &pool = pools_[poolIndex];
+
+    auto firstVertex = pool.vertices.allocate(vertexCount);
+    auto firstIndex = pool.indices.allocate(indexCount);
+    if (firstVertex < 0 || firstIndex < 0) {
+        if (firstVertex >= 0)
+            pool.vertices.free(static_cast<u32>(firstVertex), vertexCount);
+        if (firstIndex >= 0)
+            pool.indices.free(static_cast<u32>(firstIndex), indexCount);
+
+        const auto usedVertices = pool.vertices.end - pool.vertices.holeCount();
+        const auto usedIndices = pool.indices.end - pool.indices.holeCount();
+        const auto vertexCapacity = (std::max)({minVertexCapacity, pool.vertices.capacity * 2, usedVertices + vertexCount});
+        const auto indexCapacity = (std::max)({minIndexCapacity, pool.indices.capacity * 2, usedIndices + indexCount});
+        compact(poolIndex, vertexCapacity, indexCapacity);
+
+        firstVertex = pool.vertices.allocate(vertexCount);
+        firstIndex = pool.indices.allocate(indexCount);
+    }
+
+    upload(poolIndex, static_cast<u32>(firstVertex), vertices, vertexCount, static_cast<u32>(firstIndex), indices, indexCount);
+
+    const auto allocation = sptr<Allocation>(new Allocation());
+    allocation->arena_ = this;
+    allocation->pool_ = poolIndex;
+    allocation->firstVertex_ = static_cast<u32>(firstVertex);
+    allocation->vertexCount_ = vertexCount;
+    allocation->firstIndex_ = static_cast<u32>(firstIndex);
+    allocation->indexCount_ = indexCount;
+    pool.allocations.insert(allocation.get());
+
+    return allocation;
+}
+
+void GeometryArena::compact(u32 poolIndex, u32 vertexCapacity, u32 indexCapacity) {
+    auto &pool = pools_[poolIndex];
+
+    // Live ranges are packed at the start of the new buffers, in their current order
+    vec<Allocation *> allocations(pool.allocations.begin(), pool.allocations.end());
+    std::sort(allocations.begin(), allocations.end(), [](const Allocation *a, const Allocation *b) {
+        return a->firstVertex_ < b->firstVertex_;
+    });
+
+    vec<Move> vertexMoves, indexMoves;
+    u32 vertexEnd = 0, indexEnd = 0;
+    for (const auto allocation : allocations) {
+        if (allocation->vertexCount_)
+            vertexMoves.push_back(Move{allocation->firstVertex_, vertexEnd, allocation->vertexCount_});
+        if (allocation->indexCount_)
+            indexMoves.push_back(Move{allocation->firstIndex_, indexEnd, allocation->indexCount_});
+        vertexEnd += allocation->vertexCount_;
+        indexEnd += allocation->indexCount_;
+    }
+
+    resizePool(poolIndex, vertexCapacity, indexCapacity, vertexMoves, indexMoves);
+
+    vertexEnd = indexEnd = 0;
+    for (const auto allocation : allocations) {
+        allocation->firstVertex_ = vertexEnd;
+        allocation->firstIndex_ = indexEnd;
+        vertexEnd += allocation->vertexCount_;
+        indexEnd += allocation->indexCount_;
+    }
+
+    pool.vertices = Region{vertexCapacity, vertexEnd, {}};
+    pool.indices = Region{indexCapacity, indexEnd, {}};
+
+    // The new regions only contain live ranges, ranges released before are gone already
+    releases_.erase(std::remove_if(releases_.begin(), releases_.end(), [poolIndex](const Release &release) {
+        return release.pool == poolIndex;
+    }), releases_.end());
+}
+
+// Meshes may be destroyed in the middle of a frame, e.g. by a garbage collection in a script callback
+void GeometryArena::release(Allocation *allocation) {
+    pools_[allocation->pool_].allocations.erase(allocation);
+    releases_.push_back(Release{
+        allocation->pool_,
+        Range{allocation->firstVertex_, allocation->vertexCount_},
+        Range{allocation->firstIndex_, allocation->indexCount_}
+    });
+}
+
+void GeometryArena::update() {
+    uset<u32> released;
+    for (const auto &release : releases_) {
+        auto &pool = pools_[release.pool];
+        pool.vertices.free(release.vertices.offset, release.vertices.count);
+        pool.indices.free(release.indices.offset, release.indices.count);
+        released.insert(release.pool);
+    }
+    releases_.clear();
+
+    // Space past `end` is reused as is, only holes in the middle are worth moving meshes for
+    for (const auto index : released) {
+        const auto &pool = pools_[index];
+        if (pool.vertices.holeCount() > pool.vertices.capacity / 4 || pool.indices.holeCount() > pool.indices.capacity / 4)
+            compact(index, pool.vertices.capacity, pool.indices.capacity);
+    }
+
+    releaseRetiredBuffers();
+}
+
+auto GeometryArena::usedBytes() const -> u64 {
+    u64 result = 0;
+    for (const auto &pool : pools_) {
+        for (const auto allocation : pool.allocations) {
+            result += static_cast<u64>(allocation->vertexCount_) * pool.layout.size();
+            result += static_cast<u64>(allocation->indexCount_) * static_cast<u32>(pool.indexElementSize);
+        }
+    }
+    return result;
+}
+
+auto GeometryArena::capacityBytes() const -> u64 {
+    u64 result = 0;
+    for (const auto &pool : pools_) {
+        result += static_cast<u64>(pool.vertices.capacity) * pool.layout.size();
+        result += static_cast<u64>(pool.indices.capacity) * static_cast<u32>(pool.indexElementSize);
+    }
+    return result;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloVertexBufferLayout.h"
+
+namespace solo {
+    class Device;
+
+    // Large vertex and index buffers shared by static meshes, one pair per vertex layout and index size ("pool").
+    // Meshes sub-allocate ranges in them, so drawing different meshes one after another doesn't rebind buffers.
+    // Freed ranges are reused, and a pool is compacted once too much of it is unused.
+    // Commands recorded for the current frame may still reference freed ranges and replaced buffers, so frees and
+    // compaction wait for update() at the next frame, and buffers replaced by growing a pool mid-frame are kept until then.
+    class GeometryArena {
+    public:
+        // Of `count` vertices or indices from `from` in the old buffer of a pool to `to` in the new one
+        struct Move {
+            u32 from;
+            u32 to;
+            u32 count;
+        };
+
+        // Ranges of one mesh in a pool. Compaction moves them, so offsets must be read at draw time.
+        class Allocation {
+        public:
+            Allocation(const Allocation &other) = delete;
+            Allocation(Allocation &&other) = delete;
+            ~Allocation();
+
+            auto operator=(const Allocation &other) -> Allocation & = delete;
+            auto operator=(Allocation &&other) -> Allocation & = delete;
+
+            auto arena() const -> GeometryArena * { return arena_; }
+            auto pool() const -> u32 { return pool_; }
+            auto firstVertex() const -> u32 { return firstVertex_; }
+            auto vertexCount() const -> u32 { return vertexCount_; }
+            auto firstIndex() const -> u32 { return firstIndex_; }
+            auto indexCount() const -> u32 { return indexCount_; }
+
+        private:
+            friend class GeometryArena;
+
+            GeometryArena *arena_ = nullptr;
+            u32 pool_ = 0;
+            u32 firstVertex_ = 0;
+            u32 vertexCount_ = 0;
+            u32 firstIndex_ = 0;
+            u32 indexCount_ = 0;
+
+            Allocation() = default;
+        };
+
+        static auto fromDevice(Device *device) -> sptr<GeometryArena>;
+
+        GeometryArena(const GeometryArena &other) = delete;
+        GeometryArena(GeometryArena &&other) = delete;
+        virtual ~GeometryArena() = default;
+
+        auto operator=(const GeometryArena &other) -> GeometryArena & = delete;
+        auto operator=(GeometryArena &&other) -> GeometryArena & = delete;
+
+        // Vertices in the layout's formats, indices of `indexElementSize` relative to the first vertex
+        auto allocate(const VertexBufferLayout &layout, const void *vertices, u32 vertexCount,
+            IndexElementSize indexElementSize, const void *indices, u32 indexCount) -> sptr<Allocation>;
+
+        // Called by Device at the start of each frame, when the previous one is no longer in use by the GPU
+        void update();
+
+        auto poolCount() const -> u32 { return static_cast<u32>(pools_.size()); }
+        auto poolLayout(u32 pool) const -> const VertexBufferLayout & { return pools_.at(pool).layout; }
+        auto poolIndexElementSize(u32 pool) const -> IndexElementSize { return pools_.at(pool).indexElementSize; }
+
+        // GPU memory taken by live allocations and by all pools
+        auto usedBytes() const -> u64;
+        auto capacityBytes() const -> u64;
+
+    protected:
+        GeometryArena() = default;
+
+        // Replaces the pool's buffers with ones of the given capacities (zero for a new pool), copying the moved ranges over
+        virtual void resizePool(u32 pool, u32 vertexCapacity, u32 indexCapacity,
+            const vec<Move> &vertexMoves, const vec<Move> &indexMoves) = 0;
+        virtual void upload(u32 pool, u32 firstVertex, const void *vertices, u32 vertexCount,
+            u32 firstIndex, const void *indices, u32 indexCount) = 0;
+        // Destroys the buffers that resizePool replaced since the last update
+        virtual void releaseRetiredBuffers() {
+        }
+
+    private:
+        struct Range {
+            u32 offset;
+            u32 count;
+        };
+
+        // Vertices or indices of a pool, counted in elements. Free space is the holes plus everything past `end`
+        struct Region {
+            u32 capacity = 0;
+            u32 end = 0;
+            vec<Range> holes;
+
+            auto allocate(u32 count) -> s64;
+            void free(u32 offset, u32 count);
+            auto holeCount() const -> u32;
+        };
+
+        struct Pool {
+            VertexBufferLayout layout;
+            IndexElementSize indexElementSize;
+            Region vertices;
+            Region indices;
+            uset<Allocation *> allocations;
+        };
+
+        // Ranges of allocations released since the last update
+        struct Release {
+            u32 pool;
+            Range vertices;
+            Range indices;
+        };
+
+        vec<Pool> pools_;
+        vec<Release> releases_;
+
+        auto findOrAddPool(const VertexBufferLayout &layout, IndexElementSize indexElementSize) -> u32;
+        void compact(u32 pool, u32 vertexCapacity, u32 indexCapacity);
+        void release(Allocation *allocation);
+    };
+}
@@ -5,9 +5,26 @@
 
 #pragma once
 
+#include "SoloCommon.h"
+
 namespace solo {
     inline void combineHash(size_t &seed, size_t hash) {
         hash += 0x9e3779b9 + (seed << 6) + (seed >> 2);
         seed ^= hash;
     }
+
+    // 64-bit FNV-1a, stable across runs and platforms, so suitable for keying data persisted on disk
+    inline auto hashBytes(const void *data, size_t size, u64 seed = 14695981039346656037ull) -> u64 {
+        auto hash = seed;
+        const auto bytes = static_cast<const u8 *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline auto hashString(const str &s, u64 seed = 14695981039346656037ull) -> u64 {
+        return hashBytes(s.data(), s.size(), seed);
+    }
 }
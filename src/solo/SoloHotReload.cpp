@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloHotReload.h"
+#include "SoloDevice.h"
+#include "SoloFileSystem.h"
+#include "SoloFileWatcher.h"
+#include "SoloCookedAssets.h"
+#include "SoloEffect.h"
+#include "SoloTexture.h"
+#include "SoloMesh.h"
+#include "SoloStringUtils.h"
+#include <algorithm>
+
+using namespace solo;
+
+auto HotReload::fromDevice(Device *device) -> sptr<HotReload> {
+    return sptr<HotReload>(new HotReload(device));
+}
+
+HotReload::HotReload(Device *device):
+    device_(device),
+    watcher_(FileWatcher::create()) {
+}
+
+HotReload::~HotReload() {
+    // Reloads still in flight are dropped, nothing waits for them
+    for (const auto &batch : batches_) {
+        for (const auto &reload : batch.reloads)
+            reload.handle->cancel();
+    }
+}
+
+void HotReload::track(const str &path, std::weak_ptr<void> object, std::function<Reload()> reload) {
+    const auto localPath = device_->fileSystem()->localPath(path);
+    const auto canonical = localPath.empty() ? str() : FileWatcher::canonicalPath(localPath);
+    if (canonical.empty())
+        return;
+
+    const auto slash = canonical.rfind('/');
+    if (slash != str::npos)
+        watcher_->watchDirectory(canonical.substr(0, slash));
+
+    // Objects replaced by reloads are loaded (and tracked) too, they expire right after the swap
+    auto &tracked = tracked_[canonical];
+    tracked.erase(std::remove_if(tracked.begin(), tracked.end(), [](const Tracked &t) { return t.object.expired(); }), tracked.end());
+    tracked.push_back(Tracked{std::move(object), std::move(reload)});
+}
+
+void HotReload::trackEffect(sptr<Effect> effect, const str &path) {
+    const auto device = device_;
+    const std::weak_ptr<Effect> weak = effect;
+
+    track(path, weak, [device, weak, path] {
+        const auto handle = stringutils::endsWith(path, ".effect")
+            ? AsyncHandle<Effect>::run(device->jobPool(), JobThread::Main, [device, path] { return Effect::fromSourceFile(device, path); })
+            : Effect::fromDescriptionFileAsync(device, path);
+        return Reload{handle, [weak, handle] {
+            const auto effect = weak.lock();
+            if (effect)
+                effect->swapContents(*handle->result());
+        }};
+    });
+}
+
+void HotReload::trackTexture(sptr<Texture2D> texture, const str &path, bool generateMipmaps) {
+    const auto device = device_;
+    const std::weak_ptr<Texture2D> weak = texture;
+
+    track(path, weak, [device, weak, path, generateMipmaps] {
+        const auto handle = Texture2D::fromFileAsync(device, path, generateMipmaps);
+        return Reload{handle, [weak, handle] {
+            const auto texture = weak.lock();
+            if (texture)
+                texture->swapContents(*handle->result());
+        }};
+    });
+}
+
+void HotReload::trackMesh(sptr<Mesh> mesh, const str &path, const VertexBufferLayout &layout, MeshCpuData cpuData) {
+    const auto device = device_;
+    const std::weak_ptr<Mesh> weak = mesh;
+
+    track(path, weak, [device, weak, path, layout, cpuData] {
+        const auto handle = Mesh::fromFileAsync(device, path, layout, cpuData);
+        return Reload{handle, [weak, handle, path] {
+            const auto mesh = weak.lock();
+            if (!mesh)
+                return;
+            // Colliders point into the CPU copy, swapping would free it under them
+            if (mesh->isCpuDataPinned()) {
+                Logger::global().logWarning(fmt("Not reloading ", path, ", the mesh is used by a collider"));
+                return;
+            }
+            mesh->swapContents(*handle->result());
+        }};
+    });
+}
+
+void HotReload::update() {
+    startReloads();
+    finishReloads();
+}
+
+void HotReload::startReloads() {
+    for (const auto &changes : watcher_->takeBatches()) {
+        // Loaders track what they load, which may happen right away, so reloads are started after the lookup
+        vec<std::function<Reload()>> reloads;
+        for (const auto &path : changes.paths) {
+            const auto tracked = tracked_.find(path);
+            if (tracked == tracked_.end())
+                continue;
+
+            // Cooked outputs of an edited source are stale, the reload goes to the source
+            device_->cookedAssets()->forget(path);
+            Logger::global().logInfo(fmt("Reloading ", path));
+
+            for (const auto &t : tracked->second) {
+                if (!t.object.expired())
+                    reloads.push_back(t.reload);
+            }
+        }
+
+        Batch batch;
+        batch.firstChange = changes.firstChange;
+        for (const auto &reload : reloads)
+            batch.reloads.push_back(reload());
+
+        if (!batch.reloads.empty())
+            batches_.push_back(std::move(batch));
+    }
+}
+
+void HotReload::finishReloads() {
+    // Batches finish in order, so that a later edit of a file is never overwritten by an earlier one
+    while (!batches_.empty()) {
+        const auto &batch = batches_.front();
+        const auto pending = std::any_of(batch.reloads.begin(), batch.reloads.end(), [](const Reload &reload) {
+            return reload.handle->isPending();
+        });
+        if (pending)
+            return;
+
+        // Failed reloads leave the old contents in place, the rest of the batch is still swapped in. Loaders report bad
+        // contents (description and shader errors, truncated images and meshes) with AssetError, which fails the handle.
+        for (const auto &reload : batch.reloads) {
+            if (reload.handle->isResolved())
+                reload.swap();
+            else if (reload.handle->isFailed())
+                Logger::global().logError("Failed to reload an asset, keeping the old one");
+        }
+
+        reloadCount_++;
+        lastReloadMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batch.firstChange).count();
+        Logger::global().logInfo(fmt("Reloaded ", batch.reloads.size(), " asset(s) in ", lastReloadMs_, " ms"));
+
+        batches_.erase(batches_.begin());
+    }
+}
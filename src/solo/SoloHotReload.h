@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloEnums.h"
+#include "SoloVertexBufferLayout.h"
+#include <chrono>
+#include <functional>
+
+namespace solo {
+    class Device;
+    class FileWatcher;
+    class Effect;
+    class Texture2D;
+    class Mesh;
+    class AsyncHandleBase;
+
+    // Reloads assets whose files change on disk and swaps the new contents into the live objects, so that
+    // everything referencing them (materials, mesh renderers, scripts) picks the change up without being touched.
+    // Files edited together are swapped in together, at the start of a frame. Assets served from packs are not tracked.
+    // Only created by Device in builds with SL_HOT_RELOAD (see DeviceSetup::hotReload).
+    class HotReload final {
+    public:
+        static auto fromDevice(Device *device) -> sptr<HotReload>;
+
+        HotReload(const HotReload &other) = delete;
+        HotReload(HotReload &&other) = delete;
+        ~HotReload();
+
+        auto operator=(const HotReload &other) -> HotReload & = delete;
+        auto operator=(HotReload &&other) -> HotReload & = delete;
+
+        // Called by the loaders, on the main thread. Objects are not kept alive by tracking them.
+        void trackEffect(sptr<Effect> effect, const str &path);
+        void trackTexture(sptr<Texture2D> texture, const str &path, bool generateMipmaps);
+        // Meshes pinned by a collider at swap time (see Mesh::pinCpuData) keep their old contents
+        void trackMesh(sptr<Mesh> mesh, const str &path, const VertexBufferLayout &layout, MeshCpuData cpuData);
+
+        // Starts reloading what has changed and swaps in finished reloads. Called by Device every frame.
+        void update();
+
+        auto reloadCount() const -> u32 { return reloadCount_; }
+        // From the first change of the last swapped batch of files to the swap
+        auto lastReloadMs() const -> double { return lastReloadMs_; }
+
+    private:
+        struct Reload {
+            sptr<AsyncHandleBase> handle;
+            std::function<void()> swap;
+        };
+
+        struct Tracked {
+            std::weak_ptr<void> object;
+            std::function<Reload()> reload;
+        };
+
+        struct Batch {
+            vec<Reload> reloads;
+            std::chrono::steady_clock::time_point firstChange;
+        };
+
+        Device *device_ = nullptr;
+        sptr<FileWatcher> watcher_;
+        umap<str, vec<Tracked>> tracked_; // by canonical path
+        vec<Batch> batches_;
+        u32 reloadCount_ = 0;
+        double lastReloadMs_ = 0;
+
+        explicit HotReload(Device *device);
+
+        void track(const str &path, std::weak_ptr<void> object, std::function<Reload()> reload);
+        void startReloads();
+        void finishReloads();
+    };
+}
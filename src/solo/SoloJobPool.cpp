@@ -4,39 +4,145 @@
  */
 
 #include "SoloJobPool.h"
+#include <algorithm>
+#include <chrono>
 
 using namespace solo;
 
+JobPool::JobPool(u32 workerCount):
+    threadPool_(workerCount) {
+}
+
 void JobPool::addJob(sptr<Job> job) {
-    auto token = lock_.acquire();
-    jobs_.push_back(job);
+    activeJobs_++;
+    job->start(&threadPool_, [this, job] {
+        schedule(JobThread::Main, [this, job] {
+            activeJobs_--;
+            job->update();
+        });
+    });
 }
 
-void JobPool::update() {
-    if (!jobs_.empty()) {
-        decltype(jobs_) oldJobs;
-        {
-            auto token = lock_.acquire();
-            if (!jobs_.empty()) {
-                oldJobs = jobs_;
-                anyActiveJobs_ = true;
+void JobPool::schedule(JobThread thread, std::function<void()> task, JobPriority priority) {
+    scheduledTasks_++;
+
+    if (thread == JobThread::Worker) {
+        threadPool_.submit([this, task] {
+            task();
+            scheduledTasks_--;
+        }, priority);
+    } else
+        mainThreadTasks_.push({std::move(task), priority});
+}
+
+auto JobPool::stats() const -> JobStats {
+    auto result = stats_;
+    const auto lockStats = threadPool_.injectionLockStats();
+    result.queueLockAcquisitions = lockStats.acquisitions;
+    result.queueLockContentions = lockStats.contendedAcquisitions;
+    result.queueLockWaitTime = lockStats.waitTime;
+    return result;
+}
+
+auto JobPool::chunkSize(u32 count, u32 grainSize) const -> u32 {
+    if (grainSize)
+        return grainSize;
+    // A few chunks per thread so that uneven chunks still balance out
+    const auto threads = threadPool_.workerCount() + 1;
+    return std::max(1u, count / (threads * 4));
+}
+
+void JobPool::parallelFor(u32 begin, u32 end, u32 grainSize, const std::function<void(u32, u32)> &func) {
+    if (begin >= end)
+        return;
+
+    const auto count = end - begin;
+    const auto chunk = chunkSize(count, grainSize);
+    const auto chunkCount = (count + chunk - 1) / chunk;
+    if (chunkCount == 1) {
+        func(begin, end);
+        return;
+    }
+
+    struct State {
+        std::atomic<u32> nextChunk{0};
+        std::atomic<u32> activeHelpers{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+    };
+    const auto state = std::make_shared<State>();
+
+    // Returns when there are no more chunks to take. Helpers that start late find nothing and never touch `func`.
+    const auto processChunks = [state, begin, end, chunk, chunkCount](const std::function<void(u32, u32)> *f) {
+        while (true) {
+            const auto index = state->nextChunk.fetch_add(1);
+            if (index >= chunkCount)
+                return;
+            const auto from = begin + index * chunk;
+            try {
+                (*f)(from, std::min(end, from + chunk));
+            } catch (...) {
+                if (!state->failed.exchange(true))
+                    state->error = std::current_exception();
             }
         }
+    };
 
-        auto anyDone = false;
-        for (auto job : oldJobs) {
-            job->update();
-            if (job->isDone())
-                anyDone = true;
-        }
+    // The caller takes one share, so never ask for more helpers than there are chunks left for them
+    const auto helperCount = std::min(threadPool_.workerCount(), chunkCount - 1);
+    const auto funcPtr = &func;
+    for (u32 i = 0; i < helperCount; i++) {
+        threadPool_.submit([state, processChunks, funcPtr] {
+            state->activeHelpers++;
+            processChunks(funcPtr);
+            state->activeHelpers--;
+        });
+    }
+
+    processChunks(funcPtr);
+
+    // All chunks are taken, wait only for the ones still being processed
+    while (state->activeHelpers > 0)
+        std::this_thread::yield();
+
+    if (state->failed)
+        std::rethrow_exception(state->error);
+}
+
+void JobPool::update() {
+    MainThreadTask incoming;
+    while (mainThreadTasks_.pop(incoming))
+        deferredTasks_[static_cast<u32>(incoming.priority)].push_back(std::move(incoming.func));
+
+    // Tasks scheduled from inside these tasks land in the queue above and wait for the next update
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [start] {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
 
-        if (anyDone) {
-            auto token = lock_.acquire();
-            jobs_.remove_if([](sptr<Job> job) {
-                return job->isDone();
-            });
-            if (jobs_.empty())
-                anyActiveJobs_ = false;
+    u32 processed = 0;
+    auto outOfBudget = false;
+    for (auto tasks = deferredTasks_.rbegin(); tasks != deferredTasks_.rend() && !outOfBudget; ++tasks) {
+        while (!tasks->empty()) {
+            if (processed > 0 && mainThreadBudget_ > 0 && elapsed() >= mainThreadBudget_) {
+                outOfBudget = true;
+                break;
+            }
+
+            const auto task = std::move(tasks->front());
+            tasks->pop_front();
+            processed++;
+            // Count it as done up front so that a throwing task doesn't leave the pool "busy" forever
+            scheduledTasks_--;
+            task();
         }
     }
+
+    stats_.processedMainThreadTasks = processed;
+    stats_.mainThreadTime = elapsed();
+    stats_.queuedMainThreadTasks = 0;
+    for (const auto &tasks : deferredTasks_)
+        stats_.queuedMainThreadTasks += static_cast<u32>(tasks.size());
+    if (outOfBudget)
+        stats_.budgetOverruns++;
 }
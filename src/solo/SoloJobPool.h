@@ -6,11 +6,37 @@
 #pragma once
 
 #include "SoloCommon.h"
-#include "SoloSpinLock.h"
+#include "SoloMpscQueue.h"
+#include "SoloThreadPool.h"
 #include <functional>
-#include <future>
+#include <atomic>
+#include <exception>
+#include <deque>
 
 namespace solo {
+    enum class JobThread {
+        Worker,
+        Main
+    };
+
+    // "class" because binding to lua seems to not support structs
+    class JobStats {
+    public:
+        /// Main thread tasks left waiting for the next frames
+        u32 queuedMainThreadTasks = 0;
+        /// Main thread tasks run during the last update
+        u32 processedMainThreadTasks = 0;
+        /// Milliseconds spent on main thread tasks during the last update
+        float mainThreadTime = 0;
+        /// Number of updates that ran out of budget and deferred some tasks
+        u32 budgetOverruns = 0;
+        /// Lock guarding the worker queues that other threads submit into
+        u64 queueLockAcquisitions = 0;
+        u64 queueLockContentions = 0;
+        /// Milliseconds
+        double queueLockWaitTime = 0;
+    };
+
     class Job {
     public:
         Job(const Job &other) = delete;
@@ -24,6 +50,10 @@ namespace solo {
             return done_;
         }
 
+        // `onFinished` is invoked once, on whatever thread finishes the last piece of work
+        virtual void start(ThreadPool *pool, std::function<void()> onFinished) = 0;
+
+        // Delivers the results, called on the main thread after the job has finished
         virtual void update() = 0;
 
     protected:
@@ -37,47 +67,78 @@ namespace solo {
     public:
         using Producer = std::function<sptr<T>()>;
         using Producers = vec<Producer>;
-        using Consumer = std::function<void(const vec<sptr<T>> &)>;
+        // Results of producers that threw are null, with their exceptions at the same index in `errors`
+        using Consumer = std::function<void(const vec<sptr<T>> &results, const vec<std::exception_ptr> &errors)>;
 
         JobBase(const vec<Producer> &funcs, const Consumer &onDone):
-            callback_(onDone) {
-            for (auto &func : funcs) {
-                auto future = std::async(std::launch::async, func);
-                futures_.push_back(std::move(future));
-                results_.push_back(nullptr);
-            }
+            producers_(funcs),
+            callback_(onDone),
+            state_(std::make_shared<State>(funcs.size())) {
         }
 
-        void update() override final {
-            auto readyCount = 0;
-            auto i = 0;
-            for (auto &future : futures_) {
-                if (future.valid()) {
-                    const auto status = future.wait_for(std::chrono::nanoseconds(0));
-                    if (status == std::future_status::ready)
-                        results_[i] = future.get();
-                } else {
-                    panicIf(!results_[i], "Unable to obtain job result");
-                    readyCount++;
-                }
-                i++;
+        void start(ThreadPool *pool, std::function<void()> onFinished) override final {
+            if (producers_.empty()) {
+                onFinished();
+                return;
             }
 
-            if (readyCount == futures_.size()) {
-                callback_(results_);
-                done_ = true;
+            state_->onFinished = std::move(onFinished);
+            for (size_t i = 0; i < producers_.size(); i++) {
+                // Tasks share the state so that they stay valid even if the job itself is dropped
+                auto state = state_;
+                auto producer = producers_[i];
+                pool->submit([state, producer, i] {
+                    try {
+                        state->results[i] = producer();
+                    } catch (...) {
+                        state->errors[i] = std::current_exception();
+                    }
+                    if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        // Dropping the callback breaks the reference it may hold to the job
+                        const auto onFinished = std::move(state->onFinished);
+                        state->onFinished = nullptr;
+                        onFinished();
+                    }
+                });
             }
+            producers_.clear();
+        }
+
+        void update() override final {
+            if (state_->remaining.load(std::memory_order_acquire) > 0)
+                return;
+
+            // One failed producer doesn't take down the results of the others
+            for (size_t i = 0; i < state_->results.size(); i++)
+                panicIf(!state_->results[i] && !state_->errors[i], "Unable to obtain job result");
+
+            callback_(state_->results, state_->errors);
+            done_ = true;
         }
 
     private:
-        vec<std::future<sptr<T>>> futures_;
-        vec<sptr<T>> results_;
+        struct State {
+            vec<sptr<T>> results;
+            vec<std::exception_ptr> errors;
+            std::atomic<size_t> remaining;
+            std::function<void()> onFinished;
+
+            explicit State(size_t count):
+                results(count),
+                errors(count),
+                remaining(count) {
+            }
+        };
+
+        Producers producers_;
         Consumer callback_;
+        sptr<State> state_;
     };
 
     class JobPool {
     public:
-        JobPool() = default;
+        // 0 means "one worker per hardware thread"
+        explicit JobPool(u32 workerCount = 0);
         JobPool(const JobPool &other) = delete;
         JobPool(JobPool &&other) = delete;
         virtual ~JobPool() = default;
@@ -86,14 +147,81 @@ namespace solo {
         auto operator=(JobPool &&other) -> JobPool & = delete;
 
         bool hasActiveJobs() const {
-            return anyActiveJobs_;
+            return activeJobs_ > 0 || scheduledTasks_ > 0;
         }
+
+        auto threadPool() -> ThreadPool* {
+            return &threadPool_;
+        }
+
+        bool isMainThread() const {
+            return std::this_thread::get_id() == mainThreadId_;
+        }
+
         void addJob(sptr<Job> job);
+
+        // Main thread tasks run in update(), most important first
+        void schedule(JobThread thread, std::function<void()> task, JobPriority priority = JobPriority::Normal);
+
+        // Milliseconds per update() for main thread tasks, 0 means no limit. At least one task runs
+        // per update regardless, the rest wait for the next ones.
+        void setMainThreadBudget(float budget) {
+            mainThreadBudget_ = budget;
+        }
+
+        auto mainThreadBudget() const -> float {
+            return mainThreadBudget_;
+        }
+
+        auto stats() const -> JobStats;
+
         void update();
 
+        // Splits [begin, end) into chunks of at least `grainSize` items (0 - pick automatically) and runs `func`
+        // on them in parallel. The calling thread processes chunks too, so calling this from inside a job is fine.
+        void parallelFor(u32 begin, u32 end, u32 grainSize, const std::function<void(u32, u32)> &func);
+
+        // Like parallelFor, but each chunk folds into its own accumulator (starting from `identity`),
+        // and the partial results are combined in chunk order
+        template <class T>
+        auto parallelReduce(u32 begin, u32 end, u32 grainSize, T identity,
+            const std::function<T(u32, u32, T)> &func, const std::function<T(T, T)> &combine) -> T {
+            if (begin >= end)
+                return identity;
+
+            const auto chunk = chunkSize(end - begin, grainSize);
+            vec<T> partials((end - begin + chunk - 1) / chunk, identity);
+            parallelFor(begin, end, chunk, [&](u32 from, u32 to) {
+                auto &partial = partials[(from - begin) / chunk];
+                partial = func(from, to, partial);
+            });
+
+            auto result = identity;
+            for (const auto &partial : partials)
+                result = combine(result, partial);
+            return result;
+        }
+
     private:
-        list<sptr<Job>> jobs_;
-        bool anyActiveJobs_ = false;
-        SpinLock lock_;
+        const std::thread::id mainThreadId_ = std::this_thread::get_id();
+
+        struct MainThreadTask {
+            std::function<void()> func;
+            JobPriority priority = JobPriority::Normal;
+        };
+
+        // Filled by workers, drained in update(), so update() only pays for what has actually finished
+        MpscQueue<MainThreadTask> mainThreadTasks_;
+        // Tasks taken from the queue but postponed by the budget, one list per priority
+        arr<std::deque<std::function<void()>>, 3> deferredTasks_;
+        float mainThreadBudget_ = 0;
+        JobStats stats_;
+        std::atomic<u32> activeJobs_{0};
+        std::atomic<u32> scheduledTasks_{0};
+
+        auto chunkSize(u32 count, u32 grainSize) const -> u32;
+
+        // Last so that workers are joined before anything they might touch is destroyed
+        ThreadPool threadPool_;
     };
 }
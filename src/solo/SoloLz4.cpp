@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloLz4.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace solo;
+
+static constexpr u32 minMatch = 4;
+// Format rules: the last 5 bytes are always literals and no match starts within the last 12 bytes
+static constexpr size_t lastLiterals = 5;
+static constexpr size_t matchStartLimit = 12;
+static constexpr size_t maxOffset = 65535;
+static constexpr u32 hashBits = 16;
+
+static auto read32(const u8 *p) -> u32 {
+    u32 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static auto hash(u32 sequence) -> u32 {
+    return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+static void writeLength(vec<u8> &out, size_t length) {
+    for (; length >= 255; length -= 255)
+        out.push_back(255);
+    out.push_back(static_cast<u8>(length));
+}
+
+static void writeSequence(vec<u8> &out, const u8 *literals, size_t literalCount, size_t offset, size_t matchLength) {
+    const auto extraMatch = matchLength ? matchLength - minMatch : 0;
+    out.push_back(static_cast<u8>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(extraMatch, 15)));
+    if (literalCount >= 15)
+        writeLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+
+    if (!matchLength)
+        return;
+    out.push_back(static_cast<u8>(offset & 0xff));
+    out.push_back(static_cast<u8>(offset >> 8));
+    if (extraMatch >= 15)
+        writeLength(out, extraMatch - 15);
+}
+
+static bool readLength(const u8 *&in, const u8 *end, size_t &length) {
+    u8 byte;
+    do {
+        if (in == end)
+            return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+auto solo::lz4Compress(const void *data, size_t size) -> vec<u8> {
+    const auto src = static_cast<const u8 *>(data);
+    vec<u8> out;
+    out.reserve(size + size / 255 + 16);
+
+    // Positions of the last sequences seen with each hash. Candidates are verified, so stale or unset slots are harmless
+    vec<u32> table(1 << hashBits, 0);
+    const auto searchEnd = size > matchStartLimit ? size - matchStartLimit : 0;
+    const auto matchEnd = size > lastLiterals ? size - lastLiterals : 0;
+
+    size_t anchor = 0, pos = 0;
+    while (pos < searchEnd) {
+        const auto sequence = read32(src + pos);
+        auto &slot = table[hash(sequence)];
+        const size_t candidate = slot;
+        slot = static_cast<u32>(pos);
+
+        if (candidate >= pos || pos - candidate > maxOffset || read32(src + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        auto length = static_cast<size_t>(minMatch);
+        while (pos + length < matchEnd && src[candidate + length] == src[pos + length])
+            length++;
+
+        writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool solo::lz4Decompress(const void *src, size_t srcSize, void *dst, size_t dstSize) {
+    auto in = static_cast<const u8 *>(src);
+    const auto inEnd = in + srcSize;
+    const auto outStart = static_cast<u8 *>(dst);
+    const auto outEnd = outStart + dstSize;
+    auto out = outStart;
+
+    while (in < inEnd) {
+        const auto token = *in++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(in, inEnd, literalCount))
+            return false;
+        if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > static_cast<size_t>(outEnd - out))
+            return false;
+        std::memcpy(out, in, literalCount);
+        in += literalCount;
+        out += literalCount;
+
+        // The last sequence has no match
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return false;
+        const size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        if (!offset || offset > static_cast<size_t>(out - outStart))
+            return false;
+
+        size_t length = token & 15;
+        if (length == 15 && !readLength(in, inEnd, length))
+            return false;
+        length += minMatch;
+        if (length > static_cast<size_t>(outEnd - out))
+            return false;
+
+        // Overlapping matches repeat the bytes just written, so those are copied one by one
+        const auto match = out - offset;
+        if (offset >= length)
+            std::memcpy(out, match, length);
+        else {
+            for (size_t i = 0; i < length; i++)
+                out[i] = match[i];
+        }
+        out += length;
+    }
+
+    return out == outEnd;
+}
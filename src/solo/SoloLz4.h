@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo {
+    // LZ4 block format (without the frame), readable by the reference LZ4_decompress_safe. The compressor is a plain
+    // greedy one: it is meant for offline tools, decompression is what runs at load time.
+    auto lz4Compress(const void *data, size_t size) -> vec<u8>;
+
+    // False when the input is malformed or doesn't decompress into exactly `dstSize` bytes
+    bool lz4Decompress(const void *src, size_t srcSize, void *dst, size_t dstSize);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloMappedFile.h"
+#ifdef SL_WINDOWS
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+using namespace solo;
+
+auto MappedFile::fromRange(sptr<MappedFile> file, size_t offset, size_t size) -> sptr<MappedFile> {
+    panicIf(offset > file->size_ || size > file->size_ - offset, "Range is out of mapped file bounds");
+    auto result = sptr<MappedFile>(new MappedFile());
+    result->data_ = file->data_ + offset;
+    result->size_ = size;
+    result->parent_ = std::move(file);
+    return result;
+}
+
+auto MappedFile::fromBytes(vec<u8> &&bytes) -> sptr<MappedFile> {
+    auto result = sptr<MappedFile>(new MappedFile());
+    result->bytes_ = std::move(bytes);
+    result->data_ = result->bytes_.data();
+    result->size_ = result->bytes_.size();
+    return result;
+}
+
+#ifdef SL_WINDOWS
+
+auto MappedFile::fromPath(const str &path) -> sptr<MappedFile> {
+    const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    assetErrorIf(file == INVALID_HANDLE_VALUE, "Unable to open file ", path);
+
+    auto result = sptr<MappedFile>(new MappedFile());
+    result->file_ = file;
+
+    LARGE_INTEGER size;
+    assetErrorIf(!GetFileSizeEx(file, &size), "Unable to get size of file ", path);
+    if (!size.QuadPart)
+        return result;
+
+    result->mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    assetErrorIf(!result->mapping_, "Unable to map file ", path);
+    result->data_ = static_cast<const u8 *>(MapViewOfFile(result->mapping_, FILE_MAP_READ, 0, 0, 0));
+    assetErrorIf(!result->data_, "Unable to map file ", path);
+    result->mapped_ = true;
+    result->size_ = static_cast<size_t>(size.QuadPart);
+
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    if (mapped_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_)
+        CloseHandle(file_);
+}
+
+#else
+
+auto MappedFile::fromPath(const str &path) -> sptr<MappedFile> {
+    const auto fd = open(path.c_str(), O_RDONLY);
+    assetErrorIf(fd < 0, "Unable to open file ", path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw AssetError(fmt("Unable to get size of file ", path));
+    }
+
+    auto result = sptr<MappedFile>(new MappedFile());
+    if (info.st_size > 0) {
+        const auto data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw AssetError(fmt("Unable to map file ", path));
+        }
+        result->data_ = static_cast<const u8 *>(data);
+        result->size_ = static_cast<size_t>(info.st_size);
+        result->mapped_ = true;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    if (mapped_)
+        munmap(const_cast<u8 *>(data_), size_);
+}
+
+#endif
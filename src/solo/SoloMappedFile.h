@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo {
+    // Read-only mapping of a whole file. Pages are loaded on first access, so mapping
+    // a file costs next to nothing until its contents are actually read.
+    // Can also be a view of a range of another mapping (a pack entry) or own bytes decompressed in memory.
+    class MappedFile final {
+    public:
+        static auto fromPath(const str &path) -> sptr<MappedFile>;
+        static auto fromRange(sptr<MappedFile> file, size_t offset, size_t size) -> sptr<MappedFile>;
+        static auto fromBytes(vec<u8> &&bytes) -> sptr<MappedFile>;
+
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile(MappedFile &&other) = delete;
+        ~MappedFile();
+
+        auto operator=(const MappedFile &other) -> MappedFile & = delete;
+        auto operator=(MappedFile &&other) -> MappedFile & = delete;
+
+        auto data() const -> const u8 * {
+            return data_;
+        }
+
+        auto size() const -> size_t {
+            return size_;
+        }
+
+    private:
+        const u8 *data_ = nullptr;
+        size_t size_ = 0;
+        bool mapped_ = false;
+        sptr<MappedFile> parent_;
+        vec<u8> bytes_;
+#ifdef SL_WINDOWS
+        void *file_ = nullptr;
+        void *mapping_ = nullptr;
+#endif
+
+        MappedFile() = default;
+    };
+}
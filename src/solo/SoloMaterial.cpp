@@ -6,8 +6,13 @@
 #include "SoloMaterial.h"
 #include "SoloTexture.h"
 #include "SoloDevice.h"
+#include "SoloCamera.h"
+#include "SoloTransform.h"
+#include "SoloObjectMatrixCache.h"
 #include "gl/SoloOpenGLMaterial.h"
 #include "vk/SoloVulkanMaterial.h"
+#include <cstring>
+#include <algorithm>
 
 using namespace solo;
 
@@ -27,6 +32,218 @@ auto Material::fromEffect(Device *device, sptr<Effect> effect) -> sptr<Material>
     }
 }
 
+template <class T>
+static void writeValue(u8 *dst, u32 size, const T &value) {
+    std::memcpy(dst, &value, std::min(static_cast<u32>(sizeof(T)), size));
+}
+
+static auto nextBlockVersion() -> u64 {
+    static u64 version = 0;
+    return ++version;
+}
+
+Material::Material(const sptr<Effect> &effect):
+    parameters_(effect->parameterCount()),
+    block_(effect->parameterBlockSize()),
+    blockVersion_(nextBlockVersion()) {
+    for (u32 handle = 0; handle < parameters_.size(); handle++) {
+        parameters_[handle].offset = effect->parameterOffset(handle);
+        parameters_[handle].size = effect->parameterSize(handle);
+    }
+
+#ifdef SL_HOT_RELOAD
+    effectRevision_ = effect->revision();
+    for (u32 handle = 0; handle < parameters_.size(); handle++)
+        parameterNames_.push_back(effect->parameterName(handle));
+#endif
+}
+
+#ifdef SL_HOT_RELOAD
+void Material::rebuildParameters(const Effect *effect) {
+    vec<Parameter> parameters(effect->parameterCount());
+    vec<u8> block(effect->parameterBlockSize());
+    vec<str> names(parameters.size());
+    for (u32 handle = 0; handle < parameters.size(); handle++) {
+        parameters[handle].offset = effect->parameterOffset(handle);
+        parameters[handle].size = effect->parameterSize(handle);
+        names[handle] = effect->parameterName(handle);
+    }
+
+    dynamicParameters_.clear();
+    for (u32 oldHandle = 0; oldHandle < parameters_.size(); oldHandle++) {
+        const auto &old = parameters_[oldHandle];
+        const auto &name = parameterNames_[oldHandle];
+        if (old.type == ParameterType::None || !effect->hasParameter(name))
+            continue;
+
+        const auto handle = effect->parameterHandle(name);
+        auto &param = parameters[handle];
+        // Getters write values of the old size
+        if (param.size != old.size) {
+            Logger::global().logWarning(fmt("Material parameter ", name, " changed its size, it has to be set again"));
+            continue;
+        }
+
+        param.type = old.type;
+        param.source = old.source;
+        param.getter = old.getter;
+        param.binding = old.binding;
+        param.texture = old.texture;
+        if (old.source == ParameterSource::Value)
+            std::memcpy(block.data() + param.offset, block_.data() + old.offset, old.size);
+        else
+            dynamicParameters_.push_back(handle);
+    }
+
+    parameters_ = std::move(parameters);
+    block_ = std::move(block);
+    parameterNames_ = std::move(names);
+    effectRevision_ = effect->revision();
+    blockVersion_ = nextBlockVersion();
+}
+#endif
+
+auto Material::parameterAt(u32 handle, ParameterType type, ParameterSource source) -> Parameter & {
+#ifdef SL_HOT_RELOAD
+    // Handles come from the effect's current layout, which may be newer than the material's
+    syncWithEffect(effect().get());
+#endif
+    panicIf(handle >= parameters_.size(), "Invalid material parameter handle ", handle);
+    auto &param = parameters_[handle];
+
+    const auto wasDynamic = param.type != ParameterType::None && param.source != ParameterSource::Value;
+    const auto isDynamic = source != ParameterSource::Value;
+    if (wasDynamic && !isDynamic)
+        dynamicParameters_.erase(std::find(dynamicParameters_.begin(), dynamicParameters_.end(), handle));
+    else if (!wasDynamic && isDynamic)
+        dynamicParameters_.push_back(handle);
+
+    param.type = type;
+    param.source = source;
+    param.getter = nullptr;
+    param.texture = nullptr;
+    return param;
+}
+
+template <class T>
+void Material::setValue(u32 handle, ParameterType type, const T &value) {
+    auto &param = parameterAt(handle, type, ParameterSource::Value);
+    writeValue(block_.data() + param.offset, param.size, value);
+    blockVersion_ = nextBlockVersion();
+}
+
+template <class T>
+void Material::bindGetter(u32 handle, ParameterType type, const std::function<T()> &getter) {
+    auto &param = parameterAt(handle, type, ParameterSource::Getter);
+    const auto size = param.size;
+    param.getter = [getter, size](u8 *dst) {
+        writeValue(dst, size, getter());
+    };
+}
+
+void Material::setFloatParameter(u32 handle, float value) {
+    setValue(handle, ParameterType::Float, value);
+}
+
+void Material::setVector2Parameter(u32 handle, const Vector2 &value) {
+    setValue(handle, ParameterType::Vector2, value);
+}
+
+void Material::setVector3Parameter(u32 handle, const Vector3 &value) {
+    setValue(handle, ParameterType::Vector3, value);
+}
+
+void Material::setVector4Parameter(u32 handle, const Vector4 &value) {
+    setValue(handle, ParameterType::Vector4, value);
+}
+
+void Material::setMatrixParameter(u32 handle, const Matrix &value) {
+    setValue(handle, ParameterType::Matrix, value);
+}
+
+void Material::setTextureParameter(u32 handle, sptr<Texture> value) {
+    parameterAt(handle, ParameterType::Texture, ParameterSource::Value).texture = value;
+}
+
+void Material::bindFloatParameter(u32 handle, const std::function<float()> &valueGetter) {
+    bindGetter(handle, ParameterType::Float, valueGetter);
+}
+
+void Material::bindVector2Parameter(u32 handle, const std::function<Vector2()> &valueGetter) {
+    bindGetter(handle, ParameterType::Vector2, valueGetter);
+}
+
+void Material::bindVector3Parameter(u32 handle, const std::function<Vector3()> &valueGetter) {
+    bindGetter(handle, ParameterType::Vector3, valueGetter);
+}
+
+void Material::bindVector4Parameter(u32 handle, const std::function<Vector4()> &valueGetter) {
+    bindGetter(handle, ParameterType::Vector4, valueGetter);
+}
+
+void Material::bindMatrixParameter(u32 handle, const std::function<Matrix()> &valueGetter) {
+    bindGetter(handle, ParameterType::Matrix, valueGetter);
+}
+
+void Material::bindParameter(u32 handle, ParameterBinding binding) {
+    const auto type = binding == ParameterBinding::CameraWorldPosition ? ParameterType::Vector3 : ParameterType::Matrix;
+    parameterAt(handle, type, ParameterSource::Binding).binding = binding;
+}
+
+void Material::updateDynamicParameters(const Camera *camera, const Transform *nodeTransform, ObjectMatrixCache *matrixCache) {
+    for (const auto handle : dynamicParameters_) {
+        const auto &param = parameters_[handle];
+        const auto dst = block_.data() + param.offset;
+
+        if (param.source == ParameterSource::Getter) {
+            param.getter(dst);
+            continue;
+        }
+
+        // Bindings that can't be resolved for this draw keep the previous value
+        switch (param.binding) {
+            case ParameterBinding::WorldMatrix:
+                if (nodeTransform)
+                    writeValue(dst, param.size, nodeTransform->worldMatrix());
+                break;
+            case ParameterBinding::ViewMatrix:
+                if (camera)
+                    writeValue(dst, param.size, camera->viewMatrix());
+                break;
+            case ParameterBinding::ProjectionMatrix:
+                if (camera)
+                    writeValue(dst, param.size, camera->projectionMatrix());
+                break;
+            case ParameterBinding::WorldViewMatrix:
+                if (nodeTransform && camera)
+                    writeValue(dst, param.size, matrixCache->worldViewMatrix(nodeTransform, camera));
+                break;
+            case ParameterBinding::ViewProjectionMatrix:
+                if (camera)
+                    writeValue(dst, param.size, camera->viewProjectionMatrix());
+                break;
+            case ParameterBinding::WorldViewProjectionMatrix:
+                if (nodeTransform && camera)
+                    writeValue(dst, param.size, matrixCache->worldViewProjMatrix(nodeTransform, camera));
+                break;
+            case ParameterBinding::InverseTransposedWorldMatrix:
+                if (nodeTransform)
+                    writeValue(dst, param.size, nodeTransform->invTransposedWorldMatrix());
+                break;
+            case ParameterBinding::InverseTransposedWorldViewMatrix:
+                if (nodeTransform && camera)
+                    writeValue(dst, param.size, matrixCache->invTransposedWorldViewMatrix(nodeTransform, camera));
+                break;
+            case ParameterBinding::CameraWorldPosition:
+                if (camera)
+                    writeValue(dst, param.size, camera->transform()->worldPosition());
+                break;
+            default:
+                panic("Unsupported parameter binding");
+        }
+    }
+}
+
 void Material::setBlendFactors(BlendFactor srcFactor, BlendFactor dstFactor) {
     srcBlendFactor_ = srcFactor;
     dstBlendFactor_ = dstFactor;
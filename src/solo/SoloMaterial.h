@@ -20,6 +20,7 @@ namespace solo {
     class Texture;
     class Camera;
     class Transform;
+    class ObjectMatrixCache;
 
     class Material {
     public:
@@ -31,25 +32,80 @@ namespace solo {
         auto operator=(const Material &other) -> Material & = delete;
         auto operator=(Material &&other) -> Material & = delete;
 
-        virtual void setFloatParameter(const str &name, float value) = 0;
-        virtual void setVector2Parameter(const str &name, const Vector2 &value) = 0;
-        virtual void setVector3Parameter(const str &name, const Vector3 &value) = 0;
-        virtual void setVector4Parameter(const str &name, const Vector4 &value) = 0;
-        virtual void setMatrixParameter(const str &name, const Matrix &value) = 0;
-        virtual void setTextureParameter(const str &name, sptr<Texture> value) = 0;
+        // Resolve names once via parameterHandle() to avoid string lookups in per-frame updates
+        auto parameterHandle(const str &name) const -> u32 {
+            return effect()->parameterHandle(name);
+        }
+
+        void setFloatParameter(u32 handle, float value);
+        void setVector2Parameter(u32 handle, const Vector2 &value);
+        void setVector3Parameter(u32 handle, const Vector3 &value);
+        void setVector4Parameter(u32 handle, const Vector4 &value);
+        void setMatrixParameter(u32 handle, const Matrix &value);
+        void setTextureParameter(u32 handle, sptr<Texture> value);
+
+        void bindFloatParameter(u32 handle, const std::function<float()> &valueGetter);
+        void bindVector2Parameter(u32 handle, const std::function<Vector2()> &valueGetter);
+        void bindVector3Parameter(u32 handle, const std::function<Vector3()> &valueGetter);
+        void bindVector4Parameter(u32 handle, const std::function<Vector4()> &valueGetter);
+        void bindMatrixParameter(u32 handle, const std::function<Matrix()> &valueGetter); // TODO return matrix reference from getter
+
+        void bindParameter(u32 handle, ParameterBinding binding);
 
-        virtual void bindFloatParameter(const str &name, const std::function<float()> &valueGetter) = 0;
-        virtual void bindVector2Parameter(const str &name, const std::function<Vector2()> &valueGetter) = 0;
-        virtual void bindVector3Parameter(const str &name, const std::function<Vector3()> &valueGetter) = 0;
-        virtual void bindVector4Parameter(const str &name, const std::function<Vector4()> &valueGetter) = 0;
-        virtual void bindMatrixParameter(const str &name, const std::function<Matrix()> &valueGetter) = 0; // TODO return matrix reference from getter
+        void setFloatParameter(const str &name, float value) {
+            setFloatParameter(parameterHandle(name), value);
+        }
+        void setVector2Parameter(const str &name, const Vector2 &value) {
+            setVector2Parameter(parameterHandle(name), value);
+        }
+        void setVector3Parameter(const str &name, const Vector3 &value) {
+            setVector3Parameter(parameterHandle(name), value);
+        }
+        void setVector4Parameter(const str &name, const Vector4 &value) {
+            setVector4Parameter(parameterHandle(name), value);
+        }
+        void setMatrixParameter(const str &name, const Matrix &value) {
+            setMatrixParameter(parameterHandle(name), value);
+        }
+        void setTextureParameter(const str &name, sptr<Texture> value) {
+            setTextureParameter(parameterHandle(name), value);
+        }
+
+        void bindFloatParameter(const str &name, const std::function<float()> &valueGetter) {
+            bindFloatParameter(parameterHandle(name), valueGetter);
+        }
+        void bindVector2Parameter(const str &name, const std::function<Vector2()> &valueGetter) {
+            bindVector2Parameter(parameterHandle(name), valueGetter);
+        }
+        void bindVector3Parameter(const str &name, const std::function<Vector3()> &valueGetter) {
+            bindVector3Parameter(parameterHandle(name), valueGetter);
+        }
+        void bindVector4Parameter(const str &name, const std::function<Vector4()> &valueGetter) {
+            bindVector4Parameter(parameterHandle(name), valueGetter);
+        }
+        void bindMatrixParameter(const str &name, const std::function<Matrix()> &valueGetter) {
+            bindMatrixParameter(parameterHandle(name), valueGetter);
+        }
 
-        virtual void bindParameter(const str &name, ParameterBinding binding) = 0;
+        void bindParameter(const str &name, ParameterBinding binding) {
+            bindParameter(parameterHandle(name), binding);
+        }
 
         virtual auto effect() const -> sptr<Effect> = 0;
 
         virtual auto clone() const -> sptr<Material> = 0;
 
+        // Lays the parameters out anew if the effect has been hot-reloaded since, keeping the values of
+        // parameters the new version still has. Called by renderers before drawing and by the parameter setters.
+        void syncWithEffect(const Effect *effect) {
+#ifdef SL_HOT_RELOAD
+            if (effectRevision_ != effect->revision())
+                rebuildParameters(effect);
+#else
+            (void)effect;
+#endif
+        }
+
         auto polygonMode() const -> PolygonMode {
             return polygonMode_;
         }
@@ -101,6 +157,43 @@ namespace solo {
         }
 
     protected:
+        enum class ParameterType {
+            None,
+            Float,
+            Vector2,
+            Vector3,
+            Vector4,
+            Matrix,
+            Texture
+        };
+
+        enum class ParameterSource {
+            Value,
+            Getter,
+            Binding
+        };
+
+        struct Parameter {
+            ParameterType type = ParameterType::None;
+            ParameterSource source = ParameterSource::Value;
+            u32 offset = 0; // in the block
+            u32 size = 0;
+            std::function<void(u8 *)> getter; // writes the value into the block
+            ParameterBinding binding = ParameterBinding::WorldMatrix;
+            sptr<Texture> texture;
+        };
+
+        // Indexed by effect parameter handles
+        vec<Parameter> parameters_;
+
+        // Parameter values in the layout defined by the effect. Values that are set once are stored
+        // right away, bound ones are written by updateDynamicParameters() on every draw.
+        vec<u8> block_;
+        vec<u32> dynamicParameters_;
+
+        // Changes every time a stored value changes, unique across materials
+        u64 blockVersion_ = 0;
+
         FaceCull faceCull_ = FaceCull::Back;
         PolygonMode polygonMode_ = PolygonMode::Fill;
         bool depthWrite_ = true;
@@ -110,7 +203,26 @@ namespace solo {
         BlendFactor dstBlendFactor_ = BlendFactor::OneMinusSrcAlpha;
         DepthFunction depthFunc_ = DepthFunction::Less;
 
-        Material() = default;
+        explicit Material(const sptr<Effect> &effect);
         Material(const Material &other) = default;
+
+        void updateDynamicParameters(const Camera *camera, const Transform *nodeTransform, ObjectMatrixCache *matrixCache);
+
+    private:
+#ifdef SL_HOT_RELOAD
+        // Parameter names by handle in the effect revision the parameters are laid out for
+        u64 effectRevision_ = 0;
+        vec<str> parameterNames_;
+
+        void rebuildParameters(const Effect *effect);
+#endif
+
+        auto parameterAt(u32 handle, ParameterType type, ParameterSource source) -> Parameter &;
+
+        template <class T>
+        void setValue(u32 handle, ParameterType type, const T &value);
+
+        template <class T>
+        void bindGetter(u32 handle, ParameterType type, const std::function<T()> &getter);
     };
 }
@@ -8,126 +8,16 @@
 #include "SoloDevice.h"
 #include "SoloFileSystem.h"
 #include "SoloJobPool.h"
+#include "SoloMappedFile.h"
+#include "SoloMeshData.h"
+#include "SoloCookedAssets.h"
+#include "SoloHotReload.h"
 #include "gl/SoloOpenGLMesh.h"
 #include "vk/SoloVulkanMesh.h"
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
+#include <algorithm>
 
 using namespace solo;
 
-// TODO Remove? This is mostly needed for async loading as we don't want to interact with GPU from the loading thread.
-class MeshData {
-public:
-    static auto fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData> {
-        // TODO Implement proper io system for assimp to avoid loading file into memory
-        const auto bytes = device->fileSystem()->readBytes(path);
-
-        Assimp::Importer importer;
-        const auto flags = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
-        const auto scene = importer.ReadFileFromMemory(bytes.data(), bytes.size(), flags);
-        panicIf(!scene, "Unable to parse file ", path);
-
-        auto data = std::make_shared<MeshData>();
-        u32 indexBase = 0;
-
-        // TODO resize vertices beforehand
-        for (u32 i = 0; i < scene->mNumMeshes; i++) {
-            const aiMesh *mesh = scene->mMeshes[i];
-            const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
-
-            for (u32 j = 0; j < mesh->mNumVertices; j++) {
-                const auto pos = &mesh->mVertices[j];
-                const auto normal = &mesh->mNormals[j];
-                const auto texCoord = mesh->HasTextureCoords(0) ? &mesh->mTextureCoords[0][j] : &zeroVec;
-                const auto tangent = mesh->HasTangentsAndBitangents() ? &mesh->mTangents[j] : &zeroVec;
-                const auto biTangent = mesh->HasTangentsAndBitangents() ? &mesh->mBitangents[j] : &zeroVec;
-
-                data->vertexCount_++;
-
-                for (u32 k = 0; k < bufferLayout.attributeCount(); k++) {
-                    const auto attr = bufferLayout.attribute(k);
-                    switch (attr.usage) {
-                        case VertexAttributeUsage::Position:
-                            data->vertexData_.push_back(pos->x);
-                            data->vertexData_.push_back(pos->y);
-                            data->vertexData_.push_back(pos->z);
-                            break;
-                        case VertexAttributeUsage::Normal:
-                            data->vertexData_.push_back(normal->x);
-                            data->vertexData_.push_back(normal->y);
-                            data->vertexData_.push_back(normal->z);
-                            break;
-                        case VertexAttributeUsage::TexCoord:
-                            data->vertexData_.push_back(texCoord->x);
-                            data->vertexData_.push_back(texCoord->y);
-                            break;
-                        case VertexAttributeUsage::Tangent:
-                            data->vertexData_.push_back(tangent->x);
-                            data->vertexData_.push_back(tangent->y);
-                            data->vertexData_.push_back(tangent->z);
-                            break;
-                        case VertexAttributeUsage::Binormal:
-                            data->vertexData_.push_back(biTangent->x);
-                            data->vertexData_.push_back(biTangent->y);
-                            data->vertexData_.push_back(biTangent->z);
-                            break;
-                        default:
-                            break;
-                    }
-                }
-            }
-
-            vec<u32> part;
-            part.resize(mesh->mNumFaces * 3);
-            for (u32 j = 0; j < mesh->mNumFaces; j++) {
-                const auto &face = mesh->mFaces[j];
-                if (face.mNumIndices == 3) {
-                    const auto startIdx = j * 3;
-                    part[startIdx] = indexBase + face.mIndices[0];
-                    part[startIdx + 1] = indexBase + face.mIndices[1];
-                    part[startIdx + 2] = indexBase + face.mIndices[2];
-                }
-            }
-
-            indexBase += mesh->mNumFaces * 3;
-            data->indexData_.emplace_back(std::move(part));
-        }
-
-        return data;
-    }
-
-    static auto fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<AsyncHandle<MeshData>> {
-        auto handle = std::make_shared<AsyncHandle<MeshData>>();
-
-        auto producers = JobBase<MeshData>::Producers{
-            [ = ]() {
-                return fromFile(device, path, bufferLayout);
-            }};
-        auto consumer = [handle](const vec<sptr<MeshData>> &results) {
-            handle->resolve(results[0]);
-        };
-        device->jobPool()->addJob(std::make_shared<JobBase<MeshData>>(producers, consumer));
-
-        return handle;
-    }
-
-    auto vertexData() const -> const vec<float> & { return vertexData_; }
-    auto vertexCount() const -> u32 { return vertexCount_; }
-
-    auto indexesCount() const -> u32 { return indexData_.size(); }
-    auto indexData(u32 index) const -> const vec<u32> & { return indexData_.at(index); }
-
-    auto indexElementCount(u32 index) const -> u32 {
-        return indexData_.at(index).size();
-    }
-
-private:
-    vec<float> vertexData_;
-    u32 vertexCount_ = 0;
-    vec<vec<u32>> indexData_;
-};
-
 auto Mesh::empty(Device *device) -> sptr<Mesh> {
     switch (device->mode()) {
 #ifdef SL_OPENGL_RENDERER
@@ -144,32 +34,63 @@ auto Mesh::empty(Device *device) -> sptr<Mesh> {
     }
 }
 
-static auto fromData(Device *device, sptr<MeshData> data, const VertexBufferLayout &bufferLayout) -> sptr<Mesh> {
+// The mesh shares the loaded data as its CPU copy instead of copying it
+static auto fromData(Device *device, sptr<MeshData> data, MeshCpuData cpuData) -> sptr<Mesh> {
     auto mesh = Mesh::empty(device);
+    mesh->setCpuData(cpuData);
 
-    mesh->addVertexBuffer(bufferLayout, data->vertexData(), data->vertexData().size() / bufferLayout.elementCount());
+    vec<Mesh::Part> parts;
+    for (u32 i = 0; i < data->partCount(); i++) {
+        const auto part = data->part(i);
+        parts.push_back(Mesh::Part{part.indexOffset, part.indexCount, part.baseVertex});
+    }
 
-    for (auto part = 0; part < data->indexesCount(); part++)
-        mesh->addIndexBuffer(data->indexData(part), data->indexElementCount(part));
+    if (const auto arena = device->geometryArena()) {
+        mesh->setArenaGeometry(arena, data->layout(), data->vertexData(), data->vertexCount(),
+            data->indexData(), data->indexCount(), parts, data);
+    } else {
+        mesh->addVertexBuffer(data->layout(), data->vertexData(), data->vertexCount(), data);
+        mesh->setIndexBuffer(data->indexData(), data->indexCount(), parts, data);
+    }
 
     return mesh;
 }
 
-auto Mesh::fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<Mesh> {
-    const auto data = MeshData::fromFile(device, path, bufferLayout);
-    return fromData(device, data, bufferLayout);
+auto Mesh::fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout, MeshCpuData cpuData) -> sptr<Mesh> {
+    const auto data = MeshData::fromFile(device->fileSystem(), device->cookedAssets()->resolve(path), bufferLayout, device->jobPool());
+    const auto mesh = fromData(device, data, cpuData);
+    if (const auto hotReload = device->hotReload())
+        hotReload->trackMesh(mesh, path, bufferLayout, cpuData);
+    return mesh;
 }
 
-auto Mesh::fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout)
+auto Mesh::fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout, MeshCpuData cpuData)
 -> sptr<AsyncHandle<Mesh>> {
-    auto handle = std::make_shared<AsyncHandle<Mesh>>();
+    const auto create = [device, path, bufferLayout, cpuData](sptr<MeshData> data) {
+        const auto mesh = fromData(device, data, cpuData);
+        if (const auto hotReload = device->hotReload())
+            hotReload->trackMesh(mesh, path, bufferLayout, cpuData);
+        return mesh;
+    };
+
+    // Cooked meshes are used right from the mapped file, source files are read asynchronously and imported on a worker
+    const auto resolvedPath = device->cookedAssets()->resolve(path);
+    if (MeshData::isBinaryFile(resolvedPath)) {
+        const auto load = [device, resolvedPath, bufferLayout]() {
+            return MeshData::fromFile(device->fileSystem(), resolvedPath, bufferLayout, device->jobPool());
+        };
+        return AsyncHandle<MeshData>::run(device->jobPool(), JobThread::Worker, load)->then(JobThread::Main, create);
+    }
 
-    MeshData::fromFileAsync(device, path, bufferLayout)->done(
-    [handle, device, bufferLayout](sptr<MeshData> data) {
-        handle->resolve(fromData(device, data, bufferLayout));
-    });
+    return device->fileSystem()->readBytesAsync(resolvedPath)->then(JobThread::Worker,
+    [device, resolvedPath, bufferLayout](sptr<vec<u8>> bytes) {
+        const auto contents = MappedFile::fromBytes(std::move(*bytes));
+        return MeshData::fromMemory(device->fileSystem(), resolvedPath, contents, bufferLayout, device->jobPool());
+    })->then(JobThread::Main, create);
+}
 
-    return handle;
+void Mesh::cook(Device *device, const str &sourcePath, const str &targetPath, const VertexBufferLayout &bufferLayout) {
+    MeshData::fromFile(device->fileSystem(), sourcePath, bufferLayout)->saveBinary(device->fileSystem(), targetPath);
 }
 
 void Mesh::updateMinVertexCount() {
@@ -184,37 +105,193 @@ void Mesh::updateMinVertexCount() {
         minVertexCount_ = 0;
 }
 
-auto Mesh::addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
+void Mesh::setCpuData(MeshCpuData cpuData) {
+    if (cpuData == MeshCpuData::Release)
+        panicIfCpuDataPinned();
+    cpuData_ = cpuData;
+    if (cpuData == MeshCpuData::Release) {
+        for (auto &copy : vertexData_)
+            copy = CpuCopy{nullptr, nullptr};
+        indexData_ = CpuCopy{nullptr, nullptr};
+    }
+}
+
+void Mesh::pinCpuData() {
+    panicIf(cpuData_ != MeshCpuData::Keep, "Mesh must keep its CPU data (MeshCpuData::Keep) to be pinned");
+    ++cpuDataPins_;
+}
+
+void Mesh::unpinCpuData() {
+    panicIf(!cpuDataPins_, "Mesh CPU data is not pinned");
+    --cpuDataPins_;
+}
+
+auto Mesh::keep(const void *data, size_t size, sptr<const void> owner) const -> CpuCopy {
+    if (cpuData_ == MeshCpuData::Release || !data)
+        return CpuCopy{nullptr, nullptr};
+    if (owner)
+        return CpuCopy{data, owner};
+
+    const auto bytes = static_cast<const u8 *>(data);
+    const auto copy = std::make_shared<vec<u8>>(bytes, bytes + size);
+    return CpuCopy{copy->data(), copy};
+}
+
+auto Mesh::addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, sptr<const void> owner, bool dynamic) -> u32 {
+    panicIfInArena();
+    uploadVertexBuffer(layout, data, vertexCount, dynamic);
     layouts_.push_back(layout);
     vertexCounts_.push_back(vertexCount);
-    vertexData_.push_back(data); // TODO move
+    vertexData_.push_back(keep(data, static_cast<size_t>(layout.size()) * vertexCount, owner));
     updateMinVertexCount();
     return static_cast<u32>(vertexCounts_.size() - 1);
 }
 
+auto Mesh::addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount) -> u32 {
+    return addVertexBuffer(layout, data, vertexCount, nullptr, false);
+}
+
+auto Mesh::addDynamicVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount) -> u32 {
+    return addVertexBuffer(layout, data, vertexCount, nullptr, true);
+}
+
+auto Mesh::addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, sptr<const void> owner) -> u32 {
+    return addVertexBuffer(layout, data, vertexCount, owner, false);
+}
+
+auto Mesh::addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
+    if (layout.isFloat())
+        return addVertexBuffer(layout, static_cast<const void *>(data.data()), vertexCount);
+    // The packed vector becomes the CPU copy
+    const auto packed = std::make_shared<vec<u8>>(layout.pack(data.data(), vertexCount));
+    return addVertexBuffer(layout, packed->data(), vertexCount, packed, false);
+}
+
 auto Mesh::addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
-    // TODO No copy-paste
-    layouts_.push_back(layout);
-    vertexCounts_.push_back(vertexCount);
-    vertexData_.push_back(data); // TODO move
-    updateMinVertexCount();
-    return static_cast<u32>(vertexCounts_.size() - 1);
+    if (layout.isFloat())
+        return addDynamicVertexBuffer(layout, static_cast<const void *>(data.data()), vertexCount);
+    const auto packed = std::make_shared<vec<u8>>(layout.pack(data.data(), vertexCount));
+    return addVertexBuffer(layout, packed->data(), vertexCount, packed, true);
+}
+
+void Mesh::updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) {
+    panicIfInArena();
+    uploadVertexBufferPart(index, vertexOffset, data, vertexCount);
 }
 
 void Mesh::removeVertexBuffer(u32 index) {
+    panicIfInArena();
+    panicIfCpuDataPinned();
+    destroyVertexBuffer(index);
     vertexCounts_.erase(vertexCounts_.begin() + index);
     vertexData_.erase(vertexData_.begin() + index);
     layouts_.erase(layouts_.begin() + index);
     updateMinVertexCount();
 }
 
+// 0xffff is left out, it is the primitive restart index for 16-bit indices
+static auto indexElementSizeFor(const u32 *data, u32 indexCount) -> IndexElementSize {
+    const auto fitsBits16 = std::all_of(data, data + indexCount, [](u32 i) { return i < 0xffff; });
+    return fitsBits16 ? IndexElementSize::Bits16 : IndexElementSize::Bits32;
+}
+
+// Contents of the GPU index buffer: the indices themselves, or their 16-bit version stored in `shortIndices`
+static auto gpuIndexData(const u32 *data, u32 indexCount, IndexElementSize elementSize, vec<u16> &shortIndices) -> const void * {
+    if (elementSize == IndexElementSize::Bits32)
+        return data;
+    shortIndices.assign(data, data + indexCount);
+    return shortIndices.data();
+}
+
+void Mesh::setIndexBuffer(const u32 *data, u32 indexCount, const vec<Part> &parts) {
+    setIndexBuffer(data, indexCount, parts, nullptr);
+}
+
+void Mesh::setIndexBuffer(const u32 *data, u32 indexCount, const vec<Part> &parts, sptr<const void> owner) {
+    panicIfInArena();
+    panicIfCpuDataPinned();
+    for (const auto &part : parts)
+        panicIf(static_cast<u64>(part.indexOffset) + part.indexCount > indexCount, "Mesh part is out of index buffer bounds");
+
+    indexElementSize_ = indexElementSizeFor(data, indexCount);
+    vec<u16> shortIndices;
+    uploadIndexBuffer(gpuIndexData(data, indexCount, indexElementSize_, shortIndices), indexCount);
+
+    indexData_ = keep(data, static_cast<size_t>(indexCount) * sizeof(u32), owner);
+    indexCount_ = indexCount;
+    parts_ = parts;
+}
+
+void Mesh::setIndexBuffer(vec<u32> &&data, const vec<Part> &parts) {
+    const auto indices = std::make_shared<vec<u32>>(std::move(data));
+    setIndexBuffer(indices->data(), static_cast<u32>(indices->size()), parts, indices);
+}
+
 auto Mesh::addIndexBuffer(const vec<u32> &data, u32 elementCount) -> u32 {
-    indexElementCounts_.push_back(elementCount);
-    indexData_.push_back(data);
-    return static_cast<u32>(indexElementCounts_.size() - 1);
+    panicIf(indexCount_ && !indexData(), "Mesh CPU data has been released, indices can't be appended");
+    const auto count = (std::min)(elementCount, static_cast<u32>(data.size()));
+    vec<u32> indices;
+    indices.reserve(indexCount_ + count);
+    indices.insert(indices.end(), indexData(), indexData() + indexCount_);
+    indices.insert(indices.end(), data.begin(), data.begin() + count);
+    auto parts = parts_;
+    parts.push_back(Part{indexCount_, count, 0});
+    setIndexBuffer(std::move(indices), parts);
+    return static_cast<u32>(parts_.size() - 1);
 }
 
 void Mesh::removeIndexBuffer(u32 index) {
-    indexElementCounts_.erase(indexElementCounts_.begin() + index);
-    indexData_.erase(indexData_.begin() + index);
+    panicIf(!indexData(), "Mesh CPU data has been released, indices can't be removed");
+    const auto removed = parts_.at(index);
+    vec<u32> indices(indexData(), indexData() + indexCount_);
+    indices.erase(indices.begin() + removed.indexOffset, indices.begin() + removed.indexOffset + removed.indexCount);
+    auto parts = parts_;
+    parts.erase(parts.begin() + index);
+    for (auto &part : parts) {
+        if (part.indexOffset > removed.indexOffset)
+            part.indexOffset -= removed.indexCount;
+    }
+    setIndexBuffer(std::move(indices), parts);
+}
+
+void Mesh::setArenaGeometry(GeometryArena *arena, const VertexBufferLayout &layout, const void *vertices, u32 vertexCount,
+    const u32 *indices, u32 indexCount, const vec<Part> &parts, sptr<const void> owner) {
+    panicIf(!layouts_.empty() || !parts_.empty(), "Only empty meshes can be put into the geometry arena");
+    for (const auto &part : parts)
+        panicIf(static_cast<u64>(part.indexOffset) + part.indexCount > indexCount, "Mesh part is out of index buffer bounds");
+
+    indexElementSize_ = indexElementSizeFor(indices, indexCount);
+    vec<u16> shortIndices;
+    arenaAllocation_ = arena->allocate(layout, vertices, vertexCount, indexElementSize_,
+        gpuIndexData(indices, indexCount, indexElementSize_, shortIndices), indexCount);
+
+    layouts_.push_back(layout);
+    vertexCounts_.push_back(vertexCount);
+    vertexData_.push_back(keep(vertices, static_cast<size_t>(layout.size()) * vertexCount, owner));
+    updateMinVertexCount();
+    indexData_ = keep(indices, static_cast<size_t>(indexCount) * sizeof(u32), owner);
+    indexCount_ = indexCount;
+    parts_ = parts;
+}
+
+void Mesh::swapContents(Mesh &other) {
+    panicIfCpuDataPinned();
+    other.panicIfCpuDataPinned();
+    std::swap(layouts_, other.layouts_);
+    std::swap(parts_, other.parts_);
+    std::swap(indexElementSize_, other.indexElementSize_);
+    std::swap(minVertexCount_, other.minVertexCount_);
+    std::swap(arenaAllocation_, other.arenaAllocation_);
+    std::swap(vertexData_, other.vertexData_);
+    std::swap(indexData_, other.indexData_);
+    std::swap(indexCount_, other.indexCount_);
+    std::swap(vertexCounts_, other.vertexCounts_);
+}
+
+void Mesh::panicIfInArena() const {
+    panicIf(arenaAllocation_ != nullptr, "Meshes in the geometry arena can't be modified");
+}
+
+void Mesh::panicIfCpuDataPinned() const {
+    panicIf(cpuDataPins_ > 0, "Mesh CPU data is pinned (see Mesh::pinCpuData) and can't be released or replaced");
 }
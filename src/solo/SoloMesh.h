@@ -8,6 +8,7 @@
 #include "SoloCommon.h"
 #include "SoloVertexBufferLayout.h"
 #include "SoloAsyncHandle.h"
+#include "SoloGeometryArena.h"
 
 namespace solo {
     class Device;
@@ -15,9 +16,24 @@ namespace solo {
     // TODO Support for "non-GPU" meshes
     class Mesh {
     public:
+        // A range of the mesh's single index buffer, drawn with its own material. Indices are relative to baseVertex.
+        struct Part {
+            u32 indexOffset;
+            u32 indexCount;
+            u32 baseVertex;
+        };
+
         static auto empty(Device *device) -> sptr<Mesh>;
-        static auto fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<Mesh>;
-        static auto fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<AsyncHandle<Mesh>>;
+        // Vertices come in the layout's formats, pass layout.toCompact() for smaller ones (see VertexBufferLayout::toCompact).
+        // The loaded data becomes the mesh's CPU copy as is, with MeshCpuData::Release it is freed once uploaded.
+        static auto fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout,
+            MeshCpuData cpuData = MeshCpuData::Keep) -> sptr<Mesh>;
+        static auto fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout,
+            MeshCpuData cpuData = MeshCpuData::Keep) -> sptr<AsyncHandle<Mesh>>;
+
+        // Imports a mesh with assimp and stores it in the binary format (.slmesh), which fromFile then loads
+        // without any parsing. The layout is baked into the file, loading with a different one is slower.
+        static void cook(Device *device, const str &sourcePath, const str &targetPath, const VertexBufferLayout &bufferLayout);
 
         Mesh(const Mesh &other) = delete;
         Mesh(Mesh &&other) = delete;
@@ -26,39 +42,105 @@ namespace solo {
         auto operator=(const Mesh &other) -> Mesh & = delete;
         auto operator=(Mesh &&other) -> Mesh & = delete;
 
-        virtual auto addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32;
-        virtual auto addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32;
-        virtual void updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) {}
-        virtual void removeVertexBuffer(u32 index);
+        // CPU copies of vertices and indices are only needed by code reading them back (colliders, scripts).
+        // Switching to Release frees the current ones, later buffers are uploaded without keeping any.
+        auto cpuData() const -> MeshCpuData { return cpuData_; }
+        void setCpuData(MeshCpuData cpuData);
+
+        // Consumers reading the CPU copy in place (colliders) pin it and unpin it when done. While pinned the copy
+        // can't be released or replaced: switching to Release, changing indices or vertex buffers and swapping panic.
+        void pinCpuData();
+        void unpinCpuData();
+        bool isCpuDataPinned() const { return cpuDataPins_ > 0; }
+
+        // Vertices already in the layout's formats, layout.size() bytes each. Copied when the mesh keeps CPU data.
+        auto addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount) -> u32;
+        auto addDynamicVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount) -> u32;
+        // Same without copying: `data` stays valid while `owner` lives, and the mesh holds on to `owner` instead
+        auto addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, sptr<const void> owner) -> u32;
+        // Floats, elementCount of them per attribute, converted to the layout's formats
+        auto addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32;
+        auto addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32;
+        // Only changes the GPU buffer
+        void updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount);
+        void removeVertexBuffer(u32 index);
 
         auto vertexBufferCount() const -> u32 { return static_cast<u32>(layouts_.size()); }
         auto vertexBufferVertexCount(u32 index) const -> u32 { return vertexCounts_.at(index); }
         auto vertexBufferLayout(u32 index) const -> VertexBufferLayout { return layouts_.at(index); }
-        auto vertexBufferData(u32 index) const -> const vec<float> & { return vertexData_.at(index); }
+        // Null once the CPU copy has been released
+        auto vertexBufferData(u32 index) const -> const u8 * { return static_cast<const u8 *>(vertexData_.at(index).data); }
+
+        // All parts share one index buffer, so drawing them one after another only changes draw parameters.
+        // Replaces the current index buffer and parts. The overloads with an owner or a vector don't copy.
+        void setIndexBuffer(const u32 *data, u32 indexCount, const vec<Part> &parts);
+        void setIndexBuffer(const u32 *data, u32 indexCount, const vec<Part> &parts, sptr<const void> owner);
+        void setIndexBuffer(vec<u32> &&data, const vec<Part> &parts);
+        // Append or remove one part with its own indices. Both re-upload the whole index buffer and need
+        // the CPU copy of the existing indices, so meshes with many parts should be built with setIndexBuffer.
+        auto addIndexBuffer(const vec<u32> &data, u32 elementCount) -> u32;
+        void removeIndexBuffer(u32 index);
+        auto indexBufferCount() const -> u32 { return static_cast<u32>(parts_.size()); }
+        auto indexBufferElementCount(u32 index) const -> u32 { return parts_.at(index).indexCount; }
+        auto part(u32 index) const -> Part { return parts_.at(index); }
+        // Size of indices in the GPU buffer, 16 bits whenever they fit. The CPU copy (indexData) is always 32-bit.
+        auto indexElementSize() const -> IndexElementSize { return indexElementSize_; }
+        auto indexCount() const -> u32 { return indexCount_; }
+        // Null once the CPU copy has been released
+        auto indexData() const -> const u32 * { return static_cast<const u32 *>(indexData_.data); }
 
-        virtual auto addIndexBuffer(const vec<u32> &data, u32 elementCount) -> u32;
-        virtual void removeIndexBuffer(u32 index);
-        auto indexBufferCount() const -> u32 { return static_cast<u32>(indexElementCounts_.size()); }
-        auto indexBufferElementCount(u32 index) const -> u32 { return indexElementCounts_.at(index); }
-        auto indexBufferElementSize(u32 index) const -> IndexElementSize { return IndexElementSize::Bits32; } // TODO 16-bit support?
-        auto indexData(u32 index) const -> const vec<u32> & { return indexData_.at(index); }
+        // Puts the vertices and indices into the arena instead of buffers of the mesh's own (see DeviceSetup::geometryArena).
+        // Only for empty meshes. Such a mesh has one vertex buffer, and neither it nor the indices can be changed afterwards.
+        // With an owner nothing is copied, as with addVertexBuffer.
+        void setArenaGeometry(GeometryArena *arena, const VertexBufferLayout &layout, const void *vertices, u32 vertexCount,
+            const u32 *indices, u32 indexCount, const vec<Part> &parts, sptr<const void> owner = nullptr);
+        bool isInGeometryArena() const { return arenaAllocation_ != nullptr; }
 
         auto primitiveType() const -> PrimitiveType { return primitiveType_; }
         void setPrimitiveType(PrimitiveType type) { primitiveType_ = type; }
 
+        // Exchanges buffers, parts and CPU copies with another mesh of the same backend, keeping the primitive
+        // type and CPU data mode of each. Used by hot reload (see HotReload) to update live meshes in place.
+        virtual void swapContents(Mesh &other);
+
     protected:
         PrimitiveType primitiveType_ = PrimitiveType::Triangles;
         vec<VertexBufferLayout> layouts_;
-        vec<u32> indexElementCounts_;
+        vec<Part> parts_;
+        IndexElementSize indexElementSize_ = IndexElementSize::Bits32;
         u32 minVertexCount_ = 0;
+        sptr<GeometryArena::Allocation> arenaAllocation_;
 
         Mesh() = default;
 
+        // Where the mesh's vertices and indices start in the buffers it is drawn from, non-zero in the geometry arena
+        auto firstVertex() const -> u32 { return arenaAllocation_ ? arenaAllocation_->firstVertex() : 0; }
+        auto firstIndex() const -> u32 { return arenaAllocation_ ? arenaAllocation_->firstIndex() : 0; }
+
+        // GPU side of the buffers, implemented by the backends. Indices come in the indexElementSize_ format.
+        virtual void uploadVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) = 0;
+        virtual void uploadVertexBufferPart(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) = 0;
+        virtual void destroyVertexBuffer(u32 index) = 0;
+        virtual void uploadIndexBuffer(const void *data, u32 indexCount) = 0;
+
     private:
-        vec<vec<float>> vertexData_;
-        vec<vec<u32>> indexData_;
+        // A CPU copy, valid while its owner lives. The owner is either a vector of the mesh's own or shared data such as MeshData.
+        struct CpuCopy {
+            const void *data;
+            sptr<const void> owner;
+        };
+
+        MeshCpuData cpuData_ = MeshCpuData::Keep;
+        u32 cpuDataPins_ = 0;
+        vec<CpuCopy> vertexData_;
+        CpuCopy indexData_{nullptr, nullptr};
+        u32 indexCount_ = 0;
         vec<u32> vertexCounts_;
 
+        auto addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, sptr<const void> owner, bool dynamic) -> u32;
+        auto keep(const void *data, size_t size, sptr<const void> owner) const -> CpuCopy;
+        void panicIfInArena() const;
+        void panicIfCpuDataPinned() const;
         void updateMinVertexCount();
     };
 }
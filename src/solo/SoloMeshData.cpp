@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloMeshData.h"
+#include "SoloFileSystem.h"
+#include "SoloMappedFile.h"
+#include "SoloBinaryIO.h"
+#include "SoloJobPool.h"
+#include "SoloMeshOptimizer.h"
+#include <assimp/Importer.hpp>
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace solo;
+
+// Binary mesh file: header, attribute usages and formats, parts, then vertex and index data, each starting at
+// a 16-byte aligned offset so that both can be used straight from the mapped file.
+// Everything is stored in the native (little-endian) byte order.
+namespace {
+    const auto binaryExtension = str(".slmesh");
+    const u32 binaryMagic = 0x48534d53; // "SMSH"
+    const u32 binaryVersion = 3;
+    const u32 binaryDataAlignment = 16;
+
+    struct BinaryHeader {
+        u32 magic;
+        u32 version;
+        u32 attributeCount;
+        u32 partCount;
+        u32 vertexCount;
+        u32 indexCount;
+        float boundsMin[3];
+        float boundsMax[3];
+        u64 vertexDataOffset;
+        u64 indexDataOffset;
+    };
+
+    auto alignUp(u64 value, u64 alignment) -> u64 {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    struct AttributeSlot {
+        VertexAttributeUsage usage;
+        u32 offset; // in floats
+        u32 elementCount;
+    };
+
+    struct PartRange {
+        u32 vertexOffset; // where the part has been built, before optimization
+        u32 optimizedVertexOffset;
+        u32 vertexCount;
+        u32 indexOffset;
+        aiVector3D boundsMin;
+        aiVector3D boundsMax;
+    };
+
+    auto attributeSource(const aiMesh *mesh, VertexAttributeUsage usage) -> const aiVector3D * {
+        switch (usage) {
+            case VertexAttributeUsage::Position:
+                return mesh->mVertices;
+            case VertexAttributeUsage::Normal:
+                return mesh->mNormals;
+            case VertexAttributeUsage::TexCoord:
+                return mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0] : nullptr;
+            case VertexAttributeUsage::Tangent:
+                return mesh->HasTangentsAndBitangents() ? mesh->mTangents : nullptr;
+            case VertexAttributeUsage::Binormal:
+                return mesh->HasTangentsAndBitangents() ? mesh->mBitangents : nullptr;
+            default:
+                return nullptr;
+        }
+    }
+
+    // One attribute at a time into a buffer that has been zeroed already, so missing attributes are just skipped
+    void buildVertices(const aiMesh *mesh, const vec<AttributeSlot> &plan, u32 stride, float *out) {
+        for (const auto &slot : plan) {
+            const auto source = attributeSource(mesh, slot.usage);
+            if (!source)
+                continue;
+
+            auto target = out + slot.offset;
+            const auto elementCount = (std::min)(slot.elementCount, 3u);
+            for (u32 j = 0; j < mesh->mNumVertices; j++, target += stride) {
+                const auto &v = source[j];
+                target[0] = v.x;
+                if (elementCount > 1)
+                    target[1] = v.y;
+                if (elementCount > 2)
+                    target[2] = v.z;
+            }
+        }
+    }
+
+    void buildIndices(const aiMesh *mesh, u32 *out) {
+        for (u32 j = 0; j < mesh->mNumFaces; j++, out += 3) {
+            const auto &face = mesh->mFaces[j];
+            if (face.mNumIndices == 3) {
+                out[0] = face.mIndices[0];
+                out[1] = face.mIndices[1];
+                out[2] = face.mIndices[2];
+            }
+        }
+    }
+
+    // Works in place on the part's own vertices and indices, the vertex count can only go down.
+    // Only the attributes of the requested layout are compared when welding.
+    auto optimizePart(float *vertices, u32 vertexCount, u32 stride, s32 positionOffset, u32 *indices, u32 indexCount,
+        MeshData::PartStats &stats) -> u32 {
+        stats.importedVertexCount = vertexCount;
+        stats.importedAcmr = meshopt::averageCacheMissRatio(indices, indexCount, vertexCount);
+
+        vertexCount = meshopt::weldVertices(vertices, vertexCount, stride, indices, indexCount);
+        meshopt::optimizeVertexCache(indices, indexCount, vertexCount);
+        if (positionOffset >= 0)
+            meshopt::optimizeOverdraw(indices, indexCount, vertices + positionOffset, stride, vertexCount);
+        vertexCount = meshopt::optimizeVertexFetch(vertices, vertexCount, stride, indices, indexCount);
+
+        stats.vertexCount = vertexCount;
+        stats.acmr = meshopt::averageCacheMissRatio(indices, indexCount, vertexCount);
+        return vertexCount;
+    }
+
+    void computeBounds(const aiMesh *mesh, aiVector3D &min, aiVector3D &max) {
+        min = aiVector3D((std::numeric_limits<float>::max)());
+        max = aiVector3D(std::numeric_limits<float>::lowest());
+        for (u32 j = 0; j < mesh->mNumVertices; j++) {
+            const auto &pos = mesh->mVertices[j];
+            min.x = (std::min)(min.x, pos.x);
+            min.y = (std::min)(min.y, pos.y);
+            min.z = (std::min)(min.z, pos.z);
+            max.x = (std::max)(max.x, pos.x);
+            max.y = (std::max)(max.y, pos.y);
+            max.z = (std::max)(max.z, pos.z);
+        }
+    }
+
+    // Reads straight from a mapped file, so the importer doesn't need a copy of the whole file
+    // and only the pages it actually touches get loaded
+    class AssimpMappedStream final: public Assimp::IOStream {
+    public:
+        explicit AssimpMappedStream(sptr<MappedFile> file): file_(file) {
+        }
+
+        auto Read(void *buffer, size_t size, size_t count) -> size_t override {
+            if (!size || !count)
+                return 0;
+            count = (std::min)(count, (file_->size() - position_) / size);
+            std::memcpy(buffer, file_->data() + position_, size * count);
+            position_ += size * count;
+            return count;
+        }
+
+        auto Write(const void * /*buffer*/, size_t /*size*/, size_t /*count*/) -> size_t override {
+            return 0;
+        }
+
+        auto Seek(size_t offset, aiOrigin origin) -> aiReturn override {
+            size_t position;
+            switch (origin) {
+                case aiOrigin_SET:
+                    position = offset;
+                    break;
+                case aiOrigin_CUR:
+                    position = position_ + offset;
+                    break;
+                case aiOrigin_END:
+                    position = file_->size() - offset;
+                    break;
+                default:
+                    return aiReturn_FAILURE;
+            }
+            if (position > file_->size())
+                return aiReturn_FAILURE;
+            position_ = position;
+            return aiReturn_SUCCESS;
+        }
+
+        auto Tell() const -> size_t override {
+            return position_;
+        }
+
+        auto FileSize() const -> size_t override {
+            return file_->size();
+        }
+
+        void Flush() override {
+        }
+
+    private:
+        sptr<MappedFile> file_;
+        size_t position_ = 0;
+    };
+
+    // Lets importers open side files (.mtl next to .obj and such) through the engine file system.
+    // The main file can come in read already.
+    class AssimpIOSystem final: public Assimp::IOSystem {
+    public:
+        AssimpIOSystem(FileSystem *fs, const str &mainPath, sptr<MappedFile> mainContents):
+            fs_(fs),
+            mainPath_(mainPath),
+            mainContents_(std::move(mainContents)) {
+        }
+
+        bool Exists(const s8 *path) const override {
+            return (mainContents_ && mainPath_ == path) || fs_->exists(path);
+        }
+
+        auto getOsSeparator() const -> s8 override {
+            return '/';
+        }
+
+        auto Open(const s8 *path, const s8 *mode) -> Assimp::IOStream * override {
+            if (std::strchr(mode, 'w') || std::strchr(mode, 'a') || !Exists(path))
+                return nullptr;
+            return new AssimpMappedStream(mainContents_ && mainPath_ == path ? mainContents_ : fs_->map(path));
+        }
+
+        void Close(Assimp::IOStream *stream) override {
+            delete stream;
+        }
+
+    private:
+        FileSystem *fs_ = nullptr;
+        str mainPath_;
+        sptr<MappedFile> mainContents_;
+    };
+}
+
+auto MeshData::fromFile(FileSystem *fs, const str &path, const VertexBufferLayout &bufferLayout, JobPool *jobPool) -> sptr<MeshData> {
+    return isBinaryFile(path)
+        ? fromBinary(fs->map(path), path, bufferLayout)
+        : fromAssimp(fs, path, nullptr, bufferLayout, jobPool);
+}
+
+auto MeshData::fromMemory(FileSystem *fs, const str &path, sptr<MappedFile> contents, const VertexBufferLayout &bufferLayout,
+    JobPool *jobPool) -> sptr<MeshData> {
+    return isBinaryFile(path)
+        ? fromBinary(contents, path, bufferLayout)
+        : fromAssimp(fs, path, contents, bufferLayout, jobPool);
+}
+
+bool MeshData::isBinaryFile(const str &path) {
+    return path.size() >= binaryExtension.size() &&
+        path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0;
+}
+
+auto MeshData::fromAssimp(FileSystem *fs, const str &path, sptr<MappedFile> contents, const VertexBufferLayout &bufferLayout,
+    JobPool *jobPool) -> sptr<MeshData> {
+    Assimp::Importer importer;
+    importer.SetIOHandler(new AssimpIOSystem(fs, path, contents)); // importer takes ownership
+    const auto flags = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
+    const auto scene = importer.ReadFile(path, flags);
+    assetErrorIf(!scene, "Unable to parse file ", path, ": ", importer.GetErrorString());
+
+    auto data = sptr<MeshData>(new MeshData());
+    data->layout_ = bufferLayout;
+
+    // Vertices are built as floats first and packed part by part when the layout asks for other formats
+    const auto floatLayout = bufferLayout.toFloat();
+    const auto packed = !bufferLayout.isFloat();
+
+    // Where everything goes, computed once for the whole file
+    vec<AttributeSlot> plan;
+    for (u32 k = 0; k < floatLayout.attributeCount(); k++) {
+        const auto attr = floatLayout.attribute(k);
+        plan.push_back(AttributeSlot{attr.usage, attr.offset / static_cast<u32>(sizeof(float)), attr.elementCount});
+    }
+
+    vec<PartRange> ranges(scene->mNumMeshes);
+    u32 vertexCount = 0, indexCount = 0;
+    for (u32 i = 0; i < scene->mNumMeshes; i++) {
+        const auto mesh = scene->mMeshes[i];
+        ranges[i] = PartRange{vertexCount, 0, 0, indexCount};
+        vertexCount += mesh->mNumVertices;
+        indexCount += mesh->mNumFaces * 3;
+    }
+
+    // Float layouts are built right in the final buffer, parts are moved together once optimization has shrunk them
+    const auto stride = floatLayout.elementCount();
+    const auto positionIndex = floatLayout.attributeIndex(VertexAttributeUsage::Position);
+    const auto positionOffset = positionIndex >= 0 ? static_cast<s32>(floatLayout.attribute(positionIndex).offset / sizeof(float)) : -1;
+    vec<float> floatVertices(packed ? static_cast<size_t>(vertexCount) * stride : 0);
+    if (!packed)
+        data->ownedVertices_.resize(static_cast<size_t>(vertexCount) * floatLayout.size());
+    const auto builtVertices = packed ? floatVertices.data() : reinterpret_cast<float *>(data->ownedVertices_.data());
+    data->ownedIndices_.resize(indexCount);
+    data->partStats_.resize(scene->mNumMeshes);
+
+    const auto buildParts = [&](u32 begin, u32 end) {
+        for (auto i = begin; i < end; i++) {
+            const auto mesh = scene->mMeshes[i];
+            auto &range = ranges[i];
+            const auto vertices = builtVertices + static_cast<size_t>(range.vertexOffset) * stride;
+            const auto indices = data->ownedIndices_.data() + range.indexOffset;
+            const auto partIndexCount = mesh->mNumFaces * 3;
+            buildVertices(mesh, plan, stride, vertices);
+            buildIndices(mesh, indices);
+            computeBounds(mesh, range.boundsMin, range.boundsMax);
+            range.vertexCount = optimizePart(vertices, mesh->mNumVertices, stride, positionOffset, indices, partIndexCount, data->partStats_[i]);
+        }
+    };
+
+    const auto packParts = [&](u32 begin, u32 end) {
+        for (auto i = begin; i < end; i++) {
+            const auto &range = ranges[i];
+            VertexBufferLayout::convert(floatLayout, floatVertices.data() + static_cast<size_t>(range.vertexOffset) * stride, bufferLayout,
+                data->ownedVertices_.data() + static_cast<size_t>(range.optimizedVertexOffset) * bufferLayout.size(), range.vertexCount);
+        }
+    };
+
+    const auto parallel = jobPool && scene->mNumMeshes > 1;
+    if (parallel)
+        jobPool->parallelFor(0, scene->mNumMeshes, 1, buildParts);
+    else
+        buildParts(0, scene->mNumMeshes);
+
+    vertexCount = 0;
+    for (auto &range : ranges) {
+        range.optimizedVertexOffset = vertexCount;
+        vertexCount += range.vertexCount;
+    }
+
+    if (packed) {
+        data->ownedVertices_.resize(static_cast<size_t>(vertexCount) * bufferLayout.size());
+        if (parallel)
+            jobPool->parallelFor(0, scene->mNumMeshes, 1, packParts);
+        else
+            packParts(0, scene->mNumMeshes);
+    } else {
+        // In order, so a part never overwrites one that hasn't been moved yet
+        for (const auto &range : ranges) {
+            std::memmove(builtVertices + static_cast<size_t>(range.optimizedVertexOffset) * stride,
+                builtVertices + static_cast<size_t>(range.vertexOffset) * stride, static_cast<size_t>(range.vertexCount) * stride * sizeof(float));
+        }
+        data->ownedVertices_.resize(static_cast<size_t>(vertexCount) * bufferLayout.size());
+        data->ownedVertices_.shrink_to_fit();
+    }
+
+    auto boundsMin = aiVector3D((std::numeric_limits<float>::max)());
+    auto boundsMax = aiVector3D(std::numeric_limits<float>::lowest());
+    for (u32 i = 0; i < scene->mNumMeshes; i++) {
+        const auto &range = ranges[i];
+        boundsMin = aiVector3D((std::min)(boundsMin.x, range.boundsMin.x), (std::min)(boundsMin.y, range.boundsMin.y), (std::min)(boundsMin.z, range.boundsMin.z));
+        boundsMax = aiVector3D((std::max)(boundsMax.x, range.boundsMax.x), (std::max)(boundsMax.y, range.boundsMax.y), (std::max)(boundsMax.z, range.boundsMax.z));
+        data->parts_.push_back(Part{range.indexOffset, scene->mMeshes[i]->mNumFaces * 3, range.optimizedVertexOffset});
+    }
+
+    data->vertexCount_ = vertexCount;
+    data->vertices_ = data->ownedVertices_.data();
+    data->indexCount_ = indexCount;
+    data->indices_ = data->ownedIndices_.data();
+    if (data->vertexCount_) {
+        data->boundsMin_ = Vector3(boundsMin.x, boundsMin.y, boundsMin.z);
+        data->boundsMax_ = Vector3(boundsMax.x, boundsMax.y, boundsMax.z);
+    }
+
+    return data;
+}
+
+auto MeshData::fromBinary(sptr<MappedFile> file, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData> {
+    BinaryReader reader(file->data(), file->size());
+
+    const auto header = reader.read<BinaryHeader>();
+    assetErrorIf(!reader.isOk() || header.magic != binaryMagic, "File ", path, " is not a binary mesh");
+    assetErrorIf(header.version != binaryVersion, "Unsupported binary mesh version ", header.version, " in file ", path);
+
+    auto data = sptr<MeshData>(new MeshData());
+
+    VertexBufferLayout fileLayout;
+    for (u32 i = 0; i < header.attributeCount && reader.isOk(); i++) {
+        const auto usage = static_cast<VertexAttributeUsage>(reader.read<u32>());
+        const auto format = static_cast<VertexAttributeFormat>(reader.read<u32>());
+        if (reader.isOk())
+            fileLayout.addAttribute(usage, format);
+    }
+    for (u32 i = 0; i < header.partCount && reader.isOk(); i++)
+        data->parts_.push_back(reader.read<Part>());
+
+    const auto vertexDataSize = static_cast<u64>(header.vertexCount) * fileLayout.size();
+    const auto indexDataSize = static_cast<u64>(header.indexCount) * sizeof(u32);
+    const auto valid = reader.isOk() &&
+        header.vertexDataOffset % binaryDataAlignment == 0 &&
+        header.indexDataOffset % binaryDataAlignment == 0 &&
+        header.vertexDataOffset >= reader.position() &&
+        header.vertexDataOffset + vertexDataSize <= file->size() &&
+        header.indexDataOffset + indexDataSize <= file->size() &&
+        std::all_of(data->parts_.begin(), data->parts_.end(), [&header](const Part &part) {
+            return static_cast<u64>(part.indexOffset) + part.indexCount <= header.indexCount && part.baseVertex <= header.vertexCount;
+        });
+    assetErrorIf(!valid, "Binary mesh file ", path, " is corrupted");
+
+    // Indices past the vertices would make the GPU (and colliders) read out of bounds, one pass over them is cheap
+    const auto indices = reinterpret_cast<const u32 *>(file->data() + header.indexDataOffset);
+    for (const auto &part : data->parts_) {
+        const auto vertexCount = header.vertexCount - part.baseVertex;
+        const auto begin = indices + part.indexOffset;
+        const auto inRange = std::all_of(begin, begin + part.indexCount, [vertexCount](u32 index) { return index < vertexCount; });
+        assetErrorIf(!inRange, "Binary mesh file ", path, " has indices out of range");
+    }
+
+    // Slow path for files cooked with a different layout, attributes missing from the file are zeroed
+    const auto vertices = file->data() + header.vertexDataOffset;
+    data->layout_ = bufferLayout;
+    if (fileLayout.sameAs(bufferLayout))
+        data->vertices_ = vertices;
+    else {
+        data->ownedVertices_.resize(static_cast<size_t>(header.vertexCount) * bufferLayout.size());
+        VertexBufferLayout::convert(fileLayout, vertices, bufferLayout, data->ownedVertices_.data(), header.vertexCount);
+        data->vertices_ = data->ownedVertices_.data();
+    }
+
+    data->vertexCount_ = header.vertexCount;
+    data->indexCount_ = header.indexCount;
+    data->indices_ = indices;
+    data->boundsMin_ = Vector3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    data->boundsMax_ = Vector3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    data->file_ = file;
+
+    return data;
+}
+
+void MeshData::saveBinary(FileSystem *fs, const str &path) const {
+    BinaryHeader header{};
+    header.magic = binaryMagic;
+    header.version = binaryVersion;
+    header.attributeCount = layout_.attributeCount();
+    header.partCount = partCount();
+    header.vertexCount = vertexCount_;
+    header.indexCount = indexCount_;
+    header.boundsMin[0] = boundsMin_.x();
+    header.boundsMin[1] = boundsMin_.y();
+    header.boundsMin[2] = boundsMin_.z();
+    header.boundsMax[0] = boundsMax_.x();
+    header.boundsMax[1] = boundsMax_.y();
+    header.boundsMax[2] = boundsMax_.z();
+
+    const auto tablesSize = sizeof(BinaryHeader) + header.attributeCount * 2 * sizeof(u32) + header.partCount * sizeof(Part);
+    const auto vertexDataSize = static_cast<u64>(this->vertexDataSize());
+    header.vertexDataOffset = alignUp(tablesSize, binaryDataAlignment);
+    header.indexDataOffset = alignUp(header.vertexDataOffset + vertexDataSize, binaryDataAlignment);
+
+    BinaryWriter writer;
+    writer.write(header);
+    for (u32 i = 0; i < header.attributeCount; i++) {
+        writer.write(static_cast<u32>(layout_.attribute(i).usage));
+        writer.write(static_cast<u32>(layout_.attribute(i).format));
+    }
+    for (const auto &part : parts_)
+        writer.write(part);
+
+    const auto pad = [&writer](u64 offset) {
+        const u8 zero = 0;
+        while (writer.data().size() < offset)
+            writer.write(zero);
+    };
+
+    pad(header.vertexDataOffset);
+    writer.write(vertices_, vertexDataSize);
+    pad(header.indexDataOffset);
+    writer.write(indices_, static_cast<size_t>(indexCount_) * sizeof(u32));
+
+    fs->writeBytes(path, writer.data());
+}
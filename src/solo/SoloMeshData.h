@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloVertexBufferLayout.h"
+#include "math/SoloVector3.h"
+
+namespace solo {
+    class FileSystem;
+    class MappedFile;
+    class JobPool;
+
+    // CPU side of a mesh, built without touching the GPU so that it can be loaded on a worker thread.
+    // Comes either from assimp or from the engine's binary mesh format. Binary files are memory-mapped
+    // and their vertex and index data is used in place when the file layout matches the requested one.
+    // Vertices are stored in the formats of the layout, so compact layouts are packed here once.
+    // Imported parts are optimized: duplicate vertices welded, triangles reordered for the post-transform cache
+    // and overdraw, vertices renumbered in first use order.
+    class MeshData final {
+    public:
+        // Indices of a part are relative to its first vertex, so that they fit in 16 bits more often
+        struct Part {
+            u32 indexOffset;
+            u32 indexCount;
+            u32 baseVertex;
+        };
+
+        // How import-time optimization went for a part. ACMR is the average cache miss ratio, see meshopt.
+        struct PartStats {
+            u32 importedVertexCount;
+            u32 vertexCount;
+            float importedAcmr;
+            float acmr;
+        };
+
+        // With a job pool, parts of multi-part source files are built in parallel
+        static auto fromFile(FileSystem *fs, const str &path, const VertexBufferLayout &bufferLayout,
+            JobPool *jobPool = nullptr) -> sptr<MeshData>;
+        // Same with the contents of the file read already (e.g. by FileSystem::readBytesAsync), side files are still read through `fs`
+        static auto fromMemory(FileSystem *fs, const str &path, sptr<MappedFile> contents, const VertexBufferLayout &bufferLayout,
+            JobPool *jobPool = nullptr) -> sptr<MeshData>;
+
+        static bool isBinaryFile(const str &path);
+
+        MeshData(const MeshData &other) = delete;
+        MeshData(MeshData &&other) = delete;
+        ~MeshData() = default;
+
+        auto operator=(const MeshData &other) -> MeshData & = delete;
+        auto operator=(MeshData &&other) -> MeshData & = delete;
+
+        void saveBinary(FileSystem *fs, const str &path) const;
+
+        auto layout() const -> const VertexBufferLayout & { return layout_; }
+
+        auto vertexCount() const -> u32 { return vertexCount_; }
+        auto vertexData() const -> const u8 * { return vertices_; }
+        auto vertexDataSize() const -> size_t { return static_cast<size_t>(vertexCount_) * layout_.size(); }
+
+        auto indexCount() const -> u32 { return indexCount_; }
+        auto indexData() const -> const u32 * { return indices_; }
+
+        auto partCount() const -> u32 { return static_cast<u32>(parts_.size()); }
+        auto part(u32 index) const -> Part { return parts_.at(index); }
+        auto partIndexData(u32 index) const -> const u32 * { return indices_ + parts_.at(index).indexOffset; }
+        // Empty for data loaded from the binary format, it has been optimized when it was cooked
+        auto partStats() const -> const vec<PartStats> & { return partStats_; }
+
+        auto boundsMin() const -> Vector3 { return boundsMin_; }
+        auto boundsMax() const -> Vector3 { return boundsMax_; }
+
+    private:
+        VertexBufferLayout layout_;
+        vec<Part> parts_;
+        vec<PartStats> partStats_;
+        Vector3 boundsMin_;
+        Vector3 boundsMax_;
+
+        // Point either into the owned vectors or into the mapped file
+        const u8 *vertices_ = nullptr;
+        const u32 *indices_ = nullptr;
+        u32 vertexCount_ = 0;
+        u32 indexCount_ = 0;
+
+        vec<u8> ownedVertices_;
+        vec<u32> ownedIndices_;
+        sptr<MappedFile> file_;
+
+        MeshData() = default;
+
+        static auto fromAssimp(FileSystem *fs, const str &path, sptr<MappedFile> contents, const VertexBufferLayout &bufferLayout,
+            JobPool *jobPool) -> sptr<MeshData>;
+        static auto fromBinary(sptr<MappedFile> file, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>;
+    };
+}
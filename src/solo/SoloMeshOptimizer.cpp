@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloMeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace solo;
+
+namespace {
+    const u32 invalidIndex = ~0u;
+
+    // FIFO cache as in the hardware: hits don't refresh an entry's position
+    class CacheSimulator {
+    public:
+        CacheSimulator(u32 vertexCount, u32 cacheSize): timestamps_(vertexCount, 0), cacheSize_(cacheSize) {
+        }
+
+        void reset() {
+            time_ += cacheSize_ + 1;
+        }
+
+        // Returns true on a miss
+        bool access(u32 vertex) {
+            if (timestamps_[vertex] && time_ - timestamps_[vertex] < cacheSize_)
+                return false;
+            timestamps_[vertex] = ++time_;
+            return true;
+        }
+
+        auto triangleMisses(const u32 *triangle) -> u32 {
+            return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+        }
+
+    private:
+        vec<u32> timestamps_;
+        u32 cacheSize_;
+        u32 time_ = 0;
+    };
+
+    // Forsyth's scoring, tuned for a 32 entry LRU cache
+    const u32 forsythCacheSize = 32;
+    const u32 forsythMaxValence = 32;
+
+    struct ForsythScores {
+        float cache[forsythCacheSize];
+        float valence[forsythMaxValence];
+
+        ForsythScores() {
+            for (u32 i = 0; i < forsythCacheSize; i++) {
+                // The three most recent vertices get a fixed score so that a strip isn't favoured over a fan
+                cache[i] = i < 3 ? 0.75f : std::pow(1 - static_cast<float>(i - 3) / (forsythCacheSize - 3), 1.5f);
+            }
+            // Vertices with few triangles left get a boost to get rid of them early
+            for (u32 i = 0; i < forsythMaxValence; i++)
+                valence[i] = i ? 2.0f / std::sqrt(static_cast<float>(i)) : 0;
+        }
+
+        auto vertexScore(s32 cachePosition, u32 remaining) const -> float {
+            if (!remaining)
+                return -1;
+            const auto valenceScore = remaining < forsythMaxValence ? valence[remaining] : 2.0f / std::sqrt(static_cast<float>(remaining));
+            return (cachePosition >= 0 ? cache[cachePosition] : 0) + valenceScore;
+        }
+    };
+
+    auto hashVertex(const float *vertex, u32 stride) -> u32 {
+        u32 hash = 2166136261u;
+        for (u32 i = 0; i < stride; i++) {
+            u32 word;
+            std::memcpy(&word, vertex + i, sizeof(word));
+            hash = (hash ^ word) * 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    auto nextPowerOfTwo(u32 value) -> u32 {
+        u32 result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+}
+
+auto meshopt::averageCacheMissRatio(const u32 *indices, u32 indexCount, u32 vertexCount, u32 cacheSize) -> float {
+    const auto triangleCount = indexCount / 3;
+    if (!triangleCount)
+        return 0;
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    u32 misses = 0;
+    for (u32 i = 0; i < triangleCount * 3; i += 3)
+        misses += cache.triangleMisses(indices + i);
+    return static_cast<float>(misses) / triangleCount;
+}
+
+auto meshopt::weldVertices(float *vertices, u32 vertexCount, u32 stride, u32 *indices, u32 indexCount) -> u32 {
+    const auto tableSize = nextPowerOfTwo((std::max)(vertexCount * 2, 16u));
+    const auto mask = tableSize - 1;
+    const auto vertexSize = stride * sizeof(float);
+    vec<u32> table(tableSize, invalidIndex);
+    vec<u32> remap(vertexCount);
+
+    // Unique vertices are compacted in place, a vertex never moves past one that hasn't been looked at yet
+    u32 uniqueCount = 0;
+    for (u32 v = 0; v < vertexCount; v++) {
+        const auto vertex = vertices + static_cast<size_t>(v) * stride;
+        auto slot = hashVertex(vertex, stride) & mask;
+        while (table[slot] != invalidIndex && std::memcmp(vertices + static_cast<size_t>(table[slot]) * stride, vertex, vertexSize))
+            slot = (slot + 1) & mask;
+
+        if (table[slot] == invalidIndex) {
+            if (uniqueCount != v)
+                std::memcpy(vertices + static_cast<size_t>(uniqueCount) * stride, vertex, vertexSize);
+            table[slot] = uniqueCount++;
+        }
+        remap[v] = table[slot];
+    }
+
+    for (u32 i = 0; i < indexCount; i++)
+        indices[i] = remap[indices[i]];
+
+    return uniqueCount;
+}
+
+void meshopt::optimizeVertexCache(u32 *indices, u32 indexCount, u32 vertexCount) {
+    static const ForsythScores scores;
+    const auto triangleCount = indexCount / 3;
+    if (!triangleCount)
+        return;
+
+    // Triangles using each vertex. The first `remaining[v]` entries of a vertex's range are the ones not emitted yet.
+    vec<u32> adjacencyOffsets(vertexCount + 1, 0);
+    for (u32 i = 0; i < triangleCount * 3; i++)
+        adjacencyOffsets[indices[i] + 1]++;
+    for (u32 v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+    vec<u32> remaining(vertexCount, 0);
+    vec<u32> adjacency(triangleCount * 3);
+    for (u32 i = 0; i < triangleCount * 3; i++) {
+        const auto v = indices[i];
+        adjacency[adjacencyOffsets[v] + remaining[v]++] = i / 3;
+    }
+
+    vec<s32> cachePositions(vertexCount, -1);
+    vec<float> vertexScores(vertexCount);
+    for (u32 v = 0; v < vertexCount; v++)
+        vertexScores[v] = scores.vertexScore(-1, remaining[v]);
+
+    const auto triangleScore = [&](u32 triangle) {
+        const auto corners = indices + triangle * 3;
+        return vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    };
+
+    vec<u32> result;
+    result.reserve(triangleCount * 3);
+    vec<u8> emitted(triangleCount, 0);
+    u32 cache[forsythCacheSize + 3], newCache[forsythCacheSize + 3];
+    u32 cacheCount = 0;
+    u32 deadEndCursor = 0;
+    s64 best = 0;
+
+    for (u32 emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        // Nothing in the cache to continue with, start over from the next triangle in input order
+        if (best < 0) {
+            while (emitted[deadEndCursor])
+                deadEndCursor++;
+            best = deadEndCursor;
+        }
+
+        const auto triangle = static_cast<u32>(best);
+        const auto corners = indices + triangle * 3;
+        result.insert(result.end(), corners, corners + 3);
+        emitted[triangle] = 1;
+
+        for (u32 k = 0; k < 3; k++) {
+            const auto v = corners[k];
+            const auto begin = adjacency.begin() + adjacencyOffsets[v];
+            const auto end = begin + remaining[v];
+            const auto it = std::find(begin, end, triangle);
+            if (it != end) {
+                std::iter_swap(it, end - 1);
+                remaining[v]--;
+            }
+        }
+
+        // The emitted triangle's vertices go to the front, the rest move back and may fall out
+        u32 newCacheCount = 0;
+        for (u32 k = 0; k < 3; k++) {
+            if (std::find(newCache, newCache + newCacheCount, corners[k]) == newCache + newCacheCount)
+                newCache[newCacheCount++] = corners[k];
+        }
+        for (u32 i = 0; i < cacheCount; i++) {
+            if (std::find(newCache, newCache + newCacheCount, cache[i]) == newCache + newCacheCount)
+                newCache[newCacheCount++] = cache[i];
+        }
+
+        for (u32 i = 0; i < newCacheCount; i++) {
+            const auto v = newCache[i];
+            cachePositions[v] = i < forsythCacheSize ? static_cast<s32>(i) : -1;
+            vertexScores[v] = scores.vertexScore(cachePositions[v], remaining[v]);
+        }
+
+        cacheCount = (std::min)(newCacheCount, forsythCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        best = -1;
+        auto bestScore = 0.0f;
+        for (u32 i = 0; i < cacheCount; i++) {
+            const auto v = cache[i];
+            for (u32 j = 0; j < remaining[v]; j++) {
+                const auto candidate = adjacency[adjacencyOffsets[v] + j];
+                const auto score = triangleScore(candidate);
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = candidate;
+                }
+            }
+        }
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void meshopt::optimizeOverdraw(u32 *indices, u32 indexCount, const float *positions, u32 stride, u32 vertexCount, float threshold) {
+    const auto triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Hard boundaries: triangles that miss on all three vertices start with a cold cache anyway,
+    // so moving what follows them elsewhere costs nothing
+    vec<u32> hardClusters;
+    CacheSimulator cache(vertexCount, measuredCacheSize);
+    for (u32 t = 0; t < triangleCount; t++) {
+        if (cache.triangleMisses(indices + t * 3) == 3)
+            hardClusters.push_back(t);
+    }
+    if (hardClusters.empty() || hardClusters[0] != 0)
+        hardClusters.insert(hardClusters.begin(), 0);
+    hardClusters.push_back(triangleCount);
+
+    // Soft boundaries: split hard clusters further wherever the part so far is nearly as cache friendly as the whole
+    vec<u32> clusters;
+    for (size_t c = 0; c + 1 < hardClusters.size(); c++) {
+        const auto begin = hardClusters[c];
+        const auto end = hardClusters[c + 1];
+
+        cache.reset();
+        u32 misses = 0;
+        for (auto t = begin; t < end; t++)
+            misses += cache.triangleMisses(indices + t * 3);
+        const auto targetAcmr = static_cast<float>(misses) / (end - begin) * threshold;
+
+        clusters.push_back(begin);
+        cache.reset();
+        misses = 0;
+        auto clusterBegin = begin;
+        for (auto t = begin; t < end; t++) {
+            misses += cache.triangleMisses(indices + t * 3);
+            if (t + 1 < end && static_cast<float>(misses) / (t + 1 - clusterBegin) <= targetAcmr) {
+                clusters.push_back(t + 1);
+                clusterBegin = t + 1;
+                cache.reset();
+                misses = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    struct Cluster {
+        u32 begin;
+        u32 end;
+        float centroid[3];
+        float normal[3];
+        float area;
+        float sortKey;
+    };
+
+    vec<Cluster> clusterInfos;
+    float meshCentroid[3] = {0, 0, 0};
+    auto meshArea = 0.0f;
+    for (size_t i = 0; i + 1 < clusters.size(); i++) {
+        Cluster cluster{clusters[i], clusters[i + 1], {0, 0, 0}, {0, 0, 0}, 0, 0};
+        for (auto t = cluster.begin; t < cluster.end; t++) {
+            const auto a = positions + static_cast<size_t>(indices[t * 3]) * stride;
+            const auto b = positions + static_cast<size_t>(indices[t * 3 + 1]) * stride;
+            const auto c = positions + static_cast<size_t>(indices[t * 3 + 2]) * stride;
+            const float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            const float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            const float n[3] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+            const auto area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (u32 k = 0; k < 3; k++) {
+                cluster.centroid[k] += (a[k] + b[k] + c[k]) / 3 * area;
+                cluster.normal[k] += n[k];
+            }
+            cluster.area += area;
+        }
+
+        for (u32 k = 0; k < 3; k++)
+            meshCentroid[k] += cluster.centroid[k];
+        meshArea += cluster.area;
+        if (cluster.area > 0) {
+            for (u32 k = 0; k < 3; k++)
+                cluster.centroid[k] /= cluster.area;
+        }
+        clusterInfos.push_back(cluster);
+    }
+    if (meshArea > 0) {
+        for (u32 k = 0; k < 3; k++)
+            meshCentroid[k] /= meshArea;
+    }
+
+    // Clusters facing away from the center are likely to be in front of the ones facing towards it
+    for (auto &cluster : clusterInfos) {
+        const auto &n = cluster.normal;
+        const auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        cluster.sortKey = 0;
+        if (length > 0) {
+            for (u32 k = 0; k < 3; k++)
+                cluster.sortKey += (cluster.centroid[k] - meshCentroid[k]) * n[k] / length;
+        }
+    }
+    std::stable_sort(clusterInfos.begin(), clusterInfos.end(), [](const Cluster &a, const Cluster &b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    vec<u32> result;
+    result.reserve(triangleCount * 3);
+    for (const auto &cluster : clusterInfos)
+        result.insert(result.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+    std::copy(result.begin(), result.end(), indices);
+}
+
+auto meshopt::optimizeVertexFetch(float *vertices, u32 vertexCount, u32 stride, u32 *indices, u32 indexCount) -> u32 {
+    vec<u32> remap(vertexCount, invalidIndex);
+    u32 nextVertex = 0;
+    for (u32 i = 0; i < indexCount; i++) {
+        auto &index = remap[indices[i]];
+        if (index == invalidIndex)
+            index = nextVertex++;
+        indices[i] = index;
+    }
+
+    const vec<float> source(vertices, vertices + static_cast<size_t>(vertexCount) * stride);
+    for (u32 v = 0; v < vertexCount; v++) {
+        if (remap[v] != invalidIndex)
+            std::copy_n(source.data() + static_cast<size_t>(v) * stride, stride, vertices + static_cast<size_t>(remap[v]) * stride);
+    }
+
+    return nextVertex;
+}
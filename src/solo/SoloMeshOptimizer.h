@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo {
+    // Import-time processing of indexed triangle lists. Vertices are interleaved floats, `stride` of them per vertex.
+    namespace meshopt {
+        // Size of the FIFO cache used to measure ACMR, roughly what current GPUs behave like
+        constexpr u32 measuredCacheSize = 16;
+
+        // Average cache miss ratio: transformed vertices per triangle, from 0.5 (ideal) to 3
+        auto averageCacheMissRatio(const u32 *indices, u32 indexCount, u32 vertexCount, u32 cacheSize = measuredCacheSize) -> float;
+
+        // Merges bitwise equal vertices and remaps the indices, returns the new vertex count
+        auto weldVertices(float *vertices, u32 vertexCount, u32 stride, u32 *indices, u32 indexCount) -> u32;
+
+        // Reorders triangles for post-transform cache hits (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+        void optimizeVertexCache(u32 *indices, u32 indexCount, u32 vertexCount);
+
+        // Reorders clusters of an already cache-optimized triangle list so that outward-facing ones come first
+        // and occlude the rest (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+        // A cluster ends where the cache would be cold anyway or its ACMR stays within `threshold` of the original.
+        void optimizeOverdraw(u32 *indices, u32 indexCount, const float *positions, u32 stride, u32 vertexCount, float threshold = 1.05f);
+
+        // Renumbers vertices in the order the indices first reference them, dropping unreferenced ones.
+        // Returns the new vertex count.
+        auto optimizeVertexFetch(float *vertices, u32 vertexCount, u32 stride, u32 *indices, u32 indexCount) -> u32;
+    }
+}
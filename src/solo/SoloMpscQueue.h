@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <atomic>
+
+namespace solo {
+    // Multi-producer single-consumer queue (Vyukov's node-based design). Pushing is wait-free,
+    // popping must happen on one thread only. A push that is still linking its node may be
+    // missed by a concurrent pop and will be seen by the next one.
+    template <class T>
+    class MpscQueue final {
+    public:
+        MpscQueue() {
+            const auto stub = new Node();
+            head_.store(stub, std::memory_order_relaxed);
+            tail_ = stub;
+        }
+
+        MpscQueue(const MpscQueue &other) = delete;
+        MpscQueue(MpscQueue &&other) = delete;
+
+        ~MpscQueue() {
+            T value;
+            while (pop(value)) {}
+            delete tail_;
+        }
+
+        auto operator=(const MpscQueue &other) -> MpscQueue & = delete;
+        auto operator=(MpscQueue &&other) -> MpscQueue & = delete;
+
+        // Any thread
+        void push(T value) {
+            const auto node = new Node();
+            node->value = std::move(value);
+            const auto prev = head_.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        // Consumer thread only
+        bool pop(T &value) {
+            const auto next = tail_->next.load(std::memory_order_acquire);
+            if (!next)
+                return false;
+
+            // `next` becomes the new stub, its value is no longer needed there
+            value = std::move(next->value);
+            next->value = T();
+            delete tail_;
+            tail_ = next;
+            return true;
+        }
+
+    private:
+        struct Node {
+            std::atomic<Node*> next{nullptr};
+            T value;
+        };
+
+        std::atomic<Node*> head_{nullptr};
+        Node *tail_ = nullptr;
+    };
+}
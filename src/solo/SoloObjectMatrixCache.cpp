@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloObjectMatrixCache.h"
+#include "SoloTransform.h"
+#include "SoloCamera.h"
+#include "SoloHash.h"
+
+using namespace solo;
+
+static constexpr u32 VALID_BIT_WORLD_VIEW = 1;
+static constexpr u32 VALID_BIT_WORLD_VIEW_PROJ = 1 << 1;
+static constexpr u32 VALID_BIT_INV_TRANSPOSED_WORLD_VIEW = 1 << 2;
+
+auto ObjectMatrixCache::KeyHasher::operator()(const Key &key) const -> size_t {
+    size_t seed = 0;
+    const std::hash<const void *> hasher;
+    combineHash(seed, hasher(key.transform));
+    combineHash(seed, hasher(key.camera));
+    return seed;
+}
+
+void ObjectMatrixCache::clear() {
+    indices_.clear();
+    entries_.clear();
+}
+
+auto ObjectMatrixCache::entry(const Transform *transform, const Camera *camera) -> Entry & {
+    const auto it = indices_.find({transform, camera});
+    if (it == indices_.end()) {
+        indices_[{transform, camera}] = static_cast<u32>(entries_.size());
+        entries_.push_back({transform->version(), camera->version(), 0});
+        return entries_.back();
+    }
+
+    // Either side may change between camera passes of the same frame
+    auto &e = entries_[it->second];
+    if (e.transformVersion != transform->version() || e.cameraVersion != camera->version()) {
+        e.transformVersion = transform->version();
+        e.cameraVersion = camera->version();
+        e.validFlags = 0;
+    }
+    return e;
+}
+
+auto ObjectMatrixCache::worldViewMatrix(const Transform *transform, const Camera *camera) -> const Matrix & {
+    auto &e = entry(transform, camera);
+    if (!(e.validFlags & VALID_BIT_WORLD_VIEW)) {
+        e.worldView = camera->viewMatrix() * transform->worldMatrix();
+        e.validFlags |= VALID_BIT_WORLD_VIEW;
+    }
+    return e.worldView;
+}
+
+auto ObjectMatrixCache::worldViewProjMatrix(const Transform *transform, const Camera *camera) -> const Matrix & {
+    auto &e = entry(transform, camera);
+    if (!(e.validFlags & VALID_BIT_WORLD_VIEW_PROJ)) {
+        e.worldViewProj = camera->viewProjectionMatrix() * transform->worldMatrix();
+        e.validFlags |= VALID_BIT_WORLD_VIEW_PROJ;
+    }
+    return e.worldViewProj;
+}
+
+auto ObjectMatrixCache::invTransposedWorldViewMatrix(const Transform *transform, const Camera *camera) -> const Matrix & {
+    const auto &worldView = worldViewMatrix(transform, camera);
+    auto &e = entry(transform, camera);
+    if (!(e.validFlags & VALID_BIT_INV_TRANSPOSED_WORLD_VIEW)) {
+        e.invTransposedWorldView = worldView.inverted().transposed();
+        e.validFlags |= VALID_BIT_INV_TRANSPOSED_WORLD_VIEW;
+    }
+    return e.invTransposedWorldView;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "math/SoloMatrix.h"
+
+namespace solo {
+    class Transform;
+    class Camera;
+
+    // Matrices derived from an object transform and a camera. Each one is computed at most once
+    // per frame for a transform/camera pair, however many mesh parts and materials need it.
+    class ObjectMatrixCache {
+    public:
+        ObjectMatrixCache() = default;
+        ObjectMatrixCache(const ObjectMatrixCache &other) = delete;
+        ObjectMatrixCache(ObjectMatrixCache &&other) = delete;
+        ~ObjectMatrixCache() = default;
+
+        auto operator=(const ObjectMatrixCache &other) -> ObjectMatrixCache & = delete;
+        auto operator=(ObjectMatrixCache &&other) -> ObjectMatrixCache & = delete;
+
+        auto worldViewMatrix(const Transform *transform, const Camera *camera) -> const Matrix &;
+        auto worldViewProjMatrix(const Transform *transform, const Camera *camera) -> const Matrix &;
+        auto invTransposedWorldViewMatrix(const Transform *transform, const Camera *camera) -> const Matrix &;
+
+        // Called at the start of every frame. Keeps the storage to avoid reallocating it.
+        void clear();
+
+    private:
+        struct Key {
+            const Transform *transform;
+            const Camera *camera;
+
+            bool operator==(const Key &other) const {
+                return transform == other.transform && camera == other.camera;
+            }
+        };
+
+        struct KeyHasher {
+            auto operator()(const Key &key) const -> size_t;
+        };
+
+        struct Entry {
+            u32 transformVersion;
+            u32 cameraVersion;
+            u32 validFlags;
+            Matrix worldView;
+            Matrix worldViewProj;
+            Matrix invTransposedWorldView;
+        };
+
+        std::unordered_map<Key, u32, KeyHasher> indices_;
+        vec<Entry> entries_;
+
+        auto entry(const Transform *transform, const Camera *camera) -> Entry &;
+    };
+}
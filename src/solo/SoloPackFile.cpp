@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloPackFile.h"
+#include "SoloFileSystem.h"
+#include "SoloMappedFile.h"
+#include "SoloBinaryIO.h"
+#include "SoloLz4.h"
+#include <algorithm>
+
+using namespace solo;
+
+// Pack file: header, table of contents (name, offset, size, stored size and compression of every entry),
+// then entry data. Entries are sorted by name, so files of a directory end up next to each other.
+// Everything is stored in the native (little-endian) byte order.
+namespace {
+    const u32 packMagic = 0x4b504c53; // "SLPK"
+    const u32 packVersion = 1;
+    const u64 packDataAlignment = 16;
+
+    const u32 compressionNone = 0;
+    const u32 compressionLz4 = 1;
+
+    struct PackHeader {
+        u32 magic;
+        u32 version;
+        u32 entryCount;
+        u32 reserved;
+    };
+
+    auto alignUp(u64 value, u64 alignment) -> u64 {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void collectFiles(FileSystem *fs, const str &directory, vec<str> &files) {
+        for (const auto &file : fs->listFiles(directory))
+            files.push_back(file);
+        for (const auto &dir : fs->listDirectories(directory))
+            collectFiles(fs, dir, files);
+    }
+}
+
+auto PackFile::fromPath(const str &path) -> sptr<PackFile> {
+    auto result = sptr<PackFile>(new PackFile());
+    result->path_ = path;
+    result->file_ = MappedFile::fromPath(path);
+
+    BinaryReader reader(result->file_->data(), result->file_->size());
+    const auto header = reader.read<PackHeader>();
+    panicIf(!reader.isOk() || header.magic != packMagic, "File ", path, " is not a pack");
+    panicIf(header.version != packVersion, "Unsupported pack version ", header.version, " in file ", path);
+
+    for (u32 i = 0; i < header.entryCount && reader.isOk(); i++) {
+        const auto name = reader.readString();
+        Entry entry;
+        entry.offset = reader.read<u64>();
+        entry.size = reader.read<u64>();
+        entry.storedSize = reader.read<u64>();
+        entry.compression = reader.read<u32>();
+        panicIf(entry.offset > result->file_->size() || entry.storedSize > result->file_->size() - entry.offset,
+            "Entry ", name, " is out of bounds in pack ", path);
+        panicIf(entry.compression != compressionNone && entry.compression != compressionLz4,
+            "Unsupported compression of entry ", name, " in pack ", path);
+        // Uncompressed entries are mapped with their size, so it has to be what the bounds check covered
+        panicIf(entry.compression == compressionNone && entry.size != entry.storedSize,
+            "Entry ", name, " has mismatched sizes in pack ", path);
+        result->entries_[name] = entry;
+    }
+    panicIf(!reader.isOk(), "Pack ", path, " is truncated");
+
+    return result;
+}
+
+void PackFile::build(FileSystem *fs, const str &directory, const str &packPath, bool compress) {
+    vec<str> files;
+    collectFiles(fs, directory, files);
+    files.erase(std::remove(files.begin(), files.end(), packPath), files.end());
+    std::sort(files.begin(), files.end());
+
+    struct Packed {
+        str name;
+        Entry entry;
+        vec<u8> data;
+    };
+    vec<Packed> packed;
+    packed.reserve(files.size());
+
+    u64 tocSize = 0;
+    for (const auto &file : files) {
+        Packed p;
+        p.name = file.substr(directory.size() + 1);
+        p.data = fs->readBytes(file);
+        p.entry.size = p.data.size();
+        p.entry.compression = compressionNone;
+
+        if (compress && !p.data.empty()) {
+            auto compressed = lz4Compress(p.data.data(), p.data.size());
+            if (compressed.size() <= p.data.size() - p.data.size() / 8) {
+                p.data = std::move(compressed);
+                p.entry.compression = compressionLz4;
+            }
+        }
+
+        p.entry.storedSize = p.data.size();
+        tocSize += sizeof(u32) + p.name.size() + 3 * sizeof(u64) + sizeof(u32);
+        packed.push_back(std::move(p));
+    }
+
+    auto offset = alignUp(sizeof(PackHeader) + tocSize, packDataAlignment);
+    for (auto &p : packed) {
+        p.entry.offset = offset;
+        offset = alignUp(offset + p.entry.storedSize, packDataAlignment);
+    }
+
+    PackHeader header{};
+    header.magic = packMagic;
+    header.version = packVersion;
+    header.entryCount = static_cast<u32>(packed.size());
+
+    BinaryWriter writer;
+    writer.write(header);
+    for (const auto &p : packed) {
+        writer.writeString(p.name);
+        writer.write(p.entry.offset);
+        writer.write(p.entry.size);
+        writer.write(p.entry.storedSize);
+        writer.write(p.entry.compression);
+    }
+
+    const u8 zero = 0;
+    for (const auto &p : packed) {
+        while (writer.data().size() < p.entry.offset)
+            writer.write(zero);
+        writer.write(p.data.data(), p.data.size());
+    }
+
+    fs->writeBytes(packPath, writer.data());
+}
+
+auto PackFile::open(const str &name) const -> sptr<MappedFile> {
+    const auto it = entries_.find(name);
+    panicIf(it == entries_.end(), "Pack has no entry ", name);
+    const auto &entry = it->second;
+
+    if (entry.compression == compressionNone)
+        return MappedFile::fromRange(file_, entry.offset, entry.size);
+
+    vec<u8> bytes(entry.size);
+    const auto ok = lz4Decompress(file_->data() + entry.offset, entry.storedSize, bytes.data(), bytes.size());
+    panicIf(!ok, "Unable to decompress pack entry ", name);
+    return MappedFile::fromBytes(std::move(bytes));
+}
+
+bool PackFile::entryRange(const str &name, u64 &offset, u64 &size) const {
+    const auto it = entries_.find(name);
+    panicIf(it == entries_.end(), "Pack has no entry ", name);
+    if (it->second.compression != compressionNone)
+        return false;
+    offset = it->second.offset;
+    size = it->second.size;
+    return true;
+}
+
+auto PackFile::entryNames() const -> vec<str> {
+    vec<str> result;
+    result.reserve(entries_.size());
+    for (const auto &entry : entries_)
+        result.push_back(entry.first);
+    std::sort(result.begin(), result.end());
+    return result;
+}
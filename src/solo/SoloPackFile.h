@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo {
+    class FileSystem;
+    class MappedFile;
+
+    // Many files packed into one, read through a single mapping. FileSystem serves them once the pack is mounted.
+    // Entries are named by '/'-separated paths relative to the packed directory and start at 16-byte aligned offsets,
+    // so uncompressed ones are used in place like loose mapped files. Compressed (LZ4) entries are decompressed on every open.
+    class PackFile final {
+    public:
+        static auto fromPath(const str &path) -> sptr<PackFile>;
+
+        // Packs all files under `directory`. With `compress` entries are stored compressed when that saves at least an eighth of their size
+        static void build(FileSystem *fs, const str &directory, const str &packPath, bool compress);
+
+        PackFile(const PackFile &other) = delete;
+        PackFile(PackFile &&other) = delete;
+        ~PackFile() = default;
+
+        auto operator=(const PackFile &other) -> PackFile & = delete;
+        auto operator=(PackFile &&other) -> PackFile & = delete;
+
+        bool contains(const str &name) const {
+            return entries_.count(name) > 0;
+        }
+
+        auto open(const str &name) const -> sptr<MappedFile>;
+        auto entryNames() const -> vec<str>;
+
+        auto path() const -> const str & {
+            return path_;
+        }
+
+        // Where the entry is in the pack file. False for compressed entries, those can't be read in place.
+        bool entryRange(const str &name, u64 &offset, u64 &size) const;
+
+    private:
+        struct Entry {
+            u64 offset;
+            u64 size;
+            u64 storedSize;
+            u32 compression;
+        };
+
+        str path_;
+        sptr<MappedFile> file_;
+        umap<str, Entry> entries_;
+
+        PackFile() = default;
+    };
+}
@@ -28,6 +28,7 @@ auto Renderer::fromDevice(Device *device) -> sptr<Renderer> {
 }
 
 void Renderer::renderFrame(const std::function<void()> &render) {
+    matrixCache_.clear();
     beginFrame();
     render();
     endFrame();
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloObjectMatrixCache.h"
 #include <functional>
 
 namespace solo {
@@ -39,6 +40,8 @@ namespace solo {
         void renderFrame(const std::function<void()> &render);
 
     protected:
+        ObjectMatrixCache matrixCache_;
+
         Renderer() {}
 
         virtual void beginFrame() = 0;
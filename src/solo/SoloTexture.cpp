@@ -7,6 +7,10 @@
 #include "SoloDevice.h"
 #include "SoloTextureData.h"
 #include "SoloJobPool.h"
+#include "SoloCookedAssets.h"
+#include "SoloHotReload.h"
+#include "SoloFileSystem.h"
+#include "stb/SoloSTBTextureData.h"
 #include "gl/SoloOpenGLTexture.h"
 #include "vk/SoloVulkanTexture.h"
 
@@ -45,26 +49,46 @@ Texture::Texture(TextureFormat format):
     rebuild(); // yes, virtual call
 }
 
+// Cooked textures are loaded instead of the source ones when the device has them
+static auto resolvePath(Device *device, const str &path) -> str {
+    return device->cookedAssets()->resolve(path, CookedAssets::variantFor(device->mode()));
+}
+
 auto Texture2D::fromFile(Device *device, const str &path, bool generateMipmaps) -> sptr<Texture2D> {
-    const auto data = Texture2DData::fromFile(device, path);
-    return fromData(device, data, generateMipmaps);
+    const auto data = Texture2DData::fromFile(device, resolvePath(device, path));
+    const auto texture = fromData(device, data, generateMipmaps);
+    if (const auto hotReload = device->hotReload())
+        hotReload->trackTexture(texture, path, generateMipmaps);
+    return texture;
 }
 
 auto Texture2D::fromFileAsync(Device *device, const str &path, bool generateMipmaps) -> sptr<AsyncHandle<Texture2D>> {
-    auto handle = std::make_shared<AsyncHandle<Texture2D>>();
-
-    auto producers = JobBase<Texture2DData>::Producers{
-        [ = ]() {
-            return Texture2DData::fromFile(device, path);
-        }};
-    auto consumer = [handle, device, generateMipmaps](const vec<sptr<Texture2DData>> &results) {
-        const auto texture = fromData(device, results[0], generateMipmaps);
-        handle->resolve(texture);
+    const auto create = [device, path, generateMipmaps](sptr<Texture2DData> data) {
+        const auto texture = fromData(device, data, generateMipmaps);
+        if (const auto hotReload = device->hotReload())
+            hotReload->trackTexture(texture, path, generateMipmaps);
+        return texture;
     };
 
-    device->jobPool()->addJob(std::make_shared<JobBase<Texture2DData>>(producers, consumer));
+    // Cooked textures are used right from the mapped file. Source images are read asynchronously and decoded
+    // on a worker, so that decoding one overlaps with reading the next.
+    const auto resolvedPath = resolvePath(device, path);
+    if (Texture2DData::isBinaryFile(resolvedPath)) {
+        const auto load = [device, resolvedPath]() {
+            return Texture2DData::fromFile(device, resolvedPath);
+        };
+        return AsyncHandle<Texture2DData>::run(device->jobPool(), JobThread::Worker, load)->then(JobThread::Main, create);
+    }
+
+    const auto flip = device->mode() == DeviceMode::OpenGL;
+    return device->fileSystem()->readBytesAsync(resolvedPath)->then(JobThread::Worker, [resolvedPath, flip](sptr<vec<u8>> bytes) {
+        return std::static_pointer_cast<Texture2DData>(STBTexture2DData::fromBytes(bytes->data(), bytes->size(), resolvedPath, flip));
+    })->then(JobThread::Main, create);
+}
 
-    return handle;
+void Texture2D::swapContents(Texture2D &other) {
+    std::swap(format_, other.format_);
+    std::swap(dimensions_, other.dimensions_);
 }
 
 auto Texture2D::empty(Device *device, u32 width, u32 height, TextureFormat format) -> sptr<Texture2D> {
@@ -122,25 +146,20 @@ auto CubeTexture::fromFaceFilesAsync(
     const str &positiveXPath, const str &negativeXPath,
     const str &positiveYPath, const str &negativeYPath,
 const str &positiveZPath, const str &negativeZPath) -> sptr<AsyncHandle<CubeTexture>> {
-    auto handle = std::make_shared<AsyncHandle<CubeTexture>>();
-
-    auto producers = JobBase<CubeTextureData>::Producers{
-        [ = ]() {
-            // TODO run each face loading in separate jobs
-            return CubeTextureData::fromFaceFiles(
-                device,
-                positiveXPath, negativeXPath,
-                positiveYPath, negativeYPath,
-                positiveZPath, negativeZPath);
-        }};
-    auto consumer = [handle, device](const vec<sptr<CubeTextureData>> &results) {
-        const auto texture = fromData(device, results[0]);
-        handle->resolve(texture);
-    };
-
-    device->jobPool()->addJob(std::make_shared<JobBase<CubeTextureData>>(producers, consumer));
+    // Each face gets decoded as soon as it's read
+    const auto flip = device->mode() == DeviceMode::OpenGL;
+    vec<sptr<AsyncHandle<STBTexture2DData>>> faces;
+    for (const auto &path : {positiveXPath, negativeXPath, positiveYPath, negativeYPath, positiveZPath, negativeZPath}) {
+        faces.push_back(device->fileSystem()->readBytesAsync(path)->then(JobThread::Worker, [path, flip](sptr<vec<u8>> bytes) {
+            return STBTexture2DData::fromBytes(bytes->data(), bytes->size(), path, flip);
+        }));
+    }
 
-    return handle;
+    return whenAll(device->jobPool(), faces)->then(JobThread::Worker, [](sptr<vec<sptr<STBTexture2DData>>> faces) {
+        return std::static_pointer_cast<CubeTextureData>(STBCubeTextureData::fromFaces(*faces));
+    })->then(JobThread::Main, [device](sptr<CubeTextureData> data) {
+        return fromData(device, data);
+    });
 }
 
 auto CubeTexture::fromData(Device *device, sptr<CubeTextureData> data) -> sptr<CubeTexture> {
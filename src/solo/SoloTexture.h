@@ -85,6 +85,10 @@ namespace solo {
             return dimensions_;
         }
 
+        // Exchanges images with another texture of the same backend, keeping the filtering and wrapping
+        // of each. Used by hot reload (see HotReload) to update live textures in place.
+        virtual void swapContents(Texture2D &other);
+
     protected:
         Vector2 dimensions_;
 
@@ -4,7 +4,12 @@
  */
 
 #include "SoloTextureData.h"
+#include "SoloDevice.h"
+#include "SoloFileSystem.h"
+#include "SoloMappedFile.h"
+#include "SoloBinaryIO.h"
 #include "stb/SoloSTBTextureData.h"
+#include <algorithm>
 
 namespace solo {
     class InMemoryTexture2DData final: public Texture2DData {
@@ -24,10 +29,164 @@ namespace solo {
     private:
         vec<u8> data_;
     };
+
+    // Mip levels one after another, either in memory or in a mapped binary texture
+    class MipChainTexture2DData final: public Texture2DData {
+    public:
+        struct Level {
+            const u8 *data;
+            u32 size;
+        };
+
+        MipChainTexture2DData(Vector2 dimensions, TextureDataFormat format, bool flippedVertically):
+            Texture2DData(format, dimensions) {
+            flippedVertically_ = flippedVertically;
+        }
+
+        auto size() const -> u32 final {
+            return levels_.at(0).size;
+        }
+        auto data() const -> const void* final {
+            return levels_.at(0).data;
+        }
+
+        auto mipLevelCount() const -> u32 final {
+            return static_cast<u32>(levels_.size());
+        }
+        auto mipLevelSize(u32 level) const -> u32 final {
+            return levels_.at(level).size;
+        }
+        auto mipLevelData(u32 level) const -> const void * final {
+            return levels_.at(level).data;
+        }
+
+        // Levels point into the storage or into the file, whichever is set
+        void setLevels(vec<Level> levels, vec<u8> storage, sptr<MappedFile> file) {
+            levels_ = std::move(levels);
+            storage_ = std::move(storage);
+            file_ = std::move(file);
+        }
+
+    private:
+        vec<Level> levels_;
+        vec<u8> storage_;
+        sptr<MappedFile> file_;
+    };
 }
 
 using namespace solo;
 
+// Binary texture file: header, a table of (offset, size) per mip level, then the levels,
+// each starting at a 16-byte aligned offset
+namespace {
+    const auto binaryExtension = str(".sltex");
+    const u32 binaryMagic = 0x58545353; // "SSTX"
+    const u32 binaryVersion = 1;
+    const u32 binaryDataAlignment = 16;
+
+    struct BinaryHeader {
+        u32 magic;
+        u32 version;
+        u32 format;
+        u32 width;
+        u32 height;
+        u32 levelCount;
+        u32 flippedVertically;
+        u32 reserved;
+    };
+
+    struct BinaryLevel {
+        u64 offset;
+        u64 size;
+    };
+}
+
+static auto bytesPerPixel(TextureDataFormat format) -> u32 {
+    switch (format) {
+        case TextureDataFormat::Red:
+            return 1;
+        case TextureDataFormat::RGB:
+            return 3;
+        case TextureDataFormat::RGBA:
+            return 4;
+        default:
+            panic("Unsupported texture data format");
+            return 0;
+    }
+}
+
+static void flipRows(const u8 *src, u8 *dst, u32 width, u32 height, u32 pixelSize) {
+    const auto rowSize = static_cast<size_t>(width) * pixelSize;
+    for (u32 row = 0; row < height; row++)
+        std::copy_n(src + row * rowSize, rowSize, dst + (height - 1 - row) * rowSize);
+}
+
+// Averages 2x2 blocks, odd dimensions reuse the last row/column
+static void downsample(const u8 *src, u32 srcWidth, u32 srcHeight, u8 *dst, u32 dstWidth, u32 dstHeight, u32 pixelSize) {
+    for (u32 y = 0; y < dstHeight; y++) {
+        const auto y0 = (std::min)(y * 2, srcHeight - 1);
+        const auto y1 = (std::min)(y * 2 + 1, srcHeight - 1);
+        for (u32 x = 0; x < dstWidth; x++) {
+            const auto x0 = (std::min)(x * 2, srcWidth - 1);
+            const auto x1 = (std::min)(x * 2 + 1, srcWidth - 1);
+            for (u32 c = 0; c < pixelSize; c++) {
+                const u32 sum =
+                    src[(y0 * srcWidth + x0) * pixelSize + c] +
+                    src[(y0 * srcWidth + x1) * pixelSize + c] +
+                    src[(y1 * srcWidth + x0) * pixelSize + c] +
+                    src[(y1 * srcWidth + x1) * pixelSize + c];
+                dst[(y * dstWidth + x) * pixelSize + c] = static_cast<u8>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+static auto fromBinaryFile(FileSystem *fs, const str &path, bool flipVertically) -> sptr<Texture2DData> {
+    auto file = fs->map(path);
+    BinaryReader reader(file->data(), file->size());
+
+    const auto header = reader.read<BinaryHeader>();
+    assetErrorIf(!reader.isOk() || header.magic != binaryMagic, "File ", path, " is not a binary texture");
+    assetErrorIf(header.version != binaryVersion, "Unsupported binary texture version ", header.version, " in file ", path);
+    assetErrorIf(header.format > static_cast<u32>(TextureDataFormat::RGBA) || !header.levelCount || header.levelCount > 32,
+        "Binary texture file ", path, " is corrupted");
+
+    const auto format = static_cast<TextureDataFormat>(header.format);
+    const auto pixelSize = bytesPerPixel(format);
+    const auto flip = flipVertically != (header.flippedVertically != 0);
+
+    vec<BinaryLevel> fileLevels;
+    u64 flippedSize = 0;
+    for (u32 i = 0; i < header.levelCount; i++) {
+        const auto level = reader.read<BinaryLevel>();
+        const auto expectedSize = static_cast<u64>((std::max)(header.width >> i, 1u)) * (std::max)(header.height >> i, 1u) * pixelSize;
+        assetErrorIf(!reader.isOk() || level.size != expectedSize || level.offset + level.size > file->size(),
+            "Binary texture file ", path, " is corrupted");
+        fileLevels.push_back(level);
+        flippedSize += level.size;
+    }
+
+    // Data cooked for the other orientation gets flipped into memory, otherwise it's used right from the file
+    vec<u8> storage(flip ? flippedSize : 0);
+    vec<MipChainTexture2DData::Level> levels;
+    u64 storageOffset = 0;
+    for (u32 i = 0; i < header.levelCount; i++) {
+        const auto src = file->data() + fileLevels[i].offset;
+        const auto size = static_cast<u32>(fileLevels[i].size);
+        if (flip) {
+            const auto dst = storage.data() + storageOffset;
+            flipRows(src, dst, (std::max)(header.width >> i, 1u), (std::max)(header.height >> i, 1u), pixelSize);
+            levels.push_back({dst, size});
+            storageOffset += size;
+        } else
+            levels.push_back({src, size});
+    }
+
+    const auto result = std::make_shared<MipChainTexture2DData>(Vector2(header.width, header.height), format, flipVertically);
+    result->setLevels(std::move(levels), std::move(storage), flip ? nullptr : file);
+    return result;
+}
+
 static auto toTextureFormat(TextureDataFormat format) -> TextureFormat {
     switch (format) {
         case TextureDataFormat::Red:
@@ -43,14 +202,103 @@ static auto toTextureFormat(TextureDataFormat format) -> TextureFormat {
 }
 
 auto Texture2DData::fromFile(Device *device, const str &path) -> sptr<Texture2DData> {
+    return fromFile(device->fileSystem(), path, device->mode() == DeviceMode::OpenGL);
+}
+
+auto Texture2DData::fromFile(FileSystem *fs, const str &path, bool flipVertically) -> sptr<Texture2DData> {
+    if (isBinaryFile(path))
+        return fromBinaryFile(fs, path, flipVertically);
     panicIf(!STBTexture2DData::canLoadFromFile(path), "Unsupported cube texture file ", path);
-    return STBTexture2DData::fromFile(device, path);
+    return STBTexture2DData::fromFile(fs, path, flipVertically);
+}
+
+bool Texture2DData::isBinaryFile(const str &path) {
+    return path.size() >= binaryExtension.size() &&
+        path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0;
 }
 
 auto Texture2DData::fromMemory(u32 width, u32 height, TextureDataFormat format, const vec<u8> &data) -> sptr<Texture2DData> {
     return std::make_shared<InMemoryTexture2DData>(Vector2(width, height), format, data);
 }
 
+auto Texture2DData::withMipChain(sptr<Texture2DData> data) -> sptr<Texture2DData> {
+    if (data->mipLevelCount() > 1)
+        return data;
+
+    const auto width = static_cast<u32>(data->dimensions().x());
+    const auto height = static_cast<u32>(data->dimensions().y());
+    const auto pixelSize = bytesPerPixel(data->format());
+
+    vec<u32> levelSizes;
+    size_t totalSize = 0;
+    for (u32 w = width, h = height;; w = (std::max)(w / 2, 1u), h = (std::max)(h / 2, 1u)) {
+        levelSizes.push_back(w * h * pixelSize);
+        totalSize += levelSizes.back();
+        if (w == 1 && h == 1)
+            break;
+    }
+
+    vec<u8> storage(totalSize);
+    vec<MipChainTexture2DData::Level> levels;
+    std::copy_n(static_cast<const u8 *>(data->data()), levelSizes[0], storage.data());
+    levels.push_back({storage.data(), levelSizes[0]});
+
+    size_t offset = levelSizes[0];
+    for (u32 i = 1; i < levelSizes.size(); i++) {
+        const auto dst = storage.data() + offset;
+        const auto prev = levels.back().data;
+        downsample(prev, (std::max)(width >> (i - 1), 1u), (std::max)(height >> (i - 1), 1u),
+            dst, (std::max)(width >> i, 1u), (std::max)(height >> i, 1u), pixelSize);
+        levels.push_back({dst, levelSizes[i]});
+        offset += levelSizes[i];
+    }
+
+    const auto result = std::make_shared<MipChainTexture2DData>(data->dimensions(), data->format(), data->isFlippedVertically());
+    result->setLevels(std::move(levels), std::move(storage), nullptr);
+    return result;
+}
+
+auto Texture2DData::mipLevelDimensions(u32 level) const -> Vector2 {
+    const auto width = static_cast<u32>(dimensions_.x());
+    const auto height = static_cast<u32>(dimensions_.y());
+    return Vector2((std::max)(width >> level, 1u), (std::max)(height >> level, 1u));
+}
+
+void Texture2DData::saveBinary(FileSystem *fs, const str &path) const {
+    BinaryHeader header{};
+    header.magic = binaryMagic;
+    header.version = binaryVersion;
+    header.format = static_cast<u32>(format_);
+    header.width = static_cast<u32>(dimensions_.x());
+    header.height = static_cast<u32>(dimensions_.y());
+    header.levelCount = mipLevelCount();
+    header.flippedVertically = flippedVertically_ ? 1 : 0;
+
+    const auto align = [](u64 value) {
+        return (value + binaryDataAlignment - 1) / binaryDataAlignment * binaryDataAlignment;
+    };
+
+    vec<BinaryLevel> levels;
+    auto offset = align(sizeof(BinaryHeader) + header.levelCount * sizeof(BinaryLevel));
+    for (u32 i = 0; i < header.levelCount; i++) {
+        levels.push_back({offset, mipLevelSize(i)});
+        offset = align(offset + mipLevelSize(i));
+    }
+
+    BinaryWriter writer;
+    writer.write(header);
+    for (const auto &level : levels)
+        writer.write(level);
+    for (u32 i = 0; i < header.levelCount; i++) {
+        const u8 zero = 0;
+        while (writer.data().size() < levels[i].offset)
+            writer.write(zero);
+        writer.write(mipLevelData(i), mipLevelSize(i));
+    }
+
+    fs->writeBytes(path, writer.data());
+}
+
 auto Texture2DData::textureFormat() const -> TextureFormat {
     return toTextureFormat(format_);
 }
@@ -11,11 +11,19 @@
 
 namespace solo {
     class Device;
+    class FileSystem;
 
     class Texture2DData {
     public:
         static auto fromFile(Device *device, const str &path) -> sptr<Texture2DData>;
+        // Flipped data starts with the bottom row, which is what OpenGL expects.
+        // Binary textures (.sltex) are memory-mapped and come with their mip levels.
+        static auto fromFile(FileSystem *fs, const str &path, bool flipVertically) -> sptr<Texture2DData>;
         static auto fromMemory(u32 width, u32 height, TextureDataFormat format, const vec<u8> &data) -> sptr<Texture2DData>;
+        // Full chain of mip levels down to 1x1, built with a box filter
+        static auto withMipChain(sptr<Texture2DData> data) -> sptr<Texture2DData>;
+
+        static bool isBinaryFile(const str &path);
 
         Texture2DData() = delete;
         Texture2DData(const Texture2DData &other) = delete;
@@ -28,10 +36,28 @@ namespace solo {
         virtual auto size() const -> u32 = 0;
         virtual auto data() const -> const void * = 0;
 
+        // Level 0 is the same as size() and data()
+        virtual auto mipLevelCount() const -> u32 {
+            return 1;
+        }
+        virtual auto mipLevelSize(u32 /*level*/) const -> u32 {
+            return size();
+        }
+        virtual auto mipLevelData(u32 /*level*/) const -> const void * {
+            return data();
+        }
+        auto mipLevelDimensions(u32 level) const -> Vector2;
+
+        void saveBinary(FileSystem *fs, const str &path) const;
+
         auto dimensions() const -> Vector2 {
             return dimensions_;
         }
 
+        bool isFlippedVertically() const {
+            return flippedVertically_;
+        }
+
         /// Returns "best suited" texture format for this data
         auto textureFormat() const -> TextureFormat;
         auto format() const -> TextureDataFormat {
@@ -41,6 +67,7 @@ namespace solo {
     protected:
         Vector2 dimensions_;
         TextureDataFormat format_ = TextureDataFormat::RGBA;
+        bool flippedVertically_ = false;
 
         explicit Texture2DData(TextureDataFormat format, Vector2 dimensions);
     };
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloThreadPool.h"
+#include <algorithm>
+
+using namespace solo;
+
+static thread_local ThreadPool *currentPool = nullptr;
+static thread_local u32 currentWorkerIndex = 0;
+
+static constexpr u32 spinsBeforeSleep = 64;
+
+ThreadPool::ThreadPool(u32 workerCount) {
+    for (auto &count : injectedCounts_)
+        count = 0;
+
+    if (!workerCount)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (u32 i = 0; i < workerCount; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->seed = i * 2654435761u + 1;
+        workers_.push_back(std::move(worker));
+    }
+
+    // Start threads only after all deques exist since workers steal from each other right away
+    for (u32 i = 0; i < workerCount; i++)
+        workers_[i]->thread = std::thread([this, i] { run(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+
+    for (auto &worker : workers_)
+        worker->thread.join();
+
+    Task *task = nullptr;
+    for (auto &worker : workers_) {
+        while (worker->deque.pop(task))
+            delete task;
+    }
+    for (auto &tasks : injected_) {
+        for (auto t : tasks)
+            delete t;
+    }
+}
+
+void ThreadPool::submit(Task task, JobPriority priority) {
+    const auto t = new Task(std::move(task));
+
+    if (currentPool == this && priority == JobPriority::Normal)
+        workers_[currentWorkerIndex]->deque.push(t);
+    else {
+        const auto index = static_cast<u32>(priority);
+        std::lock_guard<AdaptiveLock> lock(injectedLock_);
+        injected_[index].push_back(t);
+        injectedCounts_[index]++;
+    }
+
+    queuedTasks_++;
+    if (sleepingWorkers_ > 0)
+        wakeWorker();
+}
+
+void ThreadPool::wakeWorker() {
+    // Taking the lock guarantees the worker is either still checking its predicate or already waiting
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    wakeCondition_.notify_one();
+}
+
+void ThreadPool::run(u32 workerIndex) {
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    u32 idleSpins = 0;
+    while (true) {
+        const auto task = findTask(workerIndex);
+        if (task) {
+            queuedTasks_--;
+            idleSpins = 0;
+            try {
+                (*task)();
+            } catch (const std::exception &e) {
+                Logger::global().logError(fmt("Unhandled exception in worker thread: ", e.what()));
+            }
+            delete task;
+            continue;
+        }
+
+        if (stopping_)
+            break;
+
+        if (++idleSpins < spinsBeforeSleep) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        idleSpins = 0;
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepingWorkers_++;
+        wakeCondition_.wait(lock, [this] { return stopping_ || queuedTasks_ > 0; });
+        sleepingWorkers_--;
+    }
+
+    currentPool = nullptr;
+}
+
+auto ThreadPool::findTask(u32 workerIndex) -> Task* {
+    auto &worker = *workers_[workerIndex];
+
+    auto task = takeInjected(JobPriority::High);
+    if (task)
+        return task;
+
+    if (worker.deque.pop(task))
+        return task;
+
+    task = takeInjected(JobPriority::Normal);
+    if (task)
+        return task;
+
+    task = steal(workerIndex);
+    if (task)
+        return task;
+
+    return takeInjected(JobPriority::Low);
+}
+
+auto ThreadPool::steal(u32 workerIndex) -> Task* {
+    auto &worker = *workers_[workerIndex];
+    const auto count = workerCount();
+    if (count < 2)
+        return nullptr;
+
+    // xorshift to pick the first victim so that idle workers don't all hammer the same deque
+    worker.seed ^= worker.seed << 13;
+    worker.seed ^= worker.seed >> 17;
+    worker.seed ^= worker.seed << 5;
+    const auto first = worker.seed % count;
+
+    Task *task = nullptr;
+    for (u32 i = 0; i < count; i++) {
+        const auto victim = (first + i) % count;
+        if (victim != workerIndex && workers_[victim]->deque.steal(task))
+            return task;
+    }
+
+    return nullptr;
+}
+
+auto ThreadPool::takeInjected(JobPriority priority) -> Task* {
+    const auto index = static_cast<u32>(priority);
+    if (!injectedCounts_[index])
+        return nullptr;
+
+    std::lock_guard<AdaptiveLock> lock(injectedLock_);
+    auto &tasks = injected_[index];
+    if (tasks.empty())
+        return nullptr;
+    const auto task = tasks.front();
+    tasks.pop_front();
+    injectedCounts_[index]--;
+    return task;
+}
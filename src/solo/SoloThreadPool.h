@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloWorkStealingDeque.h"
+#include "SoloAdaptiveLock.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace solo {
+    // Order matters, higher priorities go later
+    enum class JobPriority {
+        Low,
+        Normal,
+        High
+    };
+
+    // Persistent worker threads, one work-stealing deque per worker. Tasks submitted from a worker
+    // go to its own deque, other threads (and any non-normal priority tasks) go into shared per-priority queues.
+    // Workers look for high priority tasks first and pick up low priority ones only when there's nothing else.
+    class ThreadPool final {
+    public:
+        using Task = std::function<void()>;
+
+        // 0 means "one worker per hardware thread"
+        explicit ThreadPool(u32 workerCount = 0);
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool(ThreadPool &&other) = delete;
+        ~ThreadPool();
+
+        auto operator=(const ThreadPool &other) -> ThreadPool & = delete;
+        auto operator=(ThreadPool &&other) -> ThreadPool & = delete;
+
+        auto workerCount() const -> u32 {
+            return static_cast<u32>(workers_.size());
+        }
+
+        void submit(Task task, JobPriority priority = JobPriority::Normal);
+
+        auto injectionLockStats() const -> LockStats {
+            return injectedLock_.stats();
+        }
+
+    private:
+        struct Worker {
+            WorkStealingDeque<Task*> deque;
+            std::thread thread;
+            u32 seed = 0;
+        };
+
+        vec<uptr<Worker>> workers_;
+
+        AdaptiveLock injectedLock_{true};
+        arr<std::deque<Task*>, 3> injected_;
+        arr<std::atomic<u32>, 3> injectedCounts_;
+
+        std::mutex sleepMutex_;
+        std::condition_variable wakeCondition_;
+        std::atomic<u32> sleepingWorkers_{0};
+        std::atomic<s64> queuedTasks_{0};
+        std::atomic<bool> stopping_{false};
+
+        void run(u32 workerIndex);
+        auto findTask(u32 workerIndex) -> Task*;
+        auto takeInjected(JobPriority priority) -> Task*;
+        auto steal(u32 workerIndex) -> Task*;
+        void wakeWorker();
+    };
+}
@@ -4,33 +4,218 @@
  */
 
 #include "SoloVertexBufferLayout.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 using namespace solo;
 
-void VertexBufferLayout::addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage) {
-    const auto size = static_cast<u32>(sizeof(float) * elementCount);
+static auto componentSize(VertexAttributeFormat format) -> u32 {
+    switch (format) {
+        case VertexAttributeFormat::Float:
+            return 4;
+        case VertexAttributeFormat::Half:
+        case VertexAttributeFormat::SNorm16:
+        case VertexAttributeFormat::UNorm16:
+        case VertexAttributeFormat::Octahedral:
+            return 2;
+        case VertexAttributeFormat::SNorm8:
+        case VertexAttributeFormat::UNorm8:
+            return 1;
+        default:
+            panic("Unsupported vertex attribute format");
+            return 0;
+    }
+}
+
+// Octahedral mapping of a unit vector onto a square, see "A Survey of Efficient Representations for Independent Unit Vectors"
+static void encodeOctahedral(const float *v, float *result) {
+    const auto l1 = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+    auto x = l1 > 0 ? v[0] / l1 : 0;
+    auto y = l1 > 0 ? v[1] / l1 : 0;
+    if (v[2] < 0) {
+        const auto ox = (1 - std::abs(y)) * (x >= 0 ? 1 : -1);
+        const auto oy = (1 - std::abs(x)) * (y >= 0 ? 1 : -1);
+        x = ox;
+        y = oy;
+    }
+    result[0] = x;
+    result[1] = y;
+}
+
+static void decodeOctahedral(const float *e, float *result) {
+    auto x = e[0], y = e[1];
+    const auto z = 1 - std::abs(x) - std::abs(y);
+    if (z < 0) {
+        const auto ox = (1 - std::abs(y)) * (x >= 0 ? 1 : -1);
+        const auto oy = (1 - std::abs(x)) * (y >= 0 ? 1 : -1);
+        x = ox;
+        y = oy;
+    }
+    const auto length = std::sqrt(x * x + y * y + z * z);
+    result[0] = x / length;
+    result[1] = y / length;
+    result[2] = z / length;
+}
+
+template <class T>
+static auto toNormalized(float value, float min) -> T {
+    const auto max = static_cast<float>((std::numeric_limits<T>::max)());
+    return static_cast<T>(std::round((std::max)(min, (std::min)(1.0f, value)) * max));
+}
+
+template <class T>
+static auto fromNormalized(T value) -> float {
+    return (std::max)(-1.0f, static_cast<float>(value) / (std::numeric_limits<T>::max)());
+}
+
+static void encode(const VertexAttribute &attr, const float *values, u8 *target) {
+    float octahedral[2];
+    auto count = attr.elementCount;
+    if (attr.format == VertexAttributeFormat::Octahedral) {
+        encodeOctahedral(values, octahedral);
+        values = octahedral;
+        count = 2;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        const auto v = values[i];
+        switch (attr.format) {
+            case VertexAttributeFormat::Float:
+                std::memcpy(target + i * 4, &v, 4);
+                break;
+            case VertexAttributeFormat::Half: {
+                const auto h = glm::packHalf1x16(v);
+                std::memcpy(target + i * 2, &h, 2);
+                break;
+            }
+            case VertexAttributeFormat::SNorm16:
+            case VertexAttributeFormat::Octahedral: {
+                const auto s = toNormalized<int16_t>(v, -1);
+                std::memcpy(target + i * 2, &s, 2);
+                break;
+            }
+            case VertexAttributeFormat::UNorm16: {
+                const auto s = toNormalized<u16>(v, 0);
+                std::memcpy(target + i * 2, &s, 2);
+                break;
+            }
+            case VertexAttributeFormat::SNorm8:
+                target[i] = static_cast<u8>(toNormalized<int8_t>(v, -1));
+                break;
+            case VertexAttributeFormat::UNorm8:
+                target[i] = toNormalized<u8>(v, 0);
+                break;
+        }
+    }
+}
+
+static void decode(const VertexAttribute &attr, const u8 *source, float *values) {
+    float octahedral[2];
+    const auto isOctahedral = attr.format == VertexAttributeFormat::Octahedral;
+    const auto result = isOctahedral ? octahedral : values;
+    const auto count = isOctahedral ? 2 : attr.elementCount;
+
+    for (u32 i = 0; i < count; i++) {
+        switch (attr.format) {
+            case VertexAttributeFormat::Float:
+                std::memcpy(&result[i], source + i * 4, 4);
+                break;
+            case VertexAttributeFormat::Half: {
+                u16 h;
+                std::memcpy(&h, source + i * 2, 2);
+                result[i] = glm::unpackHalf1x16(h);
+                break;
+            }
+            case VertexAttributeFormat::SNorm16:
+            case VertexAttributeFormat::Octahedral: {
+                int16_t s;
+                std::memcpy(&s, source + i * 2, 2);
+                result[i] = fromNormalized(s);
+                break;
+            }
+            case VertexAttributeFormat::UNorm16: {
+                u16 s;
+                std::memcpy(&s, source + i * 2, 2);
+                result[i] = fromNormalized(s);
+                break;
+            }
+            case VertexAttributeFormat::SNorm8:
+                result[i] = fromNormalized(static_cast<int8_t>(source[i]));
+                break;
+            case VertexAttributeFormat::UNorm8:
+                result[i] = fromNormalized(source[i]);
+                break;
+        }
+    }
+
+    if (isOctahedral)
+        decodeOctahedral(octahedral, values);
+}
+
+void VertexBufferLayout::convert(const VertexBufferLayout &sourceLayout, const void *source,
+    const VertexBufferLayout &targetLayout, void *target, u32 vertexCount) {
+    const auto sourceBytes = static_cast<const u8 *>(source);
+    const auto targetBytes = static_cast<u8 *>(target);
+    const auto sourceStride = sourceLayout.size();
+    const auto targetStride = targetLayout.size();
+    std::memset(target, 0, static_cast<size_t>(vertexCount) * targetStride);
+
+    for (const auto &to : targetLayout.attributes_) {
+        const auto fromIndex = sourceLayout.attributeIndex(to.usage);
+        if (fromIndex < 0)
+            continue;
+
+        const auto &from = sourceLayout.attributes_[fromIndex];
+        const auto sameFormat = from.format == to.format && from.elementCount == to.elementCount;
+        for (u32 v = 0; v < vertexCount; v++) {
+            const auto src = sourceBytes + static_cast<size_t>(v) * sourceStride + from.offset;
+            const auto dst = targetBytes + static_cast<size_t>(v) * targetStride + to.offset;
+            if (sameFormat)
+                std::memcpy(dst, src, to.size);
+            else {
+                float values[4] = {0, 0, 0, 0};
+                decode(from, src, values);
+                encode(to, values, dst);
+            }
+        }
+    }
+}
+
+void VertexBufferLayout::addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage, VertexAttributeFormat format) {
+    const auto componentBytes = componentSize(format);
+    const auto componentCount = format == VertexAttributeFormat::Octahedral
+        ? 2
+        : (elementCount * componentBytes + 3) / 4 * 4 / componentBytes;
+    const auto size = componentCount * componentBytes;
     const auto offset = attributes_.empty() ? 0 : attributes_.crbegin()->offset + attributes_.crbegin()->size;
-    attributes_.push_back(VertexAttribute{name, elementCount, size, offset, usage});
+    attributes_.push_back(VertexAttribute{name, elementCount, componentCount, size, offset, usage, format});
     this->elementCount_ += elementCount;
     this->size_ += size;
 }
 
 void VertexBufferLayout::addAttribute(VertexAttributeUsage usage) {
+    addAttribute(usage, VertexAttributeFormat::Float);
+}
+
+void VertexBufferLayout::addAttribute(VertexAttributeUsage usage, VertexAttributeFormat format) {
     switch (usage) {
         case VertexAttributeUsage::Position:
-            addAttribute(3, "sl_Position", VertexAttributeUsage::Position);
+            addAttribute(3, "sl_Position", VertexAttributeUsage::Position, format);
             break;
         case VertexAttributeUsage::Normal:
-            addAttribute(3, "sl_Normal", VertexAttributeUsage::Normal);
+            addAttribute(3, "sl_Normal", VertexAttributeUsage::Normal, format);
             break;
         case VertexAttributeUsage::TexCoord:
-            addAttribute(2, "sl_TexCoord", VertexAttributeUsage::TexCoord);
+            addAttribute(2, "sl_TexCoord", VertexAttributeUsage::TexCoord, format);
             break;
         case VertexAttributeUsage::Tangent:
-            addAttribute(3, "sl_Tangent", VertexAttributeUsage::Tangent);
+            addAttribute(3, "sl_Tangent", VertexAttributeUsage::Tangent, format);
             break;
         case VertexAttributeUsage::Binormal:
-            addAttribute(3, "sl_Binormal", VertexAttributeUsage::Binormal);
+            addAttribute(3, "sl_Binormal", VertexAttributeUsage::Binormal, format);
             break;
         default:
             panic("Unsupported vertex attribute usage");
@@ -44,3 +229,57 @@ auto VertexBufferLayout::attributeIndex(VertexAttributeUsage usage) const -> s32
     }
     return -1;
 }
+
+bool VertexBufferLayout::isFloat() const {
+    return std::all_of(attributes_.begin(), attributes_.end(), [](const VertexAttribute &attr) {
+        return attr.format == VertexAttributeFormat::Float;
+    });
+}
+
+bool VertexBufferLayout::sameAs(const VertexBufferLayout &other) const {
+    if (attributes_.size() != other.attributes_.size())
+        return false;
+    for (size_t i = 0; i < attributes_.size(); i++) {
+        const auto &a = attributes_[i];
+        const auto &b = other.attributes_[i];
+        if (a.usage != b.usage || a.format != b.format || a.elementCount != b.elementCount || a.name != b.name)
+            return false;
+    }
+    return true;
+}
+
+auto VertexBufferLayout::toFloat() const -> VertexBufferLayout {
+    VertexBufferLayout result;
+    for (const auto &attr : attributes_)
+        result.addAttribute(attr.elementCount, attr.name, attr.usage, VertexAttributeFormat::Float);
+    return result;
+}
+
+auto VertexBufferLayout::toCompact() const -> VertexBufferLayout {
+    VertexBufferLayout result;
+    for (const auto &attr : attributes_) {
+        auto format = attr.format;
+        if (format == VertexAttributeFormat::Float) {
+            switch (attr.usage) {
+                case VertexAttributeUsage::TexCoord:
+                    format = VertexAttributeFormat::Half;
+                    break;
+                case VertexAttributeUsage::Normal:
+                case VertexAttributeUsage::Tangent:
+                case VertexAttributeUsage::Binormal:
+                    format = VertexAttributeFormat::SNorm8;
+                    break;
+                default:
+                    break;
+            }
+        }
+        result.addAttribute(attr.elementCount, attr.name, attr.usage, format);
+    }
+    return result;
+}
+
+auto VertexBufferLayout::pack(const float *data, u32 vertexCount) const -> vec<u8> {
+    vec<u8> result(static_cast<size_t>(vertexCount) * size_);
+    convert(toFloat(), data, *this, result.data(), vertexCount);
+    return result;
+}
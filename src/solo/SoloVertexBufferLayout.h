@@ -12,15 +12,23 @@ namespace solo {
     class VertexAttribute final {
     public:
         str name;
-        u32 elementCount;
+        u32 elementCount; // as seen by shaders
+        u32 componentCount; // as stored, padded so that every attribute stays 4-byte aligned
         u32 size;
         u32 offset;
         VertexAttributeUsage usage;
+        VertexAttributeFormat format;
     };
 
     class VertexBufferLayout final {
     public:
+        // Copies vertices between layouts, converting attribute formats. Attributes are matched by usage,
+        // the ones missing from the source are zeroed.
+        static void convert(const VertexBufferLayout &sourceLayout, const void *source,
+            const VertexBufferLayout &targetLayout, void *target, u32 vertexCount);
+
         void addAttribute(VertexAttributeUsage usage);
+        void addAttribute(VertexAttributeUsage usage, VertexAttributeFormat format);
 
         auto attributeCount() const -> u32 {
             return static_cast<u32>(attributes_.size());
@@ -37,11 +45,23 @@ namespace solo {
             return elementCount_;
         }
 
+        bool isFloat() const;
+        bool sameAs(const VertexBufferLayout &other) const;
+
+        // Same attributes, all stored as floats
+        auto toFloat() const -> VertexBufferLayout;
+        // Same attributes, float ones switched to compact formats that shaders read the same way:
+        // half texture coordinates and 8-bit normalized normals, tangents and binormals. Positions stay floats.
+        auto toCompact() const -> VertexBufferLayout;
+
+        // Converts floats (elementCount per attribute, back to back) into this layout's formats
+        auto pack(const float *data, u32 vertexCount) const -> vec<u8>;
+
     private:
         vec<VertexAttribute> attributes_;
         u32 size_ = 0; // in bytes
-        u32 elementCount_ = 0; // number of "elements" (floats)
+        u32 elementCount_ = 0; // number of "elements" (floats when unpacked)
 
-        void addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage);
+        void addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage, VertexAttributeFormat format);
     };
 }
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <atomic>
+
+namespace solo {
+    // Chase-Lev deque. The owning thread pushes and pops at the bottom, other threads steal from the top.
+    // T must be trivially copyable (used with raw pointers), capacity must be a power of two.
+    template <class T>
+    class WorkStealingDeque final {
+    public:
+        explicit WorkStealingDeque(s64 capacity = 256) {
+            auto array = std::make_unique<Array>(capacity);
+            array_.store(array.get(), std::memory_order_relaxed);
+            arrays_.push_back(std::move(array));
+        }
+
+        WorkStealingDeque(const WorkStealingDeque &other) = delete;
+        WorkStealingDeque(WorkStealingDeque &&other) = delete;
+        ~WorkStealingDeque() = default;
+
+        auto operator=(const WorkStealingDeque &other) -> WorkStealingDeque & = delete;
+        auto operator=(WorkStealingDeque &&other) -> WorkStealingDeque & = delete;
+
+        // Owner only
+        void push(T item) {
+            const auto b = bottom_.load(std::memory_order_relaxed);
+            const auto t = top_.load(std::memory_order_acquire);
+            auto array = array_.load(std::memory_order_relaxed);
+            if (b - t > array->capacity - 1)
+                array = grow(array, b, t);
+            array->put(b, item);
+            bottom_.store(b + 1, std::memory_order_release);
+        }
+
+        // Owner only
+        bool pop(T &item) {
+            const auto b = bottom_.load(std::memory_order_relaxed) - 1;
+            const auto array = array_.load(std::memory_order_relaxed);
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = top_.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            item = array->get(b);
+            if (t == b) {
+                // Last item, race against thieves
+                const auto won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        // Any thread
+        bool steal(T &item) {
+            auto t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto b = bottom_.load(std::memory_order_acquire);
+            if (t >= b)
+                return false;
+
+            const auto array = array_.load(std::memory_order_acquire);
+            item = array->get(t);
+            return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        bool isEmpty() const {
+            const auto b = bottom_.load(std::memory_order_relaxed);
+            const auto t = top_.load(std::memory_order_relaxed);
+            return b <= t;
+        }
+
+    private:
+        struct Array {
+            s64 capacity;
+            uptr<std::atomic<T>[]> items;
+
+            explicit Array(s64 capacity):
+                capacity(capacity),
+                items(std::make_unique<std::atomic<T>[]>(capacity)) {
+            }
+
+            auto get(s64 index) const -> T {
+                return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(s64 index, T item) {
+                items[index & (capacity - 1)].store(item, std::memory_order_relaxed);
+            }
+        };
+
+        std::atomic<s64> top_{0};
+        std::atomic<s64> bottom_{0};
+        std::atomic<Array*> array_{nullptr};
+
+        // Retired arrays stay alive until the deque dies since thieves may still be reading them
+        vec<uptr<Array>> arrays_;
+
+        auto grow(Array *array, s64 bottom, s64 top) -> Array* {
+            auto bigger = std::make_unique<Array>(array->capacity * 2);
+            for (auto i = top; i < bottom; i++)
+                bigger->put(i, array->get(i));
+            const auto result = bigger.get();
+            arrays_.push_back(std::move(bigger));
+            array_.store(result, std::memory_order_release);
+            return result;
+        }
+    };
+}
@@ -27,6 +27,9 @@ BulletStaticMeshCollider::BulletStaticMeshCollider(sptr<Mesh> mesh):
     inputMesh_(mesh) {
     panicIf(mesh->vertexBufferCount() != 1, "Only single-buffer meshes are supported for now");
     panicIf(mesh->indexBufferCount() != 1, "Only single-index meshes are supported for now");
+    // Bullet reads the triangles straight from the mesh's CPU copy, it must stay put while the collider lives
+    panicIf(mesh->cpuData() != MeshCpuData::Keep, "Mesh must keep its CPU data (MeshCpuData::Keep) to be used as a collider");
+    mesh->pinCpuData();
 
     mesh_ = std::make_unique<btIndexedMesh>();
 
@@ -36,21 +39,28 @@ BulletStaticMeshCollider::BulletStaticMeshCollider(sptr<Mesh> mesh):
     panicIf(posAttrIdx == -1, "No position attribute found in mesh buffer layout");
 
     const auto posAttr = layout.attribute(posAttrIdx);
+    panicIf(posAttr.format != VertexAttributeFormat::Float, "Mesh positions must be stored as floats");
 
+    const auto part = mesh->part(0);
     mesh_->m_vertexType = PHY_FLOAT;
-    mesh_->m_numVertices = mesh->vertexBufferVertexCount(0);
-    mesh_->m_vertexBase = reinterpret_cast<const u8 *>(mesh->vertexBufferData(0).data()) + posAttr.offset; // TODO verify
+    mesh_->m_numVertices = mesh->vertexBufferVertexCount(0) - part.baseVertex;
+    mesh_->m_vertexBase = mesh->vertexBufferData(0) + static_cast<size_t>(part.baseVertex) * layout.size() + posAttr.offset;
     mesh_->m_vertexStride = layout.size();
 
-    const auto indexType = toIndexType(mesh->indexBufferElementSize(0));
+    // CPU copies of indices are always 32-bit, whatever the GPU buffer uses
+    const auto indexType = toIndexType(IndexElementSize::Bits32);
 
     mesh_->m_indexType = indexType;
     mesh_->m_numTriangles = mesh->indexBufferElementCount(0) / 3;
-    mesh_->m_triangleIndexBase = reinterpret_cast<const u8 *>(mesh->indexData(0).data());
-    mesh_->m_triangleIndexStride = 3 * static_cast<s32>(mesh->indexBufferElementSize(0));
+    mesh_->m_triangleIndexBase = reinterpret_cast<const u8 *>(mesh->indexData() + part.indexOffset);
+    mesh_->m_triangleIndexStride = 3 * static_cast<s32>(IndexElementSize::Bits32);
 
     indexVertexArray_ = std::make_unique<btTriangleIndexVertexArray>();
     indexVertexArray_->addIndexedMesh(*mesh_, indexType);
 
     shape_ = std::make_unique<btBvhTriangleMeshShape>(indexVertexArray_.get(), true);
 }
+
+BulletStaticMeshCollider::~BulletStaticMeshCollider() {
+    inputMesh_->unpinCpuData();
+}
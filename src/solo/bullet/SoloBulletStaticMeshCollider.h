@@ -13,6 +13,7 @@ namespace solo {
     class BulletStaticMeshCollider final: public BulletCollider, public StaticMeshCollider {
     public:
         explicit BulletStaticMeshCollider(sptr<Mesh> mesh);
+        ~BulletStaticMeshCollider();
 
         auto shape() -> btCollisionShape *override {
             return shape_.get();
@@ -7,6 +7,11 @@
 
 #ifdef SL_OPENGL_RENDERER
 
+#include "SoloDevice.h"
+#include "SoloEffectCache.h"
+#include "SoloHash.h"
+#include "SoloBinaryIO.h"
+
 using namespace solo;
 
 static auto compileShader(GLuint type, const void *src, u32 length) -> GLint {
@@ -30,16 +35,18 @@ static auto compileShader(GLuint type, const void *src, u32 length) -> GLint {
         vec<GLchar> log(logLength);
         glGetShaderInfoLog(shader, logLength, nullptr, log.data());
         glDeleteShader(shader);
-        panic("Unable to compile ", typeNames[type], " shader:\n", log.data());
+        throw AssetError(fmt("Unable to compile ", typeNames[type], " shader:\n", log.data()));
     }
 
     return shader;
 }
 
-static auto linkProgram(GLuint vs, GLuint fs) -> GLint {
+static auto linkProgram(GLuint vs, GLuint fs, bool retrievable) -> GLint {
     const auto program = glCreateProgram();
     glAttachShader(program, vs);
     glAttachShader(program, fs);
+    if (retrievable)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
 
     GLint status;
@@ -50,16 +57,74 @@ static auto linkProgram(GLuint vs, GLuint fs) -> GLint {
         vec<GLchar> log(logLength);
         glGetProgramInfoLog(program, logLength, nullptr, log.data());
         glDeleteProgram(program);
-        panic("Unable to link program:\n", log.data());
+        throw AssetError(fmt("Unable to link program:\n", log.data()));
     }
 
     return program;
 }
 
-OpenGLEffect::OpenGLEffect(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen) {
+static auto uniformSize(GLenum type) -> u32 {
+    switch (type) {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_BOOL:
+            return 4;
+        case GL_FLOAT_VEC2:
+            return 8;
+        case GL_FLOAT_VEC3:
+            return 12;
+        case GL_FLOAT_VEC4:
+            return 16;
+        case GL_FLOAT_MAT3:
+            return 36;
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_CUBE:
+            return 0;
+        default:
+            return 64;
+    }
+}
+
+static bool supportsProgramBinaries() {
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+static auto programCacheKey(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen) -> u64 {
+    // Program binaries are only valid for the exact driver that produced them. Bump the version
+    // when changing the layout written by toCacheData().
+    auto key = hashString("opengl-program:2");
+    key = hashString(reinterpret_cast<const char *>(glGetString(GL_VENDOR)), key);
+    key = hashString(reinterpret_cast<const char *>(glGetString(GL_RENDERER)), key);
+    key = hashString(reinterpret_cast<const char *>(glGetString(GL_VERSION)), key);
+    key = hashBytes(vsSrc, vsSrcLen, key);
+    return hashBytes(fsSrc, fsSrcLen, key);
+}
+
+OpenGLEffect::OpenGLEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen) {
+    const auto cache = device->effectCache();
+    const auto useCache = cache->isEnabled() && supportsProgramBinaries();
+    const auto cacheKey = useCache ? programCacheKey(vsSrc, vsSrcLen, fsSrc, fsSrcLen) : 0;
+
+    vec<u8> cached;
+    if (useCache && cache->read(cacheKey, cached) && loadFromCache(cached)) {
+        registerParameters();
+        return;
+    }
+
     const auto vs = compileShader(GL_VERTEX_SHADER, vsSrc, vsSrcLen);
-    const auto fs = compileShader(GL_FRAGMENT_SHADER, fsSrc, fsSrcLen);
-    handle_ = linkProgram(vs, fs);
+    GLint fs = 0;
+    try {
+        fs = compileShader(GL_FRAGMENT_SHADER, fsSrc, fsSrcLen);
+        handle_ = linkProgram(vs, fs, useCache);
+    } catch (...) {
+        // Deleting shader 0 is a no-op
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+        throw;
+    }
 
     glDetachShader(handle_, vs);
     glDeleteShader(vs);
@@ -68,6 +133,13 @@ OpenGLEffect::OpenGLEffect(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u
 
     introspectUniforms();
     introspectAttributes();
+    registerParameters();
+
+    if (useCache) {
+        const auto data = toCacheData();
+        if (!data.empty())
+            cache->write(cacheKey, data);
+    }
 }
 
 OpenGLEffect::~OpenGLEffect() {
@@ -103,6 +175,7 @@ void OpenGLEffect::introspectUniforms() {
 
         uniforms_[name].location = glGetUniformLocation(handle_, nameArr.data());
         uniforms_.at(name).samplerIndex = 0;
+        uniforms_.at(name).size = uniformSize(type);
 
         u32 idx = 0;
         if (type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE) { // TODO other types of samplers
@@ -133,4 +206,111 @@ void OpenGLEffect::introspectAttributes() {
     }
 }
 
+void OpenGLEffect::registerParameters() {
+    // There are no uniform buffers in the generated GLSL, so the block just packs uniforms one after another
+    u32 offset = 0;
+    for (const auto &pair : uniforms_) {
+        addParameter(pair.first, offset, pair.second.size);
+        parameterUniforms_.push_back(pair.second);
+        offset += pair.second.size;
+    }
+}
+
+void OpenGLEffect::swapContents(Effect &other) {
+    Effect::swapContents(other);
+
+    auto &effect = static_cast<OpenGLEffect &>(other);
+    std::swap(handle_, effect.handle_);
+    std::swap(uniforms_, effect.uniforms_);
+    std::swap(attributes_, effect.attributes_);
+    std::swap(parameterUniforms_, effect.parameterUniforms_);
+    appliedBlockVersion_ = effect.appliedBlockVersion_ = 0;
+}
+
+auto OpenGLEffect::parameterKey(const str &name) const -> str {
+    // Uniform buffer members are plain uniforms named "buffer_member" in GLSL 330
+    auto key = name;
+    const auto idx = name.find_last_of(':');
+    if (idx != str::npos)
+        key.replace(idx, 1, "_");
+    return key;
+}
+
+bool OpenGLEffect::loadFromCache(const vec<u8> &data) {
+    BinaryReader reader{data.data(), data.size()};
+
+    const auto binaryFormat = reader.read<GLenum>();
+    const auto binarySize = reader.read<u32>();
+    if (!reader.isOk() || binarySize > data.size() - reader.position())
+        return false;
+    vec<u8> binary(binarySize);
+    reader.read(binary.data(), binarySize);
+
+    umap<str, UniformInfo> uniforms;
+    const auto uniformCount = reader.read<u32>();
+    for (u32 i = 0; i < uniformCount && reader.isOk(); i++) {
+        auto &info = uniforms[reader.readString()];
+        info.location = reader.read<u32>();
+        info.samplerIndex = reader.read<u32>();
+        info.size = reader.read<u32>();
+    }
+
+    umap<str, AttributeInfo> attributes;
+    const auto attrCount = reader.read<u32>();
+    for (u32 i = 0; i < attrCount && reader.isOk(); i++)
+        attributes[reader.readString()].location = reader.read<u32>();
+
+    if (!reader.isOk() || !reader.isAtEnd())
+        return false;
+
+    const auto program = glCreateProgram();
+    glProgramBinary(program, binaryFormat, binary.data(), binarySize);
+
+    // Drivers reject binaries after updates or for their own reasons, in which case we just recompile
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        glDeleteProgram(program);
+        return false;
+    }
+
+    handle_ = program;
+    uniforms_ = std::move(uniforms);
+    attributes_ = std::move(attributes);
+
+    return true;
+}
+
+auto OpenGLEffect::toCacheData() const -> vec<u8> {
+    GLint binarySize = 0;
+    glGetProgramiv(handle_, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0)
+        return {};
+
+    vec<u8> binary(binarySize);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(handle_, binarySize, nullptr, &binaryFormat, binary.data());
+
+    BinaryWriter writer;
+    writer.write(binaryFormat);
+    writer.write(static_cast<u32>(binary.size()));
+    writer.write(binary.data(), binary.size());
+
+    writer.write(static_cast<u32>(uniforms_.size()));
+    for (const auto &pair : uniforms_) {
+        writer.writeString(pair.first);
+        writer.write(pair.second.location);
+        writer.write(pair.second.samplerIndex);
+        writer.write(pair.second.size);
+    }
+
+    writer.write(static_cast<u32>(attributes_.size()));
+    for (const auto &pair : attributes_) {
+        writer.writeString(pair.first);
+        writer.write(pair.second.location);
+    }
+
+    return writer.data();
+}
+
 #endif
@@ -13,18 +13,21 @@
 #include "SoloOpenGL.h"
 
 namespace solo {
+    class Device;
+
     class OpenGLEffect final : public Effect {
     public:
         struct UniformInfo {
             u32 location;
             u32 samplerIndex;
+            u32 size; // zero for samplers
         };
 
         struct AttributeInfo {
             u32 location;
         };
 
-        OpenGLEffect(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen);
+        OpenGLEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen);
         ~OpenGLEffect();
 
         auto handle() const -> GLuint {
@@ -44,13 +47,37 @@ namespace solo {
             return attributes_.at(name);
         }
 
+        auto parameterUniform(u32 handle) const -> const UniformInfo & {
+            return parameterUniforms_[handle];
+        }
+
+        // Uniforms keep their values in the program, so a material whose block hasn't changed
+        // since it was last applied only needs to upload its per-draw values
+        auto appliedBlockVersion() const -> u64 {
+            return appliedBlockVersion_;
+        }
+        void setAppliedBlockVersion(u64 version) {
+            appliedBlockVersion_ = version;
+        }
+
+        void swapContents(Effect &other) override;
+
+    protected:
+        auto parameterKey(const str &name) const -> str override;
+
     private:
         GLuint handle_ = 0;
         umap<str, UniformInfo> uniforms_;
         umap<str, AttributeInfo> attributes_;
+        vec<UniformInfo> parameterUniforms_;
+        u64 appliedBlockVersion_ = 0;
 
         void introspectUniforms();
         void introspectAttributes();
+        void registerParameters();
+
+        bool loadFromCache(const vec<u8> &data);
+        auto toCacheData() const -> vec<u8>;
     };
 }
 
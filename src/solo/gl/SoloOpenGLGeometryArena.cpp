@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloCommon.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloOpenGLGeometryArena.h"
+
+using namespace solo;
+
+static auto createBuffer(GLsizeiptr size) -> GLuint {
+    GLuint handle = 0;
+    glGenBuffers(1, &handle);
+    panicIf(!handle, "Unable to create geometry arena buffer");
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return handle;
+}
+
+// Copies into a new buffer, ranges within one buffer must not overlap
+static void copyRanges(GLuint from, GLuint to, u32 elementSize, const vec<GeometryArena::Move> &moves) {
+    glBindBuffer(GL_COPY_READ_BUFFER, from);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+    for (const auto &move : moves) {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(move.from) * elementSize, static_cast<GLintptr>(move.to) * elementSize,
+            static_cast<GLsizeiptr>(move.count) * elementSize);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+OpenGLGeometryArena::~OpenGLGeometryArena() {
+    for (auto &buffers : buffers_) {
+        buffers.vertexArrays.clear();
+        glDeleteBuffers(1, &buffers.vertexBuffer);
+        glDeleteBuffers(1, &buffers.indexBuffer);
+    }
+}
+
+auto OpenGLGeometryArena::vertexArray(u32 pool, OpenGLEffect *effect) -> GLuint {
+    auto &buffers = buffers_.at(pool);
+    return buffers.vertexArrays.vertexArray(effect, [&]() {
+        OpenGLVertexArrayCache::setAttributes(effect, poolLayout(pool), buffers.vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+    });
+}
+
+void OpenGLGeometryArena::resizePool(u32 pool, u32 vertexCapacity, u32 indexCapacity,
+    const vec<Move> &vertexMoves, const vec<Move> &indexMoves) {
+    if (pool >= buffers_.size())
+        buffers_.resize(pool + 1);
+
+    const auto vertexSize = poolLayout(pool).size();
+    const auto indexSize = static_cast<u32>(poolIndexElementSize(pool));
+    const auto vertexBuffer = createBuffer(static_cast<GLsizeiptr>(vertexCapacity) * vertexSize);
+    const auto indexBuffer = createBuffer(static_cast<GLsizeiptr>(indexCapacity) * indexSize);
+
+    auto &buffers = buffers_[pool];
+    if (buffers.vertexBuffer) {
+        copyRanges(buffers.vertexBuffer, vertexBuffer, vertexSize, vertexMoves);
+        copyRanges(buffers.indexBuffer, indexBuffer, indexSize, indexMoves);
+        glDeleteBuffers(1, &buffers.vertexBuffer);
+        glDeleteBuffers(1, &buffers.indexBuffer);
+    }
+
+    // Vertex arrays reference the old buffers
+    buffers.vertexArrays.clear();
+    buffers.vertexBuffer = vertexBuffer;
+    buffers.indexBuffer = indexBuffer;
+}
+
+void OpenGLGeometryArena::upload(u32 pool, u32 firstVertex, const void *vertices, u32 vertexCount,
+    u32 firstIndex, const void *indices, u32 indexCount) {
+    const auto &buffers = buffers_.at(pool);
+    const auto vertexSize = poolLayout(pool).size();
+    const auto indexSize = static_cast<u32>(poolIndexElementSize(pool));
+
+    // Not through GL_ELEMENT_ARRAY_BUFFER, that would change the bound vertex array
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(firstVertex) * vertexSize,
+        static_cast<GLsizeiptr>(vertexCount) * vertexSize, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(firstIndex) * indexSize,
+        static_cast<GLsizeiptr>(indexCount) * indexSize, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+#endif
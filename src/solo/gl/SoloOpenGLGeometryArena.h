@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloGeometryArena.h"
+#include "SoloOpenGL.h"
+#include "SoloOpenGLVertexArrayCache.h"
+
+namespace solo {
+    class OpenGLEffect;
+
+    class OpenGLGeometryArena final : public GeometryArena {
+    public:
+        OpenGLGeometryArena() = default;
+        ~OpenGLGeometryArena();
+
+        // Shared by all meshes of the pool, references both of its buffers
+        auto vertexArray(u32 pool, OpenGLEffect *effect) -> GLuint;
+
+    protected:
+        void resizePool(u32 pool, u32 vertexCapacity, u32 indexCapacity,
+            const vec<Move> &vertexMoves, const vec<Move> &indexMoves) override;
+        void upload(u32 pool, u32 firstVertex, const void *vertices, u32 vertexCount,
+            u32 firstIndex, const void *indices, u32 indexCount) override;
+
+    private:
+        struct PoolBuffers {
+            GLuint vertexBuffer = 0;
+            GLuint indexBuffer = 0;
+            OpenGLVertexArrayCache vertexArrays;
+        };
+
+        vec<PoolBuffers> buffers_;
+    };
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include "SoloOpenGLMesh.h"
 #include "SoloDevice.h"
 #include "SoloOpenGLEffect.h"
+#include "SoloOpenGLGeometryArena.h"
 
 using namespace solo;
 
@@ -46,94 +47,43 @@ static auto toIndexType(IndexElementSize elementSize) -> GLenum {
 }
 
 OpenGLMesh::~OpenGLMesh() {
-    clearVertexArrayCache();
-    while (!vertexBuffers_.empty())
-        removeVertexBuffer(0);
-    while (!indexBuffers_.empty())
-        removeIndexBuffer(0);
+    vertexArrays_.clear();
+    if (!vertexBuffers_.empty())
+        glDeleteBuffers(static_cast<GLsizei>(vertexBuffers_.size()), vertexBuffers_.data());
+    if (indexBuffer_)
+        glDeleteBuffers(1, &indexBuffer_);
 }
 
-auto OpenGLMesh::getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint {
-    auto &cacheEntry = vertexArrayCache_[effect];
-    cacheEntry.age = 0;
-
-    auto &handle = cacheEntry.handle;
-    if (handle)
-        return handle;
-
-    glGenVertexArrays(1, &handle);
-    panicIf(!handle, "Unable to create vertex array");
-
-    glBindVertexArray(handle);
-
-    for (u32 i = 0; i < vertexBuffers_.size(); i++) {
-        const auto &bufferHandle = vertexBuffers_.at(i);
-        const auto &layout = layouts_.at(i);
-        const auto attrCount = layout.attributeCount();
-        if (!attrCount)
-            continue;
-
-        glBindBuffer(GL_ARRAY_BUFFER, bufferHandle);
-
-        u32 offset = 0;
-        for (u32 j = 0; j < attrCount; j++) {
-            const auto attr = layout.attribute(j);
-            const auto stride = layout.size();
-
-            u32 location = 0;
-            auto found = true;
-            if (!attr.name.empty()) {
-                if (effect->hasAttribute(attr.name)) {
-                    const auto attrInfo = effect->attributeInfo(attr.name);
-                    location = attrInfo.location;
-                } else
-                    found = false;
-            }
-
-            if (found) {
-                glVertexAttribPointer(location, attr.elementCount, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(offset));
-                glEnableVertexAttribArray(location);
-            }
-
-            offset += attr.size;
-        }
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-
-    glBindVertexArray(0);
-
-    return handle;
+void OpenGLMesh::unbind() {
+    OpenGLVertexArrayCache::unbind();
 }
 
-void OpenGLMesh::clearVertexArrayCache() {
-    for (auto &p : vertexArrayCache_)
-        glDeleteVertexArrays(1, &p.second.handle);
-    vertexArrayCache_.clear();
-}
+void OpenGLMesh::swapContents(Mesh &other) {
+    Mesh::swapContents(other);
 
-void OpenGLMesh::flushVertexArrayCache() {
-    uset<OpenGLEffect *> toRemove;
-    for (auto &entry : vertexArrayCache_) {
-        if (++entry.second.age >= 1000) // TODO more sophisticated way
-            toRemove.insert(entry.first);
-    }
-
-    for (auto &key : toRemove)
-        vertexArrayCache_.erase(key);
+    auto &mesh = static_cast<OpenGLMesh &>(other);
+    std::swap(vertexBuffers_, mesh.vertexBuffers_);
+    std::swap(indexBuffer_, mesh.indexBuffer_);
+    // Vertex arrays reference the buffers
+    vertexArrays_.clear();
+    mesh.vertexArrays_.clear();
 }
 
-auto OpenGLMesh::addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
-    addVertexBuffer(layout, data.data(), vertexCount, false);
-    return Mesh::addVertexBuffer(layout, data, vertexCount);
-}
+auto OpenGLMesh::vertexArray(OpenGLEffect *effect) -> GLuint {
+    if (arenaAllocation_) {
+        const auto arena = static_cast<OpenGLGeometryArena *>(arenaAllocation_->arena());
+        return arena->vertexArray(arenaAllocation_->pool(), effect);
+    }
 
-auto OpenGLMesh::addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
-    addVertexBuffer(layout, data.data(), vertexCount, true);
-    return Mesh::addVertexBuffer(layout, data, vertexCount);
+    return vertexArrays_.vertexArray(effect, [this, effect]() {
+        for (u32 i = 0; i < vertexBuffers_.size(); i++)
+            OpenGLVertexArrayCache::setAttributes(effect, layouts_.at(i), vertexBuffers_.at(i));
+        if (indexBuffer_)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    });
 }
 
-void OpenGLMesh::addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) {
+void OpenGLMesh::uploadVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) {
     GLuint handle = 0;
     glGenBuffers(1, &handle);
     panicIf(!handle, "Unable to create vertex buffer handle");
@@ -144,62 +94,54 @@ void OpenGLMesh::addVertexBuffer(const VertexBufferLayout &layout, const void *d
 
     vertexBuffers_.push_back(handle);
 
-    clearVertexArrayCache();
+    vertexArrays_.clear();
 }
 
-void OpenGLMesh::updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) {
+void OpenGLMesh::uploadVertexBufferPart(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) {
     const auto vertexSize = layouts_.at(index).size();
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers_.at(index));
     glBufferSubData(GL_ARRAY_BUFFER, vertexOffset * vertexSize, vertexCount * vertexSize, data);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    Mesh::updateVertexBuffer(index, vertexOffset, data, vertexCount);
 }
 
-void OpenGLMesh::removeVertexBuffer(u32 index) {
+void OpenGLMesh::destroyVertexBuffer(u32 index) {
     auto handle = vertexBuffers_.at(index);
     glDeleteBuffers(1, &handle);
     vertexBuffers_.erase(vertexBuffers_.begin() + index);
-    clearVertexArrayCache();
-    Mesh::removeVertexBuffer(index);
+    vertexArrays_.clear();
 }
 
-auto OpenGLMesh::addIndexBuffer(const vec<u32> &data, u32 elementCount) -> u32 {
-    GLuint handle = 0;
-    glGenBuffers(1, &handle);
-    panicIf(!handle, "Unable to create index buffer handle");
+void OpenGLMesh::uploadIndexBuffer(const void *data, u32 indexCount) {
+    // Binding the element buffer would otherwise change whatever vertex array is bound
+    OpenGLVertexArrayCache::unbind();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(IndexElementSize::Bits32) * elementCount, data.data(), GL_STATIC_DRAW); // TODO 16-bit support?
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    indexBuffers_.push_back(handle);
+    const auto created = !indexBuffer_;
+    if (created) {
+        glGenBuffers(1, &indexBuffer_);
+        panicIf(!indexBuffer_, "Unable to create index buffer handle");
+    }
 
-    return Mesh::addIndexBuffer(data, elementCount);
-}
+    const auto elementSize = static_cast<GLsizeiptr>(indexElementSize_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementSize * indexCount, data, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-void OpenGLMesh::removeIndexBuffer(u32 index) {
-    auto handle = indexBuffers_.at(index);
-    glDeleteBuffers(1, &handle);
-    indexBuffers_.erase(indexBuffers_.begin() + index);
-    Mesh::removeIndexBuffer(index);
+    // Existing vertex arrays were set up without an index buffer
+    if (created)
+        vertexArrays_.clear();
 }
 
 void OpenGLMesh::render(OpenGLEffect *effect) {
-    const auto va = getOrCreateVertexArray(effect);
-    flushVertexArrayCache();
-    glBindVertexArray(va);
-    glDrawArrays(toPrimitiveType(primitiveType_), 0, minVertexCount_);
-    glBindVertexArray(0);
+    OpenGLVertexArrayCache::bind(vertexArray(effect));
+    glDrawArrays(toPrimitiveType(primitiveType_), firstVertex(), minVertexCount_);
 }
 
 void OpenGLMesh::renderIndex(u32 index, OpenGLEffect *effect) {
-    const auto va = getOrCreateVertexArray(effect);
-    flushVertexArrayCache();
-    glBindVertexArray(va);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffers_.at(index));
-    glDrawElements(toPrimitiveType(primitiveType_), indexElementCounts_.at(index), toIndexType(IndexElementSize::Bits32), nullptr); // TODO 16-bit support?
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    OpenGLVertexArrayCache::bind(vertexArray(effect));
+    const auto &part = parts_.at(index);
+    const auto offset = (static_cast<size_t>(firstIndex()) + part.indexOffset) * static_cast<size_t>(indexElementSize_);
+    glDrawElementsBaseVertex(toPrimitiveType(primitiveType_), part.indexCount, toIndexType(indexElementSize_),
+        reinterpret_cast<void *>(offset), firstVertex() + part.baseVertex);
 }
 
 #endif
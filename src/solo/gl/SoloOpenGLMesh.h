@@ -11,6 +11,7 @@
 
 #include "SoloMesh.h"
 #include "SoloOpenGL.h"
+#include "SoloOpenGLVertexArrayCache.h"
 
 namespace solo {
     class Effect;
@@ -21,33 +22,28 @@ namespace solo {
         OpenGLMesh() = default;
         ~OpenGLMesh();
 
-        auto addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 override;
-        auto addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 override;
-        void updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) override;
-        void removeVertexBuffer(u32 index) override;
-
-        auto addIndexBuffer(const vec<u32> &data, u32 indexElementCount) -> u32 override;
-        void removeIndexBuffer(u32 index) override;
-
+        // Both leave the mesh bound, so that drawing the next part of it (or the next mesh in the same
+        // geometry arena pool) doesn't bind anything
         void render(OpenGLEffect *effect);
         void renderIndex(u32 index, OpenGLEffect *effect);
 
-    private:
-        vec<GLuint> vertexBuffers_;
-        vec<GLuint> indexBuffers_;
+        // Called when the renderer is done with meshes, so that nothing else modifies a bound vertex array
+        static void unbind();
 
-        struct VertexArrayCacheEntry {
-            GLuint handle;
-            u32 age;
-        };
+        void swapContents(Mesh &other) override;
 
-        umap<OpenGLEffect *, VertexArrayCacheEntry> vertexArrayCache_;
+    protected:
+        void uploadVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) override;
+        void uploadVertexBufferPart(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) override;
+        void destroyVertexBuffer(u32 index) override;
+        void uploadIndexBuffer(const void *data, u32 indexCount) override;
 
-        void addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic);
+    private:
+        vec<GLuint> vertexBuffers_;
+        GLuint indexBuffer_ = 0;
+        OpenGLVertexArrayCache vertexArrays_;
 
-        auto getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint;
-        void clearVertexArrayCache();
-        void flushVertexArrayCache();
+        auto vertexArray(OpenGLEffect *effect) -> GLuint;
     };
 }
 
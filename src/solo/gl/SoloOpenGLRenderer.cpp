@@ -195,6 +195,7 @@ void OpenGLRenderer::beginCamera(Camera *camera) {
 }
 
 void OpenGLRenderer::endCamera(Camera *camera) {
+    OpenGLMesh::unbind();
     const auto renderTarget = camera->renderTarget();
     if (renderTarget)
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -204,14 +205,14 @@ void OpenGLRenderer::endCamera(Camera *camera) {
 void OpenGLRenderer::renderMesh(Mesh *mesh, Transform *transform, Material *material) {
     applyMaterial(material);
     const auto effect = dynamic_cast<OpenGLEffect *>(material->effect().get());
-    dynamic_cast<OpenGLMaterial *>(material)->applyParams(currentCamera_, transform);
+    dynamic_cast<OpenGLMaterial *>(material)->applyParams(currentCamera_, transform, &matrixCache_);
     dynamic_cast<OpenGLMesh *>(mesh)->render(effect);
 }
 
 void OpenGLRenderer::renderMeshIndex(Mesh *mesh, u32 index, Transform *transform, Material *material) {
     applyMaterial(material);
     const auto effect = dynamic_cast<OpenGLEffect *>(material->effect().get());
-    dynamic_cast<OpenGLMaterial *>(material)->applyParams(currentCamera_, transform);
+    dynamic_cast<OpenGLMaterial *>(material)->applyParams(currentCamera_, transform, &matrixCache_);
     dynamic_cast<OpenGLMesh *>(mesh)->renderIndex(index, effect);
 }
 
@@ -199,8 +199,10 @@ auto OpenGLTexture2D::fromData(sptr<Texture2DData> data, bool generateMipmaps) -
     const auto dimensions = data->dimensions();
     const auto internalFormat = toInternalFormat(data->textureFormat());
     const auto dataFormat = toDataFormat(data->format());
+    // Cooked textures come with their mip levels, those are uploaded as is
+    const auto uploadedLevels = generateMipmaps ? data->mipLevelCount() : 1;
     const auto mipLevels = generateMipmaps
-    ? std::floor(std::log2((std::max)(dimensions.x(), dimensions.y()))) + 1
+    ? (uploadedLevels > 1 ? uploadedLevels - 1 : std::floor(std::log2((std::max)(dimensions.x(), dimensions.y()))) + 1)
     : 0;
 
     panicIf(!isFormatSupported(internalFormat, dataFormat, GL_UNSIGNED_BYTE), "Texture format not supported");
@@ -211,9 +213,13 @@ auto OpenGLTexture2D::fromData(sptr<Texture2DData> data, bool generateMipmaps) -
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels);
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, dimensions.x(), dimensions.y(), 0, dataFormat, GL_UNSIGNED_BYTE, data->data());
+    for (u32 level = 0; level < uploadedLevels; level++) {
+        const auto levelDimensions = data->mipLevelDimensions(level);
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelDimensions.x(), levelDimensions.y(), 0, dataFormat,
+            GL_UNSIGNED_BYTE, data->mipLevelData(level));
+    }
 
-    if (generateMipmaps && data->textureFormat() != TextureFormat::Depth24) {
+    if (generateMipmaps && uploadedLevels == 1 && data->textureFormat() != TextureFormat::Depth24) {
         glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST);
         glGenerateMipmap(GL_TEXTURE_2D);
     }
@@ -244,6 +250,12 @@ auto OpenGLTexture2D::empty(u32 width, u32 height, TextureFormat format) -> sptr
     return result;
 }
 
+// Sampling parameters are set on every bind, so they apply to the new image as well
+void OpenGLTexture2D::swapContents(Texture2D &other) {
+    Texture2D::swapContents(other);
+    std::swap(handle_, static_cast<OpenGLTexture2D &>(other).handle_);
+}
+
 void OpenGLTexture2D::bind() {
     glBindTexture(GL_TEXTURE_2D, handle_);
 
@@ -39,6 +39,7 @@ namespace solo {
         static auto fromData(sptr<Texture2DData> data, bool generateMipmaps) -> sptr<OpenGLTexture2D>;
 
         void bind() override;
+        void swapContents(Texture2D &other) override;
 
     private:
         OpenGLTexture2D(TextureFormat format, Vector2 dimensions);
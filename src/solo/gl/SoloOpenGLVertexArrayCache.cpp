@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloCommon.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloOpenGLVertexArrayCache.h"
+#include "SoloOpenGLEffect.h"
+#include "SoloVertexBufferLayout.h"
+
+using namespace solo;
+
+static auto toAttributeType(VertexAttributeFormat format) -> GLenum {
+    switch (format) {
+        case VertexAttributeFormat::Float:
+            return GL_FLOAT;
+        case VertexAttributeFormat::Half:
+            return GL_HALF_FLOAT;
+        case VertexAttributeFormat::SNorm16:
+        case VertexAttributeFormat::Octahedral:
+            return GL_SHORT;
+        case VertexAttributeFormat::UNorm16:
+            return GL_UNSIGNED_SHORT;
+        case VertexAttributeFormat::SNorm8:
+            return GL_BYTE;
+        case VertexAttributeFormat::UNorm8:
+            return GL_UNSIGNED_BYTE;
+    }
+
+    panic("Unsupported vertex attribute format");
+
+    return 0;
+}
+
+// Vertex array bound by the last draw. The index buffer is part of the vertex array state, so consecutive draws
+// of parts of the same mesh, or of meshes in the same geometry arena pool, don't need to bind anything.
+static GLuint boundVertexArray = 0;
+
+void OpenGLVertexArrayCache::bind(GLuint handle) {
+    if (handle != boundVertexArray) {
+        glBindVertexArray(handle);
+        boundVertexArray = handle;
+    }
+}
+
+void OpenGLVertexArrayCache::unbind() {
+    bind(0);
+}
+
+// Deleting the bound vertex array reverts the binding to 0
+static void deleteVertexArray(GLuint handle) {
+    if (handle == boundVertexArray)
+        boundVertexArray = 0;
+    glDeleteVertexArrays(1, &handle);
+}
+
+void OpenGLVertexArrayCache::setAttributes(OpenGLEffect *effect, const VertexBufferLayout &layout, GLuint buffer) {
+    const auto attrCount = layout.attributeCount();
+    if (!attrCount)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    u32 offset = 0;
+    for (u32 j = 0; j < attrCount; j++) {
+        const auto attr = layout.attribute(j);
+        const auto stride = layout.size();
+
+        u32 location = 0;
+        auto found = true;
+        if (!attr.name.empty()) {
+            if (effect->hasAttribute(attr.name)) {
+                const auto attrInfo = effect->attributeInfo(attr.name);
+                location = attrInfo.location;
+            } else
+                found = false;
+        }
+
+        if (found) {
+            const auto normalized = attr.format != VertexAttributeFormat::Float && attr.format != VertexAttributeFormat::Half;
+            glVertexAttribPointer(location, attr.componentCount, toAttributeType(attr.format), normalized ? GL_TRUE : GL_FALSE,
+                stride, reinterpret_cast<void *>(offset));
+            glEnableVertexAttribArray(location);
+        }
+
+        offset += attr.size;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+auto OpenGLVertexArrayCache::vertexArray(OpenGLEffect *effect, const std::function<void()> &setup) -> GLuint {
+    auto &entry = entries_[effect];
+    entry.age = 0;
+
+    // A reloaded effect may place attributes at other locations
+    if (entry.handle && entry.effectRevision != effect->revision()) {
+        deleteVertexArray(entry.handle);
+        entry.handle = 0;
+    }
+
+    if (!entry.handle) {
+        glGenVertexArrays(1, &entry.handle);
+        panicIf(!entry.handle, "Unable to create vertex array");
+        entry.effectRevision = effect->revision();
+        bind(entry.handle);
+        setup();
+    }
+
+    const auto handle = entry.handle;
+    flush();
+    return handle;
+}
+
+void OpenGLVertexArrayCache::clear() {
+    for (auto &p : entries_)
+        deleteVertexArray(p.second.handle);
+    entries_.clear();
+}
+
+void OpenGLVertexArrayCache::flush() {
+    uset<OpenGLEffect *> toRemove;
+    for (auto &entry : entries_) {
+        if (++entry.second.age >= 1000) // TODO more sophisticated way
+            toRemove.insert(entry.first);
+    }
+
+    for (auto &key : toRemove) {
+        deleteVertexArray(entries_.at(key).handle);
+        entries_.erase(key);
+    }
+}
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloOpenGL.h"
+#include <functional>
+
+namespace solo {
+    class OpenGLEffect;
+    class VertexBufferLayout;
+
+    // Vertex arrays of one set of buffers, one per effect since effects place attributes at different locations.
+    // Arrays not used for a while are deleted.
+    class OpenGLVertexArrayCache {
+    public:
+        // Points the effect's attributes at a buffer of the layout, into the currently bound vertex array
+        static void setAttributes(OpenGLEffect *effect, const VertexBufferLayout &layout, GLuint buffer);
+
+        // Binds the vertex array, unless it is already bound. Consecutive draws from the same buffers don't bind anything.
+        static void bind(GLuint handle);
+        static void unbind();
+
+        // Returns the effect's array, creating it with `setup` (called with the new array bound) if it doesn't exist yet
+        // or was made for another revision of the effect. Ages the other arrays.
+        auto vertexArray(OpenGLEffect *effect, const std::function<void()> &setup) -> GLuint;
+
+        void clear();
+
+    private:
+        struct Entry {
+            GLuint handle;
+            u32 age;
+            u64 effectRevision;
+        };
+
+        umap<OpenGLEffect *, Entry> entries_;
+
+        void flush();
+    };
+}
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloAsyncHandle.h"
+#include "SoloLuaCommon.h"
+
+using namespace solo;
+
+void registerAsyncHandleApi(CppBindModule<LuaBinding> &module) {
+    auto b = BEGIN_CLASS_RENAMED(module, AsyncHandleBase, "AsyncHandle");
+    REG_METHOD(b, AsyncHandleBase, isPending);
+    REG_METHOD(b, AsyncHandleBase, isResolved);
+    REG_METHOD(b, AsyncHandleBase, isFailed);
+    REG_METHOD(b, AsyncHandleBase, isCancelled);
+    REG_METHOD(b, AsyncHandleBase, priority);
+    REG_METHOD(b, AsyncHandleBase, setPriority);
+    REG_METHOD(b, AsyncHandleBase, cancel);
+    b.endClass();
+}
@@ -21,6 +21,7 @@ using namespace LuaIntf;
 #define BEGIN_CLASS(module, klass) module.beginClass<klass>(#klass)
 #define BEGIN_CLASS_RENAMED(module, klass, name) module.beginClass<klass>(name)
 #define BEGIN_CLASS_EXTEND(module, klass, base) module.beginExtendClass<klass, base>(#klass)
+#define BEGIN_CLASS_EXTEND_RENAMED(module, klass, base, name) module.beginExtendClass<klass, base>(name)
 
 #define REG_CTOR(binding, ...) binding.addConstructor(LUA_ARGS(__VA_ARGS__))
 
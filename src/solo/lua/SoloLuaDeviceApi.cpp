@@ -8,6 +8,7 @@
 #include "SoloScene.h"
 #include "SoloDevice.h"
 #include "SoloDeviceSetup.h"
+#include "SoloJobPool.h"
 
 using namespace solo;
 
@@ -32,6 +33,7 @@ static void registerDevice(CppBindModule<LuaBinding> &module) {
     REG_METHOD(binding, Device, isMouseButtonReleased);
     REG_METHOD(binding, Device, update);
     REG_METHOD(binding, Device, hasActiveBackgroundJobs);
+    REG_METHOD(binding, Device, backgroundJobStats);
     REG_METHOD(binding, Device, fileSystem);
     REG_METHOD(binding, Device, physics);
     REG_METHOD(binding, Device, renderer);
@@ -50,10 +52,28 @@ void registerDeviceSetup(CppBindModule<LuaBinding> &module) {
     REG_FIELD(setup, DeviceSetup, windowTitle);
     REG_FIELD(setup, DeviceSetup, vsync);
     REG_FIELD(setup, DeviceSetup, logFilePath);
+    REG_FIELD(setup, DeviceSetup, effectCachePath);
+    REG_FIELD(setup, DeviceSetup, cookedAssetsPath);
+    REG_FIELD(setup, DeviceSetup, jobCompletionBudget);
+    REG_FIELD(setup, DeviceSetup, geometryArena);
+    REG_FIELD(setup, DeviceSetup, hotReload);
     setup.endClass();
 }
 
+static void registerJobStats(CppBindModule<LuaBinding> &module) {
+    auto stats = BEGIN_CLASS(module, JobStats);
+    REG_FIELD(stats, JobStats, queuedMainThreadTasks);
+    REG_FIELD(stats, JobStats, processedMainThreadTasks);
+    REG_FIELD(stats, JobStats, mainThreadTime);
+    REG_FIELD(stats, JobStats, budgetOverruns);
+    REG_FIELD(stats, JobStats, queueLockAcquisitions);
+    REG_FIELD(stats, JobStats, queueLockContentions);
+    REG_FIELD(stats, JobStats, queueLockWaitTime);
+    stats.endClass();
+}
+
 void registerDeviceApi(CppBindModule<LuaBinding> &module) {
     registerDeviceSetup(module);
+    registerJobStats(module);
     registerDevice(module);
 }
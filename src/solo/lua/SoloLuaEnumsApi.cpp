@@ -7,6 +7,7 @@
 #include "SoloTexture.h"
 #include "SoloLuaCommon.h"
 #include "SoloEnums.h"
+#include "SoloThreadPool.h"
 
 using namespace solo;
 
@@ -19,6 +20,14 @@ void registerEnums(CppBindModule<LuaBinding> &module) {
         m.endModule();
     }
 
+    {
+        auto m = module.beginModule("JobPriority");
+        REG_MODULE_CONSTANT(m, JobPriority, Low);
+        REG_MODULE_CONSTANT(m, JobPriority, Normal);
+        REG_MODULE_CONSTANT(m, JobPriority, High);
+        m.endModule();
+    }
+
     {
         auto m = module.beginModule("TextureWrap");
         REG_MODULE_CONSTANT(m, TextureWrap, ClampToEdge);
@@ -204,10 +213,29 @@ void registerEnums(CppBindModule<LuaBinding> &module) {
         m.endModule();
     }
 
+    {
+        auto m = module.beginModule("VertexAttributeFormat");
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, Float);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, Half);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, SNorm16);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, UNorm16);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, SNorm8);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, UNorm8);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, Octahedral);
+        m.endModule();
+    }
+
     {
         auto m = module.beginModule("IndexElementSize");
         REG_MODULE_CONSTANT(m, IndexElementSize, Bits16);
         REG_MODULE_CONSTANT(m, IndexElementSize, Bits32);
         m.endModule();
     }
+
+    {
+        auto m = module.beginModule("MeshCpuData");
+        REG_MODULE_CONSTANT(m, MeshCpuData, Keep);
+        REG_MODULE_CONSTANT(m, MeshCpuData, Release);
+        m.endModule();
+    }
 }
@@ -18,12 +18,20 @@ static void registerFont(CppBindModule<LuaBinding> &module) {
     REG_FIELD(gi, GlyphInfo, offsetY);
     gi.endClass();
 
-    auto binding = BEGIN_CLASS(module, Font);
-    REG_STATIC_METHOD(binding, Font, loadFromFile);
-    REG_METHOD(binding, Font, atlas);
-    REG_METHOD(binding, Font, glyphInfo);
-    REG_PTR_EQUALITY(binding, Font);
-    binding.endClass();
+    {
+        auto binding = BEGIN_CLASS(module, Font);
+        REG_STATIC_METHOD(binding, Font, loadFromFile);
+        REG_STATIC_METHOD(binding, Font, loadFromFileAsync);
+        REG_METHOD(binding, Font, atlas);
+        REG_METHOD(binding, Font, glyphInfo);
+        REG_PTR_EQUALITY(binding, Font);
+        binding.endClass();
+    }
+    {
+        auto binding = BEGIN_CLASS_EXTEND_RENAMED(module, AsyncHandle<Font>, AsyncHandleBase, "FontAsyncHandle");
+        REG_METHOD(binding, AsyncHandle<Font>, done);
+        binding.endClass();
+    }
 }
 
 static void registerFontMesh(CppBindModule<LuaBinding> &module) {
@@ -8,21 +8,33 @@
 
 using namespace solo;
 
+// Parameters can be addressed either by name or by a handle obtained from parameterHandle()
+#define REG_PARAMETER_METHOD(binding, method, valueType) \
+    binding.addFunction(#method, \
+        [](Material *material, LuaRef param, valueType value) \
+        { \
+            if (param.type() == LuaTypeID::NUMBER) \
+                material->method(param.toValue<u32>(), value); \
+            else \
+                material->method(param.toValue<str>(), value); \
+        })
+
 void registerMaterialApi(CppBindModule<LuaBinding> &module) {
     auto binding = BEGIN_CLASS(module, Material);
     REG_STATIC_METHOD(binding, Material, fromEffect);
-    REG_METHOD(binding, Material, setFloatParameter);
-    REG_METHOD(binding, Material, setVector2Parameter);
-    REG_METHOD(binding, Material, setVector3Parameter);
-    REG_METHOD(binding, Material, setVector4Parameter);
-    REG_METHOD(binding, Material, setMatrixParameter);
-    REG_METHOD(binding, Material, setTextureParameter);
-    REG_METHOD(binding, Material, bindFloatParameter);
-    REG_METHOD(binding, Material, bindVector2Parameter);
-    REG_METHOD(binding, Material, bindVector3Parameter);
-    REG_METHOD(binding, Material, bindVector4Parameter);
-    REG_METHOD(binding, Material, bindMatrixParameter);
-    REG_METHOD(binding, Material, bindParameter);
+    REG_METHOD(binding, Material, parameterHandle);
+    REG_PARAMETER_METHOD(binding, setFloatParameter, float);
+    REG_PARAMETER_METHOD(binding, setVector2Parameter, const Vector2 &);
+    REG_PARAMETER_METHOD(binding, setVector3Parameter, const Vector3 &);
+    REG_PARAMETER_METHOD(binding, setVector4Parameter, const Vector4 &);
+    REG_PARAMETER_METHOD(binding, setMatrixParameter, const Matrix &);
+    REG_PARAMETER_METHOD(binding, setTextureParameter, sptr<Texture>);
+    REG_PARAMETER_METHOD(binding, bindFloatParameter, const std::function<float()> &);
+    REG_PARAMETER_METHOD(binding, bindVector2Parameter, const std::function<Vector2()> &);
+    REG_PARAMETER_METHOD(binding, bindVector3Parameter, const std::function<Vector3()> &);
+    REG_PARAMETER_METHOD(binding, bindVector4Parameter, const std::function<Vector4()> &);
+    REG_PARAMETER_METHOD(binding, bindMatrixParameter, const std::function<Matrix()> &);
+    REG_PARAMETER_METHOD(binding, bindParameter, ParameterBinding);
     REG_METHOD(binding, Material, effect);
     REG_METHOD(binding, Material, clone);
     REG_METHOD(binding, Material, polygonMode);
@@ -17,35 +17,84 @@ static auto addDynamicVertexBuffer(Mesh *mesh, const VertexBufferLayout &layout,
 }
 
 static void updateVertexBuffer(Mesh *mesh, u32 index, u32 vertexOffset, const vec<float> &data, u32 vertexCount) {
-    mesh->updateVertexBuffer(index, vertexOffset, data.data(), vertexCount);
+    const auto &layout = mesh->vertexBufferLayout(index);
+    if (layout.isFloat())
+        mesh->updateVertexBuffer(index, vertexOffset, data.data(), vertexCount);
+    else
+        mesh->updateVertexBuffer(index, vertexOffset, layout.pack(data.data(), vertexCount).data(), vertexCount);
+}
+
+static void setIndexBuffer(Mesh *mesh, const vec<u32> &data, const vec<Mesh::Part> &parts) {
+    mesh->setIndexBuffer(data.data(), static_cast<u32>(data.size()), parts);
+}
+
+// Empty once the mesh has released its CPU copies
+static auto vertexBufferData(Mesh *mesh, u32 index) -> vec<u8> {
+    const auto data = mesh->vertexBufferData(index);
+    if (!data)
+        return {};
+    return vec<u8>(data, data + static_cast<size_t>(mesh->vertexBufferLayout(index).size()) * mesh->vertexBufferVertexCount(index));
+}
+
+static auto indexData(Mesh *mesh) -> vec<u32> {
+    const auto data = mesh->indexData();
+    if (!data)
+        return {};
+    return vec<u32>(data, data + mesh->indexCount());
+}
+
+static auto fromFile(Device *device, const str &path, const VertexBufferLayout &layout) -> sptr<Mesh> {
+    return Mesh::fromFile(device, path, layout);
+}
+
+static auto fromFileAsync(Device *device, const str &path, const VertexBufferLayout &layout) -> sptr<AsyncHandle<Mesh>> {
+    return Mesh::fromFileAsync(device, path, layout);
 }
 
 static void registerVertexBufferLayout(CppBindModule<LuaBinding> &module) {
     auto el = BEGIN_CLASS(module, VertexAttribute);
     REG_FIELD(el, VertexAttribute, name);
     REG_FIELD(el, VertexAttribute, elementCount);
+    REG_FIELD(el, VertexAttribute, componentCount);
     REG_FIELD(el, VertexAttribute, size);
     REG_FIELD(el, VertexAttribute, offset);
     REG_FIELD(el, VertexAttribute, usage);
+    REG_FIELD(el, VertexAttribute, format);
     el.endClass();
 
     auto layout = BEGIN_CLASS(module, VertexBufferLayout);
     REG_CTOR(layout);
     REG_METHOD_OVERLOADED(layout, VertexBufferLayout, addAttribute, "addAttribute", void, , VertexAttributeUsage);
+    REG_METHOD_OVERLOADED(layout, VertexBufferLayout, addAttribute, "addAttributeWithFormat", void, , VertexAttributeUsage, VertexAttributeFormat);
     REG_METHOD(layout, VertexBufferLayout, attribute);
     REG_METHOD(layout, VertexBufferLayout, attributeCount);
     REG_METHOD(layout, VertexBufferLayout, attributeIndex);
     REG_METHOD(layout, VertexBufferLayout, size);
     REG_METHOD(layout, VertexBufferLayout, elementCount);
+    REG_METHOD(layout, VertexBufferLayout, isFloat);
+    REG_METHOD(layout, VertexBufferLayout, toFloat);
+    REG_METHOD(layout, VertexBufferLayout, toCompact);
     layout.endClass();
 }
 
 static void registerMesh(CppBindModule<LuaBinding> &module) {
+    {
+        auto part = BEGIN_CLASS_RENAMED(module, Mesh::Part, "MeshPart");
+        REG_CTOR(part);
+        REG_FIELD(part, Mesh::Part, indexOffset);
+        REG_FIELD(part, Mesh::Part, indexCount);
+        REG_FIELD(part, Mesh::Part, baseVertex);
+        part.endClass();
+    }
     {
         auto binding = BEGIN_CLASS(module, Mesh);
         REG_STATIC_METHOD(binding, Mesh, empty);
-        REG_STATIC_METHOD(binding, Mesh, fromFile);
-        REG_STATIC_METHOD(binding, Mesh, fromFileAsync);
+        REG_FREE_FUNC_AS_STATIC_FUNC_RENAMED(binding, fromFile, "fromFile");
+        REG_FREE_FUNC_AS_STATIC_FUNC_RENAMED(binding, fromFileAsync, "fromFileAsync");
+        REG_STATIC_METHOD(binding, Mesh, cook);
+        REG_METHOD(binding, Mesh, cpuData);
+        REG_METHOD(binding, Mesh, setCpuData);
+        REG_METHOD(binding, Mesh, isCpuDataPinned);
         REG_FREE_FUNC_AS_METHOD(binding, addVertexBuffer);
         REG_FREE_FUNC_AS_METHOD(binding, addDynamicVertexBuffer);
         REG_FREE_FUNC_AS_METHOD(binding, updateVertexBuffer);
@@ -53,20 +102,24 @@ static void registerMesh(CppBindModule<LuaBinding> &module) {
         REG_METHOD(binding, Mesh, vertexBufferCount);
         REG_METHOD(binding, Mesh, vertexBufferVertexCount);
         REG_METHOD(binding, Mesh, vertexBufferLayout);
-        REG_METHOD(binding, Mesh, vertexBufferData);
+        REG_FREE_FUNC_AS_METHOD(binding, vertexBufferData);
+        REG_FREE_FUNC_AS_METHOD(binding, setIndexBuffer);
         REG_METHOD(binding, Mesh, addIndexBuffer);
         REG_METHOD(binding, Mesh, removeIndexBuffer);
         REG_METHOD(binding, Mesh, indexBufferCount);
         REG_METHOD(binding, Mesh, indexBufferElementCount);
-        REG_METHOD(binding, Mesh, indexBufferElementSize);
-        REG_METHOD(binding, Mesh, indexData);
+        REG_METHOD(binding, Mesh, part);
+        REG_METHOD(binding, Mesh, indexElementSize);
+        REG_METHOD(binding, Mesh, indexCount);
+        REG_FREE_FUNC_AS_METHOD(binding, indexData);
+        REG_METHOD(binding, Mesh, isInGeometryArena);
         REG_METHOD(binding, Mesh, primitiveType);
         REG_METHOD(binding, Mesh, setPrimitiveType);
         REG_PTR_EQUALITY(binding, Mesh);
         binding.endClass();
     }
     {
-        auto binding = BEGIN_CLASS_RENAMED(module, AsyncHandle<Mesh>, "MeshAsyncHandle");
+        auto binding = BEGIN_CLASS_EXTEND_RENAMED(module, AsyncHandle<Mesh>, AsyncHandleBase, "MeshAsyncHandle");
         REG_METHOD(binding, AsyncHandle<Mesh>, done);
         binding.endClass();
     }
@@ -9,6 +9,7 @@
 #include "SoloMeshRenderer.h"
 #include "SoloEffect.h"
 #include "SoloFileSystem.h"
+#include "SoloPackFile.h"
 #include "SoloSpectator.h"
 #include "SoloRenderer.h"
 #include "SoloDebugInterface.h"
@@ -24,19 +25,47 @@ void registerMiscApi(CppBindModule<LuaBinding> &module) {
         REG_METHOD(b, FileSystem, readLines);
         REG_METHOD(b, FileSystem, writeLines);
         REG_METHOD(b, FileSystem, iterateLines);
+        REG_METHOD(b, FileSystem, exists);
+        REG_METHOD(b, FileSystem, listFiles);
+        REG_METHOD(b, FileSystem, createDirectory);
+        REG_METHOD(b, FileSystem, mountPack);
+        REG_METHOD(b, FileSystem, mountDirectory);
         REG_PTR_EQUALITY(b, FileSystem);
         b.endClass();
     }
 
+    {
+        auto b = BEGIN_CLASS(module, PackFile);
+        REG_STATIC_METHOD(b, PackFile, fromPath);
+        REG_STATIC_METHOD(b, PackFile, build);
+        REG_METHOD(b, PackFile, contains);
+        REG_METHOD(b, PackFile, entryNames);
+        REG_PTR_EQUALITY(b, PackFile);
+        b.endClass();
+    }
+
     {
         auto b = BEGIN_CLASS(module, Effect);
         REG_STATIC_METHOD(b, Effect, fromSourceFile);
         REG_STATIC_METHOD(b, Effect, fromDescriptionFile);
         REG_STATIC_METHOD(b, Effect, fromSource);
+        REG_STATIC_METHOD(b, Effect, fromDescriptionFileAsync);
+        REG_STATIC_METHOD(b, Effect, fromDescriptionFilesAsync);
+        REG_STATIC_METHOD(b, Effect, warmCache);
+        REG_METHOD(b, Effect, hasParameter);
+        REG_METHOD(b, Effect, parameterHandle);
+        REG_METHOD(b, Effect, parameterCount);
+        REG_METHOD(b, Effect, parameterName);
         REG_PTR_EQUALITY(b, Effect);
         b.endClass();
     }
 
+    {
+        auto b = BEGIN_CLASS_EXTEND_RENAMED(module, AsyncHandle<Effect>, AsyncHandleBase, "EffectAsyncHandle");
+        REG_METHOD(b, AsyncHandle<Effect>, done);
+        b.endClass();
+    }
+
     {
         auto b = BEGIN_CLASS_EXTEND(module, MeshRenderer, Component);
         REG_METHOD(b, MeshRenderer, render);
@@ -30,8 +30,8 @@ void registerLibrary(LuaState &state) {
             return shape
         end
 
-        sl.generateEffectSource = function(desc)
-            local vulkan = sl.device:mode() == sl.DeviceMode.Vulkan -- otherwise 330
+        sl.generateEffectSource = function(desc, mode)
+            local vulkan = (mode or sl.device:mode()) == sl.DeviceMode.Vulkan -- otherwise 330
 
             function generateAttributes(desc, typeStr)
                 local all = {}
@@ -136,6 +136,18 @@ void registerLibrary(LuaState &state) {
             local vsOutputs = generateAttributes(desc.vertex.outputs, "out")
             local vsCode = generateCode(desc.vertex.code)
 
+            -- Decoder for VertexAttributeFormat.Octahedral attributes, added only to shaders that use it
+            if string.find(vsCode, "sl_decodeOctahedral", 1, true) then
+                vsCode = [[
+                    vec3 sl_decodeOctahedral(vec2 e) {
+                        vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+                        if (v.z < 0)
+                            v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0 ? 1.0 : -1.0, v.y >= 0 ? 1.0 : -1.0);
+                        return normalize(v);
+                    }
+                ]] .. vsCode
+            end
+
             local fsUniformBuffers, fsUniformBufferCount = generateBuffers(desc.fragment.uniformBuffers, vsUniformBufferCount)
             local fsSamplers = generateSamplers(desc.fragment.samplers, vsUniformBufferCount + fsUniformBufferCount)
             local fsInputs = generateAttributes(desc.vertex.outputs, "in")
@@ -11,6 +11,7 @@ using namespace solo;
 
 void registerEnums(CppBindModule<LuaBinding> &module);
 void registerMathApi(CppBindModule<LuaBinding> &module);
+void registerAsyncHandleApi(CppBindModule<LuaBinding> &module);
 void registerNodeAndComponentApi(CppBindModule<LuaBinding> &module);
 void registerTransformApi(CppBindModule<LuaBinding> &module);
 void registerCameraApi(CppBindModule<LuaBinding> &module);
@@ -26,6 +27,7 @@ void registerLibrary(LuaState &state);
 static void registerApi(CppBindModule<LuaBinding> &module) {
     registerEnums(module);
     registerMathApi(module);
+    registerAsyncHandleApi(module);
     registerNodeAndComponentApi(module);
     registerTransformApi(module);
     registerCameraApi(module);
@@ -38,7 +38,7 @@ static void registerTexture2D(CppBindModule<LuaBinding> &module) {
         binding.endClass();
     }
     {
-        auto binding = BEGIN_CLASS_RENAMED(module, AsyncHandle<Texture2D>, "Texture2DAsyncHandle");
+        auto binding = BEGIN_CLASS_EXTEND_RENAMED(module, AsyncHandle<Texture2D>, AsyncHandleBase, "Texture2DAsyncHandle");
         REG_METHOD(binding, AsyncHandle<Texture2D>, done);
         binding.endClass();
     }
@@ -55,7 +55,7 @@ static void registerCubeTexture(CppBindModule<LuaBinding> &module) {
         binding.endClass();
     }
     {
-        auto binding = BEGIN_CLASS_RENAMED(module, AsyncHandle<CubeTexture>, "CubeTextureAsyncHandle");
+        auto binding = BEGIN_CLASS_EXTEND_RENAMED(module, AsyncHandle<CubeTexture>, AsyncHandleBase, "CubeTextureAsyncHandle");
         REG_METHOD(binding, AsyncHandle<CubeTexture>, done);
         binding.endClass();
     }
@@ -7,6 +7,7 @@
 #include "SoloStringUtils.h"
 #include "SoloDevice.h"
 #include "SoloFileSystem.h"
+#include "SoloMappedFile.h"
 #include <algorithm>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -41,16 +42,35 @@ STBTexture2DData::~STBTexture2DData() {
 }
 
 auto STBTexture2DData::fromFile(Device *device, const str &path) -> sptr<STBTexture2DData> {
-    auto bytes = device->fileSystem()->readBytes(path);
+    return fromFile(device->fileSystem(), path, device->mode() == DeviceMode::OpenGL);
+}
+
+auto STBTexture2DData::fromFile(FileSystem *fs, const str &path, bool flipVertically) -> sptr<STBTexture2DData> {
+    const auto file = fs->map(path);
+    return fromBytes(file->data(), file->size(), path, flipVertically);
+}
+
+auto STBTexture2DData::fromBytes(const u8 *bytes, size_t size, const str &path, bool flipVertically) -> sptr<STBTexture2DData> {
     int width, height, channels;
-    stbi_set_flip_vertically_on_load(device->mode() == DeviceMode::OpenGL);
     // According to the docs, channels are not affected by the requested channels
-    const auto data = stbi_load_from_memory(bytes.data(), bytes.size(), &width, &height, &channels, 4);
-    panicIf(!data, "Unable to load image ", path);
+    const auto data = stbi_load_from_memory(bytes, static_cast<int>(size), &width, &height, &channels, 4);
+    assetErrorIf(!data, "Unable to load image ", path, ": ", stbi_failure_reason());
+
+    // Not using stbi_set_flip_vertically_on_load because it's a global flag and images get loaded from several threads
+    if (flipVertically) {
+        const auto rowSize = static_cast<size_t>(width) * 4;
+        vec<stbi_uc> row(rowSize);
+        for (s32 top = 0, bottom = height - 1; top < bottom; top++, bottom--) {
+            std::copy_n(data + top * rowSize, rowSize, row.data());
+            std::copy_n(data + bottom * rowSize, rowSize, data + top * rowSize);
+            std::copy_n(row.data(), rowSize, data + bottom * rowSize);
+        }
+    }
 
     const auto result = std::make_shared<STBTexture2DData>(toFormat(4), Vector2(width, height));
     result->channels_ = 4;
     result->data_ = data;
+    result->flippedVertically_ = flipVertically;
     return result;
 }
 
@@ -82,7 +102,10 @@ auto STBCubeTextureData::fromFaceFiles(
     faces.push_back(STBTexture2DData::fromFile(device, negativeYPath));
     faces.push_back(STBTexture2DData::fromFile(device, positiveZPath));
     faces.push_back(STBTexture2DData::fromFile(device, negativeZPath));
+    return fromFaces(std::move(faces));
+}
 
+auto STBCubeTextureData::fromFaces(vec<sptr<STBTexture2DData>> faces) -> sptr<STBCubeTextureData> {
     asrt([&faces]() {
         const auto dim = faces[0]->dimensions();
         return dim.x() == dim.y();
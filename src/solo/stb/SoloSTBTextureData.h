@@ -11,11 +11,15 @@
 
 namespace solo {
     class Device;
+    class FileSystem;
 
     class STBTexture2DData final: public Texture2DData {
     public:
         static bool canLoadFromFile(const str &path);
         static auto fromFile(Device *device, const str &path) -> sptr<STBTexture2DData>;
+        static auto fromFile(FileSystem *fs, const str &path, bool flipVertically) -> sptr<STBTexture2DData>;
+        // Decodes an image file read already, the path is for error messages
+        static auto fromBytes(const u8 *bytes, size_t size, const str &path, bool flipVertically) -> sptr<STBTexture2DData>;
 
         STBTexture2DData(TextureDataFormat format, Vector2 dimensions);
         ~STBTexture2DData();
@@ -43,6 +47,8 @@ namespace solo {
             const str &positiveXPath, const str &negativeXPath,
             const str &positiveYPath, const str &negativeYPath,
             const str &positiveZPath, const str &negativeZPath) -> sptr<STBCubeTextureData>;
+        // Faces in the +X, -X, +Y, -Y, +Z, -Z order
+        static auto fromFaces(vec<sptr<STBTexture2DData>> faces) -> sptr<STBCubeTextureData>;
 
         STBCubeTextureData(TextureDataFormat format, u32 dimension);
 
@@ -5,8 +5,10 @@
 
 #include "SoloSTBTrueTypeFont.h"
 #include "SoloTexture.h"
+#include "SoloAsyncHandle.h"
 #include "SoloDevice.h"
 #include "SoloFileSystem.h"
+#include "SoloMappedFile.h"
 #include "SoloStringUtils.h"
 #include "SoloTextureData.h"
 #define STB_TRUETYPE_IMPLEMENTATION
@@ -53,8 +55,25 @@ bool STBTrueTypeFont::canLoadFromFile(const str &path) {
 
 auto STBTrueTypeFont::loadFromFile(Device *device, const str &path, u32 size, u32 atlasWidth, u32 atlasHeight,
                                    u32 firstChar, u32 charCount, u32 oversampleX, u32 oversampleY) -> sptr<STBTrueTypeFont> {
-    auto data = device->fileSystem()->readBytes(path);
+    const auto file = device->fileSystem()->map(path);
+    auto result = pack(file->data(), path, size, atlasWidth, atlasHeight, firstChar, charCount, oversampleX, oversampleY);
+    result->createAtlas(device);
+    return result;
+}
+
+auto STBTrueTypeFont::loadFromFileAsync(Device *device, const str &path, u32 size, u32 atlasWidth, u32 atlasHeight,
+                                        u32 firstChar, u32 charCount, u32 oversampleX, u32 oversampleY) -> sptr<AsyncHandle<Font>> {
+    return device->fileSystem()->readBytesAsync(path)->then(JobThread::Worker,
+    [=](sptr<vec<u8>> bytes) {
+        return pack(bytes->data(), path, size, atlasWidth, atlasHeight, firstChar, charCount, oversampleX, oversampleY);
+    })->then(JobThread::Main, [device](sptr<STBTrueTypeFont> font) {
+        font->createAtlas(device);
+        return std::static_pointer_cast<Font>(font);
+    });
+}
 
+auto STBTrueTypeFont::pack(const u8 *fontData, const str &path, u32 size, u32 atlasWidth, u32 atlasHeight,
+                           u32 firstChar, u32 charCount, u32 oversampleX, u32 oversampleY) -> sptr<STBTrueTypeFont> {
     auto result = sptr<STBTrueTypeFont>(new STBTrueTypeFont());
     result->firstChar_ = firstChar;
     result->charInfo_ = std::make_unique<stbtt_packedchar[]>(charCount);
@@ -67,12 +86,17 @@ auto STBTrueTypeFont::loadFromFile(Device *device, const str &path, u32 size, u3
     panicIf(!ret, "Unable to process font ", path);
 
     stbtt_PackSetOversampling(&context, oversampleX, oversampleY);
-    stbtt_PackFontRange(&context, data.data(), 0, static_cast<float>(size), firstChar, charCount, result->charInfo_.get());
+    // stb_truetype only reads the font data, despite the non-const parameter
+    stbtt_PackFontRange(&context, const_cast<u8 *>(fontData), 0, static_cast<float>(size), firstChar, charCount, result->charInfo_.get());
     stbtt_PackEnd(&context);
 
-    const auto atlasData = Texture2DData::fromMemory(atlasWidth, atlasHeight, TextureDataFormat::Red, pixels);
-    result->atlas_ = Texture2D::fromData(device, atlasData, true);
-    result->atlas_->setFilter(TextureFilter::Linear, TextureFilter::Linear, TextureMipFilter::Linear);
+    result->atlasData_ = Texture2DData::fromMemory(atlasWidth, atlasHeight, TextureDataFormat::Red, pixels);
 
     return result;
 }
+
+void STBTrueTypeFont::createAtlas(Device *device) {
+    atlas_ = Texture2D::fromData(device, atlasData_, true);
+    atlas_->setFilter(TextureFilter::Linear, TextureFilter::Linear, TextureMipFilter::Linear);
+    atlasData_.reset();
+}
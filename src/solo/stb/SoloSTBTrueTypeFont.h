@@ -9,6 +9,8 @@
 #include <stb_truetype.h>
 
 namespace solo {
+    class Texture2DData;
+
     class STBTrueTypeFont final : public Font {
     public:
         static bool canLoadFromFile(const str &path);
@@ -16,6 +18,10 @@ namespace solo {
                                  u32 size, u32 atlasWidth, u32 atlasHeight,
                                  u32 firstChar, u32 charCount,
                                  u32 oversampleX, u32 oversampleY) -> sptr<STBTrueTypeFont>;
+        static auto loadFromFileAsync(Device *device, const str &path,
+                                      u32 size, u32 atlasWidth, u32 atlasHeight,
+                                      u32 firstChar, u32 charCount,
+                                      u32 oversampleX, u32 oversampleY) -> sptr<AsyncHandle<Font>>;
 
         auto atlas() const -> sptr<Texture2D> override final {
             return atlas_;
@@ -24,9 +30,18 @@ namespace solo {
 
     private:
         sptr<Texture2D> atlas_;
+        sptr<Texture2DData> atlasData_; // until the atlas texture is created
         u32 firstChar_ = 0;
         uptr<stbtt_packedchar[]> charInfo_;
 
         STBTrueTypeFont() = default;
+
+        // Packs glyphs into the atlas pixels, CPU-only and so safe to run on a worker
+        static auto pack(const u8 *fontData, const str &path,
+                         u32 size, u32 atlasWidth, u32 atlasHeight,
+                         u32 firstChar, u32 charCount,
+                         u32 oversampleX, u32 oversampleY) -> sptr<STBTrueTypeFont>;
+
+        void createAtlas(Device *device);
     };
 }
\ No newline at end of file
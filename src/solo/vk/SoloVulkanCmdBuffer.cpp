@@ -120,6 +120,12 @@ auto VulkanCmdBuffer::copyBuffer(const VulkanBuffer &src, const VulkanBuffer &ds
     return *this;
 }
 
+auto VulkanCmdBuffer::copyBuffer(const VulkanBuffer &src, const VulkanBuffer &dst, const VkBufferCopy *regions,
+                                 u32 regionCount) -> VulkanCmdBuffer & {
+    vkCmdCopyBuffer(handle_, src.handle(), dst.handle(), regionCount, regions);
+    return *this;
+}
+
 auto VulkanCmdBuffer::copyBuffer(const VulkanBuffer &src, const VulkanImage &dst) -> VulkanCmdBuffer & {
     VkBufferImageCopy bufferCopyRegion{};
     bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
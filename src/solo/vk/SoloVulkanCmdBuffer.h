@@ -53,6 +53,7 @@ namespace solo {
         -> VulkanCmdBuffer&;
 
         auto copyBuffer(const VulkanBuffer &src, const VulkanBuffer &dst) -> VulkanCmdBuffer&;
+        auto copyBuffer(const VulkanBuffer &src, const VulkanBuffer &dst, const VkBufferCopy *regions, u32 regionCount) -> VulkanCmdBuffer&;
         auto copyBuffer(const VulkanBuffer &src, const VulkanImage &dst) -> VulkanCmdBuffer&;
         auto copyBuffer(const VulkanBuffer &src, const VulkanImage &dst,
                         const VkBufferImageCopy *regions, u32 regionCount) -> VulkanCmdBuffer&;
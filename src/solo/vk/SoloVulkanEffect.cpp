@@ -8,6 +8,9 @@
 #ifdef SL_VULKAN_RENDERER
 
 #include "SoloDevice.h"
+#include "SoloEffectCache.h"
+#include "SoloHash.h"
+#include "SoloBinaryIO.h"
 #include "SoloVulkan.h"
 #include "SoloVulkanRenderer.h"
 #include <spirv_cross/spirv.hpp>
@@ -44,39 +47,19 @@ static auto compileToSpv(const void *src, u32 srcLen, const str &fileName, bool
 
     const auto compilationStatus = result.GetCompilationStatus();
     const auto errorMessage = result.GetErrorMessage();
-    panicIf(compilationStatus != shaderc_compilation_status_success, "Unable to compile effect to SPV: ", errorMessage);
+    assetErrorIf(compilationStatus != shaderc_compilation_status_success, "Unable to compile effect to SPV: ", errorMessage);
 
     return result;
 }
 
-auto VulkanEffect::fromSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
--> sptr<VulkanEffect> {
-    const auto vsCompilationResult = compileToSpv(vsSrc, vsSrcLen, "<memory>", true);
-    const auto fsCompilationResult = compileToSpv(fsSrc, fsSrcLen, "<memory>", false);
-    const auto vsSize = (vsCompilationResult.end() - vsCompilationResult.begin()) * sizeof(u32);
-    const auto fsSize = (fsCompilationResult.end() - fsCompilationResult.begin()) * sizeof(u32);
-    return std::make_shared<VulkanEffect>(
-        device,
-        vsCompilationResult.begin(), static_cast<u32>(vsSize),
-        fsCompilationResult.begin(), static_cast<u32>(fsSize)
-        );
-}
-
-VulkanEffect::VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen) {
-    renderer_ = dynamic_cast<VulkanRenderer *>(device->renderer());
-    vs_ = createShaderModule(renderer_->device(), vsSrc, vsSrcLen);
-    fs_ = createShaderModule(renderer_->device(), fsSrc, fsSrcLen);
-    introspectShader(static_cast<const u32 *>(vsSrc), vsSrcLen / sizeof(u32), true);
-    introspectShader(static_cast<const u32 *>(fsSrc), fsSrcLen / sizeof(u32), false);
-}
-
-void VulkanEffect::introspectShader(const u32 *src, u32 len, bool vertex) {
-    const spirv_cross::CompilerGLSL compiler{src, len};
+static void introspectShader(VulkanEffect::Shader &shader, bool vertex) {
+    const spirv_cross::CompilerGLSL compiler{shader.code.data(), shader.code.size()};
     const auto resources = compiler.get_shader_resources();
 
     for (auto &buffer : resources.uniform_buffers) {
         const auto &name = compiler.get_name(buffer.id);
-        uniformBuffers_[name].binding = compiler.get_decoration(buffer.id, spv::DecorationBinding);
+        auto &uniformBuffer = shader.uniformBuffers[name];
+        uniformBuffer.binding = compiler.get_decoration(buffer.id, spv::DecorationBinding);
 
         u32 size = 0;
         const auto ranges = compiler.get_active_buffer_ranges(buffer.id);
@@ -84,25 +67,192 @@ void VulkanEffect::introspectShader(const u32 *src, u32 len, bool vertex) {
             auto memberName = compiler.get_member_name(buffer.base_type_id, range.index);
             if (memberName.empty())
                 memberName = compiler.get_member_qualified_name(buffer.base_type_id, range.index);
-            uniformBuffers_[name].members[memberName].size = range.range;
-            uniformBuffers_[name].members[memberName].offset = range.offset;
+            uniformBuffer.members[memberName].size = range.range;
+            uniformBuffer.members[memberName].offset = range.offset;
             size += range.range;
         }
 
-        uniformBuffers_[name].size = size;
+        uniformBuffer.size = size;
     }
 
     for (auto &sampler : resources.sampled_images) {
         const auto binding = compiler.get_decoration(sampler.id, spv::DecorationBinding);
-        samplers_[sampler.name].binding = binding;
+        shader.samplers[sampler.name].binding = binding;
     }
 
     if (vertex) {
         for (auto &stageInput : resources.stage_inputs) {
-            const auto name = stageInput.name;
             const auto location = compiler.get_decoration(stageInput.id, spv::DecorationLocation);
-            vertexAttributes_[name].location = location;
+            shader.vertexAttributes[stageInput.name].location = location;
+        }
+    }
+}
+
+static auto shaderCacheKey(const void *src, u32 srcLen, bool vertex) -> u64 {
+    // Everything that affects the compiler output must go into the key. Bump the version
+    // when changing compile options or the layout written by serializeShader().
+    auto key = hashString("vulkan-spv:1:default-options");
+    key = hashString(vertex ? "vertex" : "fragment", key);
+    return hashBytes(src, srcLen, key);
+}
+
+static auto serializeShader(const VulkanEffect::Shader &shader) -> vec<u8> {
+    BinaryWriter writer;
+
+    writer.write(static_cast<u32>(shader.code.size()));
+    writer.write(shader.code.data(), shader.code.size() * sizeof(u32));
+
+    writer.write(static_cast<u32>(shader.uniformBuffers.size()));
+    for (const auto &buffer : shader.uniformBuffers) {
+        writer.writeString(buffer.first);
+        writer.write(buffer.second.binding);
+        writer.write(buffer.second.size);
+        writer.write(static_cast<u32>(buffer.second.members.size()));
+        for (const auto &member : buffer.second.members) {
+            writer.writeString(member.first);
+            writer.write(member.second.offset);
+            writer.write(member.second.size);
+        }
+    }
+
+    writer.write(static_cast<u32>(shader.samplers.size()));
+    for (const auto &sampler : shader.samplers) {
+        writer.writeString(sampler.first);
+        writer.write(sampler.second.binding);
+    }
+
+    writer.write(static_cast<u32>(shader.vertexAttributes.size()));
+    for (const auto &attr : shader.vertexAttributes) {
+        writer.writeString(attr.first);
+        writer.write(attr.second.location);
+    }
+
+    return writer.data();
+}
+
+static bool deserializeShader(const vec<u8> &data, VulkanEffect::Shader &shader) {
+    BinaryReader reader{data.data(), data.size()};
+
+    const auto codeSize = reader.read<u32>();
+    if (!reader.isOk() || codeSize > data.size() / sizeof(u32))
+        return false;
+    shader.code.resize(codeSize);
+    reader.read(shader.code.data(), codeSize * sizeof(u32));
+
+    const auto bufferCount = reader.read<u32>();
+    for (u32 i = 0; i < bufferCount && reader.isOk(); i++) {
+        auto &buffer = shader.uniformBuffers[reader.readString()];
+        buffer.binding = reader.read<u32>();
+        buffer.size = reader.read<u32>();
+        const auto memberCount = reader.read<u32>();
+        for (u32 j = 0; j < memberCount && reader.isOk(); j++) {
+            auto &member = buffer.members[reader.readString()];
+            member.offset = reader.read<u32>();
+            member.size = reader.read<u32>();
+        }
+    }
+
+    const auto samplerCount = reader.read<u32>();
+    for (u32 i = 0; i < samplerCount && reader.isOk(); i++)
+        shader.samplers[reader.readString()].binding = reader.read<u32>();
+
+    const auto attrCount = reader.read<u32>();
+    for (u32 i = 0; i < attrCount && reader.isOk(); i++)
+        shader.vertexAttributes[reader.readString()].location = reader.read<u32>();
+
+    return reader.isOk() && reader.isAtEnd();
+}
+
+auto VulkanEffect::compileShader(Device *device, const void *src, u32 srcLen, bool vertex) -> Shader {
+    return compileShader(device->effectCache(), src, srcLen, vertex);
+}
+
+auto VulkanEffect::compileShader(EffectCache *cache, const void *src, u32 srcLen, bool vertex) -> Shader {
+    const auto cacheKey = shaderCacheKey(src, srcLen, vertex);
+
+    Shader shader;
+
+    vec<u8> cached;
+    if (cache->read(cacheKey, cached)) {
+        if (deserializeShader(cached, shader))
+            return shader;
+        shader = Shader();
+    }
+
+    const auto compilationResult = compileToSpv(src, srcLen, "<memory>", vertex);
+    shader.code.assign(compilationResult.begin(), compilationResult.end());
+    introspectShader(shader, vertex);
+
+    cache->write(cacheKey, serializeShader(shader));
+
+    return shader;
+}
+
+auto VulkanEffect::fromSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
+-> sptr<VulkanEffect> {
+    const auto vs = compileShader(device, vsSrc, vsSrcLen, true);
+    const auto fs = compileShader(device, fsSrc, fsSrcLen, false);
+    return std::make_shared<VulkanEffect>(device, vs, fs);
+}
+
+VulkanEffect::VulkanEffect(Device *device, const Shader &vs, const Shader &fs) {
+    renderer_ = dynamic_cast<VulkanRenderer *>(device->renderer());
+    vs_ = createShaderModule(renderer_->device(), vs.code.data(), static_cast<u32>(vs.code.size() * sizeof(u32)));
+    fs_ = createShaderModule(renderer_->device(), fs.code.data(), static_cast<u32>(fs.code.size() * sizeof(u32)));
+    addShaderInfo(vs);
+    addShaderInfo(fs);
+    registerParameters();
+}
+
+void VulkanEffect::swapContents(Effect &other) {
+    Effect::swapContents(other);
+
+    auto &effect = static_cast<VulkanEffect &>(other);
+    std::swap(vs_, effect.vs_);
+    std::swap(fs_, effect.fs_);
+    std::swap(uniformBuffers_, effect.uniformBuffers_);
+    std::swap(samplers_, effect.samplers_);
+    std::swap(vertexAttributes_, effect.vertexAttributes_);
+    std::swap(blockBuffers_, effect.blockBuffers_);
+    std::swap(parameters_, effect.parameters_);
+}
+
+void VulkanEffect::addShaderInfo(const Shader &shader) {
+    for (const auto &pair : shader.uniformBuffers) {
+        auto &buffer = uniformBuffers_[pair.first];
+        buffer.binding = pair.second.binding;
+        buffer.size = pair.second.size;
+        for (const auto &member : pair.second.members)
+            buffer.members[member.first] = member.second;
+    }
+
+    for (const auto &pair : shader.samplers)
+        samplers_[pair.first] = pair.second;
+
+    for (const auto &pair : shader.vertexAttributes)
+        vertexAttributes_[pair.first] = pair.second;
+}
+
+void VulkanEffect::registerParameters() {
+    // Buffers are placed in the block one after another, keeping the layout of each so that
+    // a whole buffer can be uploaded with a single copy
+    u32 blockOffset = 0;
+    for (const auto &pair : uniformBuffers_) {
+        blockBuffers_.push_back({pair.first, blockOffset, pair.second.size, pair.second.binding});
+        for (const auto &member : pair.second.members) {
+            addParameter(pair.first + ":" + member.first, blockOffset + member.second.offset, member.second.size);
+            parameters_.push_back(Parameter());
         }
+        blockOffset += (pair.second.size + 15) & ~15u;
+    }
+    reserveParameterBlock(blockOffset);
+
+    for (const auto &pair : samplers_) {
+        addParameter(pair.first, 0, 0);
+        Parameter param;
+        param.sampler = true;
+        param.binding = pair.second.binding;
+        parameters_.push_back(param);
     }
 }
 
@@ -14,6 +14,7 @@
 
 namespace solo {
     class VulkanRenderer;
+    class EffectCache;
 
     class VulkanEffect final: public Effect {
     public:
@@ -36,10 +37,35 @@ namespace solo {
             u32 location;
         };
 
+        // Uniform buffer contents live in the material parameter block at blockOffset
+        struct BlockBuffer {
+            str name;
+            u32 blockOffset;
+            u32 size;
+            u32 binding;
+        };
+
+        struct Parameter {
+            bool sampler = false;
+            u32 binding = 0;
+        };
+
+        // SPIR-V of a single stage along with its introspection results
+        struct Shader {
+            vec<u32> code;
+            umap<str, UniformBuffer> uniformBuffers;
+            umap<str, Sampler> samplers;
+            umap<str, VertexAttribute> vertexAttributes;
+        };
+
         static auto fromSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
         -> sptr<VulkanEffect>;
 
-        VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen);
+        // Compiles and introspects a shader or fetches it from the device effect cache. Doesn't touch the GPU.
+        static auto compileShader(Device *device, const void *src, u32 srcLen, bool vertex) -> Shader;
+        static auto compileShader(EffectCache *cache, const void *src, u32 srcLen, bool vertex) -> Shader;
+
+        VulkanEffect(Device *device, const Shader &vs, const Shader &fs);
         ~VulkanEffect() = default;
 
         auto vsModule() const -> VkShaderModule {
@@ -72,6 +98,15 @@ namespace solo {
             return vertexAttributes_;
         }
 
+        auto blockBuffers() const -> vec<BlockBuffer> const & {
+            return blockBuffers_;
+        }
+        auto parameter(u32 handle) const -> Parameter const & {
+            return parameters_[handle];
+        }
+
+        void swapContents(Effect &other) override;
+
     private:
         VulkanRenderer *renderer_ = nullptr;
         VulkanResource<VkShaderModule> vs_;
@@ -80,8 +115,11 @@ namespace solo {
         umap<str, UniformBuffer> uniformBuffers_;
         umap<str, Sampler> samplers_;
         umap<str, VertexAttribute> vertexAttributes_;
+        vec<BlockBuffer> blockBuffers_;
+        vec<Parameter> parameters_;
 
-        void introspectShader(const u32 *src, u32 len, bool vertex);
+        void addShaderInfo(const Shader &shader);
+        void registerParameters();
     };
 }
 
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#include "SoloVulkanGeometryArena.h"
+
+#ifdef SL_VULKAN_RENDERER
+
+#include "SoloDevice.h"
+#include "SoloVulkanRenderer.h"
+#include "SoloVulkanCmdBuffer.h"
+
+using namespace solo;
+
+static auto toRegions(const vec<GeometryArena::Move> &moves, u32 elementSize) -> vec<VkBufferCopy> {
+    vec<VkBufferCopy> regions;
+    regions.reserve(moves.size());
+    for (const auto &move : moves) {
+        regions.push_back(VkBufferCopy{
+            static_cast<VkDeviceSize>(move.from) * elementSize,
+            static_cast<VkDeviceSize>(move.to) * elementSize,
+            static_cast<VkDeviceSize>(move.count) * elementSize
+        });
+    }
+    return regions;
+}
+
+// Pool buffers are both the source and the target of copies when compacting
+static auto createBuffer(const VulkanDriverDevice &dev, VkDeviceSize size, VkBufferUsageFlags usage) -> VulkanBuffer {
+    return VulkanBuffer(dev, size, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+VulkanGeometryArena::VulkanGeometryArena(Device *device) {
+    renderer_ = dynamic_cast<VulkanRenderer *>(device->renderer());
+}
+
+// May be called mid-frame, when a new mesh doesn't fit. The old buffers are kept until the next update()
+// (the renderer waits for the queue to idle at the end of each frame), so that already recorded draws stay valid.
+void VulkanGeometryArena::resizePool(u32 pool, u32 vertexCapacity, u32 indexCapacity,
+    const vec<Move> &vertexMoves, const vec<Move> &indexMoves) {
+    if (pool >= buffers_.size())
+        buffers_.resize(pool + 1);
+
+    const auto &dev = renderer_->device();
+    const auto vertexSize = poolLayout(pool).size();
+    const auto indexSize = static_cast<u32>(poolIndexElementSize(pool));
+    auto vertexBuffer = createBuffer(dev, static_cast<VkDeviceSize>(vertexCapacity) * vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    auto indexBuffer = createBuffer(dev, static_cast<VkDeviceSize>(indexCapacity) * indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    auto &buffers = buffers_[pool];
+    if (!vertexMoves.empty() || !indexMoves.empty()) {
+        const auto vertexRegions = toRegions(vertexMoves, vertexSize);
+        const auto indexRegions = toRegions(indexMoves, indexSize);
+        VulkanCmdBuffer cmdBuffer(dev);
+        cmdBuffer.begin(true);
+        if (!vertexRegions.empty())
+            cmdBuffer.copyBuffer(buffers.vertexBuffer, vertexBuffer, vertexRegions.data(), static_cast<u32>(vertexRegions.size()));
+        if (!indexRegions.empty())
+            cmdBuffer.copyBuffer(buffers.indexBuffer, indexBuffer, indexRegions.data(), static_cast<u32>(indexRegions.size()));
+        cmdBuffer.endAndFlush();
+    }
+
+    if (buffers.vertexBuffer.handle())
+        retiredBuffers_.push_back(PoolBuffers{std::move(buffers.vertexBuffer), std::move(buffers.indexBuffer)});
+    buffers.vertexBuffer = std::move(vertexBuffer);
+    buffers.indexBuffer = std::move(indexBuffer);
+}
+
+void VulkanGeometryArena::releaseRetiredBuffers() {
+    retiredBuffers_.clear();
+}
+
+void VulkanGeometryArena::upload(u32 pool, u32 firstVertex, const void *vertices, u32 vertexCount,
+    u32 firstIndex, const void *indices, u32 indexCount) {
+    const auto &dev = renderer_->device();
+    const auto &buffers = buffers_.at(pool);
+    const auto vertexBytes = static_cast<VkDeviceSize>(vertexCount) * poolLayout(pool).size();
+    const auto indexBytes = static_cast<VkDeviceSize>(indexCount) * static_cast<u32>(poolIndexElementSize(pool));
+    if (!vertexBytes && !indexBytes)
+        return;
+
+    // One staging buffer with the vertices followed by the indices
+    auto staging = VulkanBuffer::staging(dev, vertexBytes + indexBytes);
+    if (vertexBytes)
+        staging.updatePart(vertices, 0, static_cast<u32>(vertexBytes));
+    if (indexBytes)
+        staging.updatePart(indices, static_cast<u32>(vertexBytes), static_cast<u32>(indexBytes));
+
+    const VkBufferCopy vertexRegion{0, static_cast<VkDeviceSize>(firstVertex) * poolLayout(pool).size(), vertexBytes};
+    const VkBufferCopy indexRegion{vertexBytes, static_cast<VkDeviceSize>(firstIndex) * static_cast<u32>(poolIndexElementSize(pool)), indexBytes};
+
+    VulkanCmdBuffer cmdBuffer(dev);
+    cmdBuffer.begin(true);
+    if (vertexBytes)
+        cmdBuffer.copyBuffer(staging, buffers.vertexBuffer, &vertexRegion, 1);
+    if (indexBytes)
+        cmdBuffer.copyBuffer(staging, buffers.indexBuffer, &indexRegion, 1);
+    cmdBuffer.endAndFlush();
+}
+
+#endif
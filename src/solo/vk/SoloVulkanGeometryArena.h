@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_VULKAN_RENDERER
+
+#include "SoloGeometryArena.h"
+#include "SoloVulkanBuffer.h"
+
+namespace solo {
+    class VulkanRenderer;
+
+    class VulkanGeometryArena final : public GeometryArena {
+    public:
+        explicit VulkanGeometryArena(Device *device);
+        ~VulkanGeometryArena() = default;
+
+        auto vertexBuffer(u32 pool) const -> VkBuffer {
+            return buffers_.at(pool).vertexBuffer.handle();
+        }
+        auto indexBuffer(u32 pool) const -> VkBuffer {
+            return buffers_.at(pool).indexBuffer.handle();
+        }
+
+    protected:
+        void resizePool(u32 pool, u32 vertexCapacity, u32 indexCapacity,
+            const vec<Move> &vertexMoves, const vec<Move> &indexMoves) override;
+        void upload(u32 pool, u32 firstVertex, const void *vertices, u32 vertexCount,
+            u32 firstIndex, const void *indices, u32 indexCount) override;
+        void releaseRetiredBuffers() override;
+
+    private:
+        struct PoolBuffers {
+            VulkanBuffer vertexBuffer;
+            VulkanBuffer indexBuffer;
+        };
+
+        VulkanRenderer *renderer_ = nullptr;
+        vec<PoolBuffers> buffers_;
+        // Replaced mid-frame, commands recorded for the frame may still use them
+        vec<PoolBuffers> retiredBuffers_;
+    };
+}
+
+#endif
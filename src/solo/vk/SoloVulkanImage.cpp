@@ -133,6 +133,9 @@ auto VulkanImage::fromData(const VulkanDriverDevice &dev, Texture2DData *data, b
     "Image format/features not supported"
            );
 
+    if (generateMipmaps && data->mipLevelCount() > 1)
+        return fromMipChain(dev, data, format, usage);
+
     u32 mipLevels = 1;
     if (generateMipmaps) {
         panicIf(!dev.isFormatSupported(format, VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT),
@@ -276,6 +279,71 @@ auto VulkanImage::fromData(const VulkanDriverDevice &dev, Texture2DData *data, b
     return image;
 }
 
+// Mip levels that come with the data (cooked textures) are copied in one go instead of being blitted
+auto VulkanImage::fromMipChain(const VulkanDriverDevice &dev, Texture2DData *data, VkFormat format, VkImageUsageFlags usage) -> VulkanImage {
+    const auto width = static_cast<u32>(data->dimensions().x());
+    const auto height = static_cast<u32>(data->dimensions().y());
+    const auto mipLevels = data->mipLevelCount();
+    const auto layout = VK_IMAGE_LAYOUT_GENERAL;
+
+    auto image = VulkanImage(dev, width, height, mipLevels, 1, format, layout, 0, usage,
+    VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    VkImageSubresourceRange range{};
+    range.aspectMask = image.aspectMask_;
+    range.baseArrayLayer = 0;
+    range.baseMipLevel = 0;
+    range.levelCount = mipLevels;
+    range.layerCount = 1;
+
+    // Buffer offsets must be multiples of 4 and of the texel size
+    const auto alignOffset = [](u32 offset) {
+        return (offset + 15) & ~15u;
+    };
+
+    u32 bufferSize = 0;
+    for (u32 level = 0; level < mipLevels; level++)
+        bufferSize = alignOffset(bufferSize) + data->mipLevelSize(level);
+
+    const auto srcBuf = VulkanBuffer::staging(dev, bufferSize);
+
+    vec<VkBufferImageCopy> regions;
+    u32 offset = 0;
+    for (u32 level = 0; level < mipLevels; level++) {
+        offset = alignOffset(offset);
+        srcBuf.updatePart(data->mipLevelData(level), offset, data->mipLevelSize(level));
+
+        const auto dimensions = data->mipLevelDimensions(level);
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent.width = static_cast<u32>(dimensions.x());
+        region.imageExtent.height = static_cast<u32>(dimensions.y());
+        region.imageExtent.depth = 1;
+        region.bufferOffset = offset;
+        regions.push_back(region);
+
+        offset += data->mipLevelSize(level);
+    }
+
+    VulkanCmdBuffer(dev)
+    .begin(true)
+    .putImagePipelineBarrier(
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        vk::makeImagePipelineBarrier(image.image_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range))
+    .copyBuffer(srcBuf, image, regions.data(), static_cast<u32>(regions.size()))
+    .putImagePipelineBarrier(
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        vk::makeImagePipelineBarrier(image.image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, range))
+    .endAndFlush();
+
+    return image;
+}
+
 auto VulkanImage::fromCubeData(const VulkanDriverDevice &dev, CubeTextureData *data) -> VulkanImage {
     const u32 mipLevels = 1; // TODO proper support
     const auto layers = 6;
@@ -73,6 +73,8 @@ namespace solo {
 
         VulkanImage(const VulkanDriverDevice &dev, u32 width, u32 height, u32 mipLevels, u32 layers, VkFormat format, VkImageLayout layout,
                     VkImageCreateFlags createFlags, VkImageUsageFlags usageFlags, VkImageViewType viewType, VkImageAspectFlags aspectMask);
+
+        static auto fromMipChain(const VulkanDriverDevice &dev, Texture2DData *data, VkFormat format, VkImageUsageFlags usage) -> VulkanImage;
     };
 }
 
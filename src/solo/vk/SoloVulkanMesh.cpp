@@ -10,6 +10,7 @@
 #include "SoloDevice.h"
 #include "SoloHash.h"
 #include "SoloVulkanRenderer.h"
+#include "SoloVulkanGeometryArena.h"
 #include <algorithm>
 
 using namespace solo;
@@ -18,37 +19,52 @@ VulkanMesh::VulkanMesh(Device *device) {
     renderer_ = dynamic_cast<VulkanRenderer *>(device->renderer());
 }
 
-auto VulkanMesh::addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
-    vertexBuffers_.push_back(VulkanBuffer::deviceLocal(renderer_->device(), layout.size() * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data.data()));
-    return Mesh::addVertexBuffer(layout, data, vertexCount);
+void VulkanMesh::uploadVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) {
+    const auto size = layout.size() * vertexCount;
+    vertexBuffers_.push_back(dynamic
+        ? VulkanBuffer::hostVisible(renderer_->device(), size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data)
+        : VulkanBuffer::deviceLocal(renderer_->device(), size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data));
 }
 
-auto VulkanMesh::addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 {
-    vertexBuffers_.push_back(VulkanBuffer::hostVisible(renderer_->device(), layout.size() * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data.data()));
-    return Mesh::addDynamicVertexBuffer(layout, data, vertexCount);
-}
-
-void VulkanMesh::updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) {
+void VulkanMesh::uploadVertexBufferPart(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) {
     const auto vertexSize = layouts_[index].size();
     vertexBuffers_[index].updatePart(data, vertexOffset * vertexSize, vertexCount * vertexSize);
-    Mesh::updateVertexBuffer(index, vertexOffset, data, vertexCount);
 }
 
-void VulkanMesh::removeVertexBuffer(u32 index) {
+void VulkanMesh::destroyVertexBuffer(u32 index) {
     vertexBuffers_.erase(vertexBuffers_.begin() + index);
-    Mesh::removeVertexBuffer(index);
 }
 
-auto VulkanMesh::addIndexBuffer(const vec<u32> &data, u32 elementCount) -> u32 {
-    const auto size = static_cast<VkDeviceSize>(IndexElementSize::Bits32) * elementCount; // TODO 16-bit support?
-    auto buf = VulkanBuffer::deviceLocal(renderer_->device(), size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, data.data());
-    indexBuffers_.push_back(std::move(buf));
-    return Mesh::addIndexBuffer(data, elementCount);
+void VulkanMesh::uploadIndexBuffer(const void *data, u32 indexCount) {
+    if (!indexCount) {
+        indexBuffer_ = VulkanBuffer();
+        return;
+    }
+
+    const auto size = static_cast<VkDeviceSize>(indexElementSize_) * indexCount;
+    indexBuffer_ = VulkanBuffer::deviceLocal(renderer_->device(), size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, data);
+}
+
+void VulkanMesh::swapContents(Mesh &other) {
+    Mesh::swapContents(other);
+
+    auto &mesh = static_cast<VulkanMesh &>(other);
+    std::swap(vertexBuffers_, mesh.vertexBuffers_);
+    std::swap(indexBuffer_, mesh.indexBuffer_);
+}
+
+auto VulkanMesh::vertexBuffer(u32 index) const -> VkBuffer {
+    if (arenaAllocation_) {
+        panicIf(index != 0, "Meshes in the geometry arena have one vertex buffer");
+        return static_cast<VulkanGeometryArena *>(arenaAllocation_->arena())->vertexBuffer(arenaAllocation_->pool());
+    }
+    return vertexBuffers_.at(index).handle();
 }
 
-void VulkanMesh::removeIndexBuffer(u32 index) {
-    indexBuffers_.erase(indexBuffers_.begin() + index);
-    Mesh::removeIndexBuffer(index);
+auto VulkanMesh::indexBuffer() const -> VkBuffer {
+    if (arenaAllocation_)
+        return static_cast<VulkanGeometryArena *>(arenaAllocation_->arena())->indexBuffer(arenaAllocation_->pool());
+    return indexBuffer_.handle();
 }
 
 auto VulkanMesh::layoutHash() const -> size_t {
@@ -67,6 +83,7 @@ auto VulkanMesh::layoutHash() const -> size_t {
             combineHash(seed, unsignedHasher(attr.elementCount));
             combineHash(seed, unsignedHasher(attr.offset));
             combineHash(seed, unsignedHasher(attr.size));
+            combineHash(seed, unsignedHasher(static_cast<u32>(attr.format)));
         }
     }
 
@@ -21,19 +21,11 @@ namespace solo {
         explicit VulkanMesh(Device *device);
         ~VulkanMesh() = default;
 
-        auto addVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 override;
-        auto addDynamicVertexBuffer(const VertexBufferLayout &layout, const vec<float> &data, u32 vertexCount) -> u32 override;
-        void updateVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) override;
-        void removeVertexBuffer(u32 index) override;
-        auto vertexBuffer(u32 index) const -> VkBuffer {
-            return vertexBuffers_.at(index).handle();
-        }
+        auto vertexBuffer(u32 index) const -> VkBuffer;
+        auto indexBuffer() const -> VkBuffer;
 
-        auto addIndexBuffer(const vec<u32> &data, u32 elementCount) -> u32 override;
-        void removeIndexBuffer(u32 index) override;
-        auto indexBuffer(u32 index) const -> VkBuffer {
-            return indexBuffers_.at(index).handle();
-        }
+        using Mesh::firstVertex;
+        using Mesh::firstIndex;
 
         auto minVertexCount() const -> u32 {
             return minVertexCount_;
@@ -41,11 +33,19 @@ namespace solo {
 
         auto layoutHash() const -> size_t;
 
+        void swapContents(Mesh &other) override;
+
+    protected:
+        void uploadVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) override;
+        void uploadVertexBufferPart(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) override;
+        void destroyVertexBuffer(u32 index) override;
+        void uploadIndexBuffer(const void *data, u32 indexCount) override;
+
     private:
         VulkanRenderer *renderer_ = nullptr;
 
         vec<VulkanBuffer> vertexBuffers_;
-        vec<VulkanBuffer> indexBuffers_;
+        VulkanBuffer indexBuffer_;
     };
 }
 
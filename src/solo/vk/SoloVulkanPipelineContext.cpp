@@ -17,20 +17,24 @@
 
 using namespace solo;
 
+// Compact formats are padded to 2 or 4 components by the layout, the ones in between aren't
+// required to be supported for vertex buffers
 static auto toVertexFormat(const VertexAttribute &attr) -> VkFormat {
-    switch (attr.elementCount) {
-        case 1:
-            return VK_FORMAT_R32_SFLOAT;
-        case 2:
-            return VK_FORMAT_R32G32_SFLOAT;
-        case 3:
-            return VK_FORMAT_R32G32B32_SFLOAT;
-        case 4:
-            return VK_FORMAT_R32G32B32A32_SFLOAT;
-        default:
-            panic("Unsupported vertex attribute element count");
-            return VK_FORMAT_UNDEFINED;
-    }
+    static const umap<VertexAttributeFormat, arr<VkFormat, 4>> formats = {
+        {VertexAttributeFormat::Float, {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT}},
+        {VertexAttributeFormat::Half, {VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16B16A16_SFLOAT}},
+        {VertexAttributeFormat::SNorm16, {VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16_SNORM, VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16B16A16_SNORM}},
+        {VertexAttributeFormat::Octahedral, {VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16_SNORM, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED}},
+        {VertexAttributeFormat::UNorm16, {VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16_UNORM, VK_FORMAT_UNDEFINED, VK_FORMAT_R16G16B16A16_UNORM}},
+        {VertexAttributeFormat::SNorm8, {VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_R8G8B8A8_SNORM}},
+        {VertexAttributeFormat::UNorm8, {VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_R8G8B8A8_UNORM}},
+    };
+
+    const auto format = attr.componentCount >= 1 && attr.componentCount <= 4
+        ? formats.at(attr.format)[attr.componentCount - 1]
+        : VK_FORMAT_UNDEFINED;
+    panicIf(format == VK_FORMAT_UNDEFINED, "Unsupported vertex attribute format");
+    return format;
 }
 
 static auto toBlendFactor(BlendFactor factor) -> VkBlendFactor {
@@ -171,16 +175,15 @@ VulkanPipelineContext::VulkanPipelineContext(VulkanPipelineContext &&other) noex
 }
 
 void VulkanPipelineContext::update(VulkanMaterial *material, VulkanMesh *mesh, VulkanRenderPass *renderPass,
-                                   Camera *camera, Transform *transform) {
+                                   Camera *camera, Transform *transform, ObjectMatrixCache *matrixCache) {
     const auto effect = dynamic_cast<VulkanEffect *>(material->effect().get());
 
     if (!descSet_) {
         VulkanDescriptorSetConfig cfg;
 
-        for (const auto &pair : effect->uniformBuffers()) {
-            const auto bufferName = pair.first;
-            uniformBuffers_[bufferName] = VulkanBuffer::uniformHostVisible(*device_, pair.second.size);
-            cfg.addUniformBuffer(pair.second.binding);
+        for (const auto &buffer : effect->blockBuffers()) {
+            uniformBuffers_.push_back(VulkanBuffer::uniformHostVisible(*device_, buffer.size));
+            cfg.addUniformBuffer(buffer.binding);
         }
 
         for (const auto &pair : effect->samplers())
@@ -209,25 +212,13 @@ void VulkanPipelineContext::update(VulkanMaterial *material, VulkanMesh *mesh, V
     // TODO Run set updater not so often - only when something really changes
 
     // TODO Not necessary (?), buffers don't change anyway, only their content
-    for (auto &pair : uniformBuffers_) {
-        const auto &info = effect->uniformBuffers().at(pair.first);
-        descSet_.updateUniformBuffer(info.binding, pair.second, 0, info.size); // TODO use single large buffer?
+    for (u32 i = 0; i < uniformBuffers_.size(); i++) {
+        const auto &buffer = effect->blockBuffers()[i];
+        descSet_.updateUniformBuffer(buffer.binding, uniformBuffers_[i], 0, buffer.size); // TODO use single large buffer?
     }
 
-    for (const auto &pair : material->samplers()) {
-        const auto &info = pair.second;
-        descSet_.updateSampler(
-            info.binding,
-            info.texture->image().view(),
-            info.texture->sampler(),
-            info.texture->image().layout());
-    }
-
-    for (const auto &p : material->bufferItems()) {
-        auto &buffer = uniformBuffers_[p.first];
-        for (const auto &pp : p.second)
-            pp.second.write(buffer, camera, transform);
-    }
+    material->writeSamplers(descSet_);
+    material->writeUniformBuffers(uniformBuffers_, camera, transform, matrixCache);
 }
 
 #endif
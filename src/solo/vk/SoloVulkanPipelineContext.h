@@ -19,6 +19,7 @@ namespace solo {
     class VulkanRenderPass;
     class Camera;
     class Transform;
+    class ObjectMatrixCache;
 
     class VulkanPipelineContext {
     public:
@@ -48,11 +49,11 @@ namespace solo {
         }
 
         void update(VulkanMaterial *material, VulkanMesh *mesh, VulkanRenderPass *renderPass,
-                    Camera *camera, Transform *transform);
+                    Camera *camera, Transform *transform, ObjectMatrixCache *matrixCache);
 
     private:
         VulkanDriverDevice *device_ = nullptr;
-        umap<str, VulkanBuffer> uniformBuffers_;
+        vec<VulkanBuffer> uniformBuffers_;
         VulkanPipeline pipeline_;
         VulkanDescriptorSet descSet_;
         size_t lastMaterialStateHash_ = 0;
@@ -16,14 +16,17 @@
 #include "SoloCamera.h"
 #include "SoloVulkanPipelineContext.h"
 #include "SoloVulkanDebugInterface.h"
+#include <algorithm>
 
 using namespace solo;
 
+// Pipelines and descriptor sets are built for one version of the effect
 static auto contextKey(Transform *transform, Camera *camera, VulkanMaterial *material, VkRenderPass renderPass) {
     size_t seed = 0;
     const std::hash<void *> hasher;
     combineHash(seed, hasher(transform));
     combineHash(seed, hasher(material));
+    combineHash(seed, std::hash<u64>()(material->effect()->revision()));
     combineHash(seed, hasher(camera));
     combineHash(seed, hasher(renderPass));
     return seed;
@@ -72,6 +75,8 @@ void VulkanRenderer::beginCamera(Camera *camera) {
 
     context_.cmdBuffer = &passContext.cmdBuf;
     context_.cmdBuffer->begin(false);
+    context_.boundVertexBuffers.clear();
+    context_.boundIndexBuffer = VK_NULL_HANDLE;
 
     context_.cmdBuffer->beginRenderPass(*context_.renderPass, currentFrameBuffer,
                                         static_cast<u32>(dimensions.x()), static_cast<u32>(dimensions.y()));
@@ -109,7 +114,7 @@ void VulkanRenderer::renderMesh(Mesh *mesh, Transform *transform, Material *mate
 
     bindPipelineAndMesh(material, transform, mesh);
 
-    context_.cmdBuffer->draw(vkMesh->minVertexCount(), 1, 0, 0);
+    context_.cmdBuffer->draw(vkMesh->minVertexCount(), 1, vkMesh->firstVertex(), 0);
 }
 
 void VulkanRenderer::renderMeshIndex(Mesh *mesh, u32 index, Transform *transform, Material *material) {
@@ -117,10 +122,9 @@ void VulkanRenderer::renderMeshIndex(Mesh *mesh, u32 index, Transform *transform
 
     bindPipelineAndMesh(material, transform, mesh);
 
-    const auto indexBuffer = vkMesh->indexBuffer(index);
-    const auto indexType = toIndexType(mesh->indexBufferElementSize(index));
-    context_.cmdBuffer->bindIndexBuffer(indexBuffer, 0, indexType);
-    context_.cmdBuffer->drawIndexed(vkMesh->indexBufferElementCount(index), 1, 0, 0, 0);
+    const auto part = vkMesh->part(index);
+    context_.cmdBuffer->drawIndexed(part.indexCount, 1, vkMesh->firstIndex() + part.indexOffset,
+        vkMesh->firstVertex() + part.baseVertex, 0);
 }
 
 void VulkanRenderer::renderDebugInterface(DebugInterface *debugInterface) {
@@ -130,6 +134,7 @@ void VulkanRenderer::renderDebugInterface(DebugInterface *debugInterface) {
 void VulkanRenderer::bindPipelineAndMesh(Material *material, Transform *transform, Mesh *mesh) {
     const auto vkMaterial = dynamic_cast<VulkanMaterial *>(material);
     const auto vkMesh = dynamic_cast<VulkanMesh *>(mesh);
+    vkMaterial->syncWithEffect(vkMaterial->effect().get());
 
     const auto key = contextKey(transform, context_.camera, vkMaterial, context_.renderPass->handle());
     if (!pipelineContexts_.count(key))
@@ -139,15 +144,28 @@ void VulkanRenderer::bindPipelineAndMesh(Material *material, Transform *transfor
     context.setFrameOfLastUse(frameNr_);
 
     if (context_.pipelineContextKey != context.key()) {
-        context.update(vkMaterial, vkMesh, context_.renderPass, context_.camera, transform);
+        context.update(vkMaterial, vkMesh, context_.renderPass, context_.camera, transform, &matrixCache_);
         context_.cmdBuffer->bindPipeline(context.pipeline());
         context_.cmdBuffer->bindDescriptorSet(context.pipeline().layout(), context.descriptorSet());
         context_.pipelineContextKey = context.key();
     }
 
-    // TODO don't rebind an already bound mesh (for instance when we render mesh indexes)
-    for (u32 i = 0; i < vkMesh->vertexBufferCount(); i++)
-        context_.cmdBuffer->bindVertexBuffer(i, vkMesh->vertexBuffer(i));
+    // Parts of a mesh, and meshes in the same geometry arena pool, only differ in draw parameters
+    auto &bound = context_.boundVertexBuffers;
+    for (u32 i = 0; i < vkMesh->vertexBufferCount(); i++) {
+        const auto buffer = vkMesh->vertexBuffer(i);
+        if (i >= bound.size() || bound[i] != buffer) {
+            context_.cmdBuffer->bindVertexBuffer(i, buffer);
+            bound.resize((std::max)(bound.size(), static_cast<size_t>(i + 1)));
+            bound[i] = buffer;
+        }
+    }
+    // Index buffers are either of one size or belong to different pools, so the buffer determines the index type
+    const auto indexBuffer = vkMesh->indexBuffer();
+    if (indexBuffer != VK_NULL_HANDLE && indexBuffer != context_.boundIndexBuffer) {
+        context_.cmdBuffer->bindIndexBuffer(indexBuffer, 0, toIndexType(vkMesh->indexElementSize()));
+        context_.boundIndexBuffer = indexBuffer;
+    }
 }
 
 void VulkanRenderer::beginFrame() {
@@ -156,6 +174,8 @@ void VulkanRenderer::beginFrame() {
     context_.renderPass = nullptr;
     context_.cmdBuffer = nullptr;
     context_.pipelineContextKey = 0;
+    context_.boundVertexBuffers.clear();
+    context_.boundIndexBuffer = VK_NULL_HANDLE;
     context_.debugInterface.instance = nullptr;
     context_.waitSemaphore = swapchain_.moveNext();
 }
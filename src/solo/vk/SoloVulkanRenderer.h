@@ -67,6 +67,8 @@ namespace solo {
             VulkanCmdBuffer *cmdBuffer = nullptr;
             VkSemaphore waitSemaphore = nullptr;
             size_t pipelineContextKey = 0;
+            vec<VkBuffer> boundVertexBuffers;
+            VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
 
             struct {
                 VulkanDebugInterface *instance = nullptr;
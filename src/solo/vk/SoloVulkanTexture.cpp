@@ -111,6 +111,16 @@ VulkanTexture2D::VulkanTexture2D(Device *device, TextureFormat format, Vector2 d
     VulkanTexture(device) {
 }
 
+// Samplers depend on the mip level count of the image
+void VulkanTexture2D::swapContents(Texture2D &other) {
+    Texture2D::swapContents(other);
+
+    auto &texture = static_cast<VulkanTexture2D &>(other);
+    std::swap(image_, texture.image_);
+    rebuildSampler();
+    texture.rebuildSampler();
+}
+
 void VulkanTexture2D::rebuild() {
     Texture2D::rebuild();
     rebuildSampler();
@@ -38,6 +38,8 @@ namespace solo {
         static auto fromData(Device *device, sptr<Texture2DData> data, bool generateMipmaps) -> sptr<VulkanTexture2D>;
         static auto empty(Device *device, u32 width, u32 height, TextureFormat format) -> sptr<VulkanTexture2D>;
 
+        void swapContents(Texture2D &other) override;
+
     protected:
         VulkanTexture2D(Device *device, TextureFormat format, Vector2 dimensions);
         void rebuild() override final;